@@ -191,7 +191,11 @@ namespace goptical {
         /** Hexapolar pattern, suitable for circular shapes */
         HexaPolarDist,
         /** Random distribution */
-        RandomDist
+        RandomDist,
+        /** Scrambled Sobol low discrepancy distribution */
+        SobolDist,
+        /** Scrambled Halton low discrepancy distribution */
+        HaltonDist
       };
 
     /** Specifies light intensity calculation mode to use by light propagation algorithms. */
@@ -217,6 +221,26 @@ namespace goptical {
         MixedPropagation
       };
 
+    /** Specifies floating point precision used by sequential ray
+        tracing to find rays intersections with surfaces */
+    enum PrecisionMode
+      {
+        /** All computations are performed in double precision */
+        DoublePrecision,
+        /** Curves intersections are computed in single precision.
+           Rays are transformed to surface local coordinates and
+           their origins moved near the surface in double precision
+           before conversion. Normals, refraction, intensities and
+           rays data stored in results are computed in double
+           precision. Intersection points error is a few single
+           precision ulps of local coordinates magnitude, rays
+           grazing a surface edge may be stopped differently. */
+        MixedPrecision,
+        /** Trace in double precision and compare intersections with
+           the single precision path, see @ref Result::get_precision_error */
+        CheckPrecision
+      };
+
   }
 
   namespace material {
@@ -484,6 +508,7 @@ namespace _goptical {
     class Source;
     class SourcePoint;
     class SourcePointInfinity;
+    class SourceRayFile;
     class Surface;
   }
 
@@ -492,15 +517,22 @@ namespace _goptical {
   namespace trace {
     using namespace goptical::trace;
 
+    class AsyncTrace;
     class Distribution;
     class tracer;
     class Params;
+    class Plan;
     class Ray;
+    class RayArena;
+    class RayBuffer;
+    class RayPacket;
     class Result;
     class Element;
     class Sequence;
+    class SpectralTable;
+    class ThreadPool;
 
-    typedef std::deque<Ray *> rays_queue_t;
+    typedef RayBuffer rays_queue_t;
 
   }
 
@@ -626,5 +658,19 @@ namespace _goptical {
 
 }
 
+namespace dpp {
+
+  // model objects may be shared by tracers and analysis running in
+  // different threads, use atomic references counting for them
+
+  template <> struct ref_atomic<_goptical::sys::system> { static const bool value = true; };
+  template <> struct ref_atomic<_goptical::sys::Element> { static const bool value = true; };
+  template <> struct ref_atomic<_goptical::trace::Sequence> { static const bool value = true; };
+  template <> struct ref_atomic<_goptical::curve::Base> { static const bool value = true; };
+  template <> struct ref_atomic<_goptical::shape::Base> { static const bool value = true; };
+  template <> struct ref_atomic<_goptical::material::Base> { static const bool value = true; };
+
+}
+
 #endif
 
@@ -61,6 +61,8 @@ namespace _goptical {
       double sagitta(const math::Vector2 & xy) const;
       /** @override */
       void derivative(const math::Vector2 & xy, math::Vector2 & dxdy) const;
+      /** @override */
+      void freeze() const;
 
     private:
 
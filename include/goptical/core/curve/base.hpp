@@ -65,8 +65,49 @@ namespace _goptical {
           false if no intersection occurred */
       virtual bool intersect(math::Vector3 &point, const math::VectorPair3 &ray) const;
 
+      /** Get intersection points between curve and an array of 3d
+          rays. Rays origins, directions and intersection points are
+          stored as separate arrays of x, y and z components. The @tt
+          hit array is set for each ray which intersects the curve,
+          points of other rays are left undefined.
+
+          Default implementation calls @ref intersect for each
+          ray. Subclasses which reimplement @ref intersect must
+          reimplement this function too. */
+      virtual void intersect_batch(unsigned int count,
+                                   const double *const origin[3],
+                                   const double *const direction[3],
+                                   double *const point[3], bool hit[]) const;
+
+      /** Single precision version of @ref intersect_batch. Default
+          implementation calls @ref intersect for each ray. */
+      virtual void intersect_batch(unsigned int count,
+                                   const float *const origin[3],
+                                   const float *const direction[3],
+                                   float *const point[3], bool hit[]) const;
+
       /** Get normal to curve surface at specified point */
       virtual void normal(math::Vector3 &normal, const math::Vector3 &point) const;
+
+      /** Compute lazily updated data so that later calls to const
+          member functions do not modify the curve. Must be
+          reimplemented by curves which update internal data on
+          first use. @see sys::system::freeze */
+      virtual void freeze() const;
+
+      /** Get curve version. Version changes each time the curve is
+          modified, it is used to invalidate data computed from the
+          curve. */
+      virtual inline unsigned int get_version() const;
+
+    protected:
+      inline Base();
+
+      /** Must be called by functions which modify the curve */
+      inline void update_version();
+
+    private:
+      unsigned int _version;
     };
 
   }
@@ -30,10 +30,25 @@ namespace _goptical {
 
   namespace curve {
 
+    Base::Base()
+      : _version(0)
+    {
+    }
+
     Base::~Base()
     {
     }
 
+    unsigned int Base::get_version() const
+    {
+      return _version;
+    }
+
+    void Base::update_version()
+    {
+      _version++;
+    }
+
   }
 }
 
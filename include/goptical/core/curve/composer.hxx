@@ -36,6 +36,7 @@ namespace _goptical {
     Composer::Attributes & Composer::Attributes::z_scale(double zfactor)
     {
       _z_scale *= zfactor;
+      _version++;
 
       return *this;
     }
@@ -43,6 +44,7 @@ namespace _goptical {
     Composer::Attributes & Composer::Attributes::z_offset(double zoffset)
     {
       _z_offset += zoffset;
+      _version++;
 
       return *this;
     }
@@ -51,6 +53,7 @@ namespace _goptical {
     {
       _transform.affine_scaling(factor);
       _inv_transform = _transform.inverse();
+      _version++;
 
       return *this;
     }
@@ -59,6 +62,7 @@ namespace _goptical {
     {
       _transform.affine_rotation(0, angle);
       _inv_transform = _transform.inverse();
+      _version++;
 
       return *this;
     }
@@ -67,6 +71,7 @@ namespace _goptical {
     {
       _transform.apply_translation(offset);
       _inv_transform = _transform.inverse();
+      _version++;
 
       return *this;
     }
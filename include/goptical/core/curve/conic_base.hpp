@@ -72,6 +72,9 @@ namespace _goptical {
       virtual double sagitta(double r) const = 0;
       virtual double derivative(double r) const = 0;
 
+      /** @override */
+      inline unsigned int get_version() const;
+
     protected:
       inline ConicBase(double roc, double sc);
 
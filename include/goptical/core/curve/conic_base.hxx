@@ -48,6 +48,11 @@ namespace _goptical {
       return _sh - 1.0;
     }
 
+    unsigned int ConicBase::get_version() const
+    {
+      return Rotational::get_version() + _roc_version;
+    }
+
   }
 }
 #endif
@@ -50,6 +50,9 @@ namespace _goptical {
       inline curveRoc(double roc);
 
       double _roc;
+      /** incremented on radius of curvature change, must be added to
+          curve version by derived classes */
+      unsigned int _roc_version;
     };
 
   }
@@ -31,13 +31,15 @@ namespace _goptical {
   namespace curve {
 
     curveRoc::curveRoc(double roc)
-      : _roc(roc)
+      : _roc(roc),
+        _roc_version(0)
     {
     }
 
     void curveRoc::set_roc(double roc)
     {
       _roc = roc;
+      _roc_version++;
     }
 
     double curveRoc::get_roc() const
@@ -141,6 +141,9 @@ namespace _goptical {
 
       double sagitta(double r) const;
       double derivative(double r) const;
+      void freeze() const;
+      /** @override */
+      inline unsigned int get_version() const;
 
     private:
 
@@ -40,6 +40,7 @@ namespace _goptical {
       _moving_source = true;
       _offset = offset;
       clear();
+      update_version();
     }
 
     void Foucault::set_fixed_source(double source_to_surface)
@@ -48,12 +49,14 @@ namespace _goptical {
       _moving_source = false;
       _offset = source_to_surface;
       clear();
+      update_version();
     }
 
     void Foucault::set_radius(double radius)
     {
       _updated = false;
       _radius = radius;
+      update_version();
     }
 
     double Foucault::get_radius() const
@@ -65,6 +68,7 @@ namespace _goptical {
     {
       _updated = false;
       _ode_step = step;
+      update_version();
     }
 
     unsigned int Foucault::get_zones_count() const
@@ -75,6 +79,7 @@ namespace _goptical {
     void Foucault::set_knife_offset(unsigned int zone_number, double  knife_offset)
     {
       _reading.get_y_value(zone_number) = knife_offset;
+      update_version();
     }
 
     const std::pair<double, double> Foucault::get_reading(unsigned int index) const
@@ -87,6 +92,11 @@ namespace _goptical {
       return r;
     }
 
+    unsigned int Foucault::get_version() const
+    {
+      return Rotational::get_version() + _roc_version;
+    }
+
   }
 }
 
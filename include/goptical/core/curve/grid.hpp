@@ -72,6 +72,7 @@ namespace _goptical {
 
       double sagitta(const math::Vector2 & xy) const;
       void derivative(const math::Vector2 & xy, math::Vector2 & dxdy) const;
+      void freeze() const;
 
     protected:
       data::Grid _data;
@@ -39,6 +39,8 @@ namespace _goptical {
 
     data::Grid & Grid::get_data()
     {
+      update_version();
+
       return _data;
     }
 
@@ -73,6 +73,13 @@ namespace _goptical {
       /** Get a sample point on curve. (0,0) is not included. */
       virtual void get_sample(unsigned int index, double &r, double &z) const;
 
+    protected:
+      /** Compute normal using derivative function of class X
+          without virtual call. Used by derived classes to implement
+          @ref normal. */
+      template <class X>
+      inline void normal_(math::Vector3 &normal, const math::Vector3 &point) const;
+
     private:
       static double gsl_func_sagitta(double x, void *params);
       gsl_function gsl_func;
@@ -38,6 +38,22 @@ namespace _goptical {
       return sagitta(xy.len());
     }
 
+    template <class X>
+    void Rotational::normal_(math::Vector3 &normal, const math::Vector3 &point) const
+    {
+      const double r = sqrt(math::square(point.x()) + math::square(point.y()));
+
+      if (r == 0)
+        normal = math::Vector3(0, 0, -1);
+      else
+        {
+          const double p = static_cast<const X *>(this)->X::derivative(r);
+
+          normal = math::Vector3(point.x() * p / r, point.y() * p / r, -1.0);
+          normal.normalize();
+        }
+    }
+
   }
 }
 
@@ -49,6 +49,14 @@ namespace _goptical {
       Sphere(double roc);
 
       bool intersect(math::Vector3 &point, const math::VectorPair3 &ray) const;
+      void intersect_batch(unsigned int count,
+                           const double *const origin[3],
+                           const double *const direction[3],
+                           double *const point[3], bool hit[]) const;
+      void intersect_batch(unsigned int count,
+                           const float *const origin[3],
+                           const float *const direction[3],
+                           float *const point[3], bool hit[]) const;
       void normal(math::Vector3 &normal, const math::Vector3 &point) const;
 
       double sagitta(double r) const;
@@ -72,6 +72,8 @@ namespace _goptical {
       inline double sagitta(double r) const;
       inline double derivative(double r) const;
 
+      void freeze() const;
+
     protected:
       data::DiscreteSet _data;
     };
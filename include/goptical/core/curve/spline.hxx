@@ -40,6 +40,7 @@ namespace _goptical {
 
     data::DiscreteSet & Spline::get_data()
     {
+      update_version();
       return _data;
     }
 
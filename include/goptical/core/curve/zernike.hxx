@@ -37,6 +37,7 @@ namespace _goptical {
     void Zernike::set_radius(double radius)
     {
       _radius = radius;
+      update_version();
     }
 
     double Zernike::get_radius() const
@@ -66,6 +67,7 @@ namespace _goptical {
     void Zernike::set_coefficients_scale(double s)
     {
       _scale = s;
+      update_version();
     }
 
   }
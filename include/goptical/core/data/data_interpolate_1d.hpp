@@ -58,6 +58,11 @@ namespace _goptical {
 
       void set_interpolation(Interpolation i);
 
+      /** Compute interpolation data now instead of on first call
+          to @ref interpolate, so that later calls do not modify
+          the object. Errors are reported when interpolating. */
+      void freeze() const;
+
     private:
       /** quadratic and cubic polynomial coefficients */
       struct poly_s
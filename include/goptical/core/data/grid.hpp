@@ -133,6 +133,11 @@ namespace _goptical {
       math::range_t get_x_range(unsigned int dimension) const;
       void set_interpolation(Interpolation i);
 
+      /** Compute interpolation data now instead of on first call
+          to @ref interpolate, so that later calls do not modify
+          the object. Errors are reported when interpolating. */
+      void freeze() const;
+
     private:
 
       struct poly_t
@@ -95,8 +95,24 @@ namespace _goptical {
       /** Get material color and alpha */
       virtual io::Rgb get_color() const;
 
+      /** Compute lazily updated data so that later calls to const
+          member functions do not modify the material. @see
+          sys::system::freeze */
+      virtual void freeze() const;
+
+      /** Get material version. Version changes each time the
+          material is modified, it is used to invalidate data
+          computed from the material. */
+      virtual inline unsigned int get_version() const;
+
     protected:
+      /** Must be called by functions which modify the material */
+      inline void update_version();
+
       double            _temperature; // celcius
+
+    private:
+      unsigned int      _version;
     };
 
     /** material null pointer */
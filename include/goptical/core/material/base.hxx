@@ -35,6 +35,16 @@ namespace _goptical {
       return get_refractive_index(wavelen) / env.get_refractive_index(wavelen);
     }
 
+    unsigned int Base::get_version() const
+    {
+      return _version;
+    }
+
+    void Base::update_version()
+    {
+      _version++;
+    }
+
   }
 }
 
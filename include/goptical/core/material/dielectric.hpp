@@ -26,6 +26,8 @@
 #ifndef GOPTICAL_MATERIAL_DIELECTRIC_HH_
 #define GOPTICAL_MATERIAL_DIELECTRIC_HH_
 
+#include <atomic>
+
 #include "goptical/core/common.hpp"
 
 #include "goptical/core/data/discrete_set.hpp"
@@ -71,7 +73,8 @@ namespace _goptical {
 
       Dielectric();
 
-      /** Get internal tranmittance dataset object.
+      /** Get internal tranmittance dataset object for
+          modification, material version is updated.
           @see clear_internal_transmittance */
       inline data::DiscreteSet & get_transmittance_dataset();
 
@@ -128,6 +131,10 @@ namespace _goptical {
       double get_internal_transmittance(double wavelen) const;
       /** @override */
       double get_refractive_index(double wavelen) const;
+      /** @override */
+      void freeze() const;
+      /** @override */
+      unsigned int get_version() const;
 
     private:
 
@@ -158,8 +165,35 @@ namespace _goptical {
       /** medium used during refractive index measurement */
       const_ref<Base> _measurement_medium;
 
-      mutable double _last_wavelen;
-      mutable double _last_get_refractive_index;
+      /** last computed refractive index along with material
+          version, so that changes made by setters are not hidden by
+          the cache. This cache is updated using a sequence counter
+          so that concurrent ray tracing threads never read a torn
+          entry. */
+      struct index_cache_s
+      {
+        index_cache_s()
+          : _seq(0), _version(0), _wavelen(0), _index(0)
+        {
+        }
+
+        index_cache_s(const index_cache_s &)
+          : _seq(0), _version(0), _wavelen(0), _index(0)
+        {
+        }
+
+        index_cache_s & operator=(const index_cache_s &)
+        {
+          return *this;
+        }
+
+        std::atomic<unsigned int> _seq;
+        std::atomic<unsigned int> _version;
+        std::atomic<double>       _wavelen;
+        std::atomic<double>       _index;
+      };
+
+      mutable index_cache_s _last_index;
     };
 
   }
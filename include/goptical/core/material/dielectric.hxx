@@ -38,10 +38,13 @@ namespace _goptical {
     void Dielectric::clear_internal_transmittance()
     {
       _transmittance.clear();
+      update_version();
     }
 
     data::DiscreteSet & Dielectric::get_transmittance_dataset()
     {
+      // dataset is expected to be modified
+      update_version();
       return _transmittance;
     }
 
@@ -55,29 +58,34 @@ namespace _goptical {
       _temp_e0 = e0;
       _temp_e1 = e1;
       _temp_wl_tk = wl_tk;
+      update_version();
     }
 
     void Dielectric::set_temperature_dndt(double dndt)
     {
       _temp_model = ThermalDnDt;
       _temp_d0 = dndt;
+      update_version();
     }
 
     void Dielectric::disable_temperature_coeff()
     {
       _temp_model = ThermalNone;
+      update_version();
     }
 
     void Dielectric::set_measurement_medium(const const_ref<Base> &medium)
     {
       assert(medium.ptr() != this);
       _measurement_medium = medium;
+      update_version();
     }
 
     void Dielectric::set_wavelen_range(double low, double high)
     {
       _low_wavelen = low;
       _high_wavelen = high;
+      update_version();
     }
 
   }
@@ -60,11 +60,14 @@ namespace _goptical {
       /** Clear all refractive index data */
       inline void clear_refractive_index_table();
 
-      /** Get refractive index dataset object */
+      /** Get refractive index dataset object for modification,
+          material version is updated */
       inline data::DiscreteSet & get_refractive_index_dataset();
 
       /** @override */
       double get_measurement_index(double wavelen) const;
+      /** @override */
+      void freeze() const;
     private:
 
       data::DiscreteSet _refractive_index;
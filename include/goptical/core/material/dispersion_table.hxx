@@ -37,17 +37,21 @@ namespace _goptical {
 
     data::DiscreteSet & DispersionTable::get_refractive_index_dataset()
     {
+      // dataset is expected to be modified
+      update_version();
       return _refractive_index;
     }
 
     void DispersionTable::set_refractive_index(double wavelen, double index)
     {
       _refractive_index.add_data(wavelen, index);
+      update_version();
     }
 
     void DispersionTable::clear_refractive_index_table()
     {
       _refractive_index.clear();
+      update_version();
     }
 
   }
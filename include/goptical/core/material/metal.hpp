@@ -58,9 +58,13 @@ namespace _goptical {
       double get_refractive_index(double wavelen) const;
       double get_extinction_coef(double wavelen) const;
 
-      /** Get refractive index dataset object */
+      void freeze() const;
+
+      /** Get refractive index dataset object for modification,
+          material version is updated */
       inline data::DiscreteSet & get_refractive_index_dataset();
-      /** Get extinction dataset object */
+      /** Get extinction dataset object for modification, material
+          version is updated */
       inline data::DiscreteSet & get_extinction_coef_dataset();
 
     protected:
@@ -34,11 +34,15 @@ namespace _goptical {
 
     data::DiscreteSet & Metal::get_extinction_coef_dataset()
     {
+      // dataset is expected to be modified
+      update_version();
       return _extinction;
     }
 
     data::DiscreteSet & Metal::get_refractive_index_dataset()
     {
+      // dataset is expected to be modified
+      update_version();
       return _refractive_index;
     }
 
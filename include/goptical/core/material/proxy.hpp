@@ -75,6 +75,12 @@ namespace _goptical {
       /** @override */
       io::Rgb get_color() const;
 
+      /** @override */
+      void freeze() const;
+
+      /** @override */
+      unsigned int get_version() const;
+
     private:
       const_ref<Base> _m;
     };
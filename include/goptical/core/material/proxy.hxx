@@ -35,6 +35,7 @@ namespace _goptical {
     void Proxy::set_material(const const_ref<Base> &m)
     {
       _m = m;
+      update_version();
     }
 
     const Base & Proxy::get_material() const
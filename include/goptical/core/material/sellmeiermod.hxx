@@ -41,6 +41,7 @@ namespace _goptical {
       _c = C;
       _d = D;
       _e = E;
+      this->update_version();
     }
 
   }
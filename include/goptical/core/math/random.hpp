@@ -0,0 +1,116 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+#ifndef GOPTICAL_MATH_RANDOM_HH_
+#define GOPTICAL_MATH_RANDOM_HH_
+
+#include <stdint.h>
+
+#include "goptical/core/common.hpp"
+
+#include "goptical/core/math/vector.hpp"
+
+namespace _goptical {
+
+  namespace math {
+
+    /**
+       @short Counter based random numbers generator
+       @header <goptical/core/math/Random
+       @module {Core}
+
+       This class implements the Philox4x32-10 generator. Random
+       values are a pure function of the seed and of a counter
+       value, there is no internal state. The same sequence is
+       obtained whatever the order in which values are requested,
+       which makes it suitable for parallel generation.
+     */
+    class Philox
+    {
+    public:
+      /** Create a generator with the given seed */
+      inline Philox(uint64_t seed = 0);
+
+      /** Get four random 32 bits words for a counter value */
+      inline void get(uint64_t counter, uint32_t result[4]) const;
+
+      /** Get two uniform random values in [0, 1) for a counter value */
+      inline void get_uniform(uint64_t counter, double &a, double &b) const;
+
+    private:
+      static inline double to_uniform(uint32_t hi, uint32_t lo);
+
+      uint32_t  _key[2];
+    };
+
+    /**
+       @short Scrambled two dimensions Sobol sequence
+       @header <goptical/core/math/Random
+       @module {Core}
+
+       Points are scrambled using a random digital shift computed
+       from the seed. This keeps the low discrepancy properties of
+       the sequence.
+     */
+    class Sobol2
+    {
+    public:
+      /** Create a sequence scrambled with the given seed */
+      inline Sobol2(uint64_t seed = 0);
+
+      /** Get point of the sequence in the unit square */
+      inline Vector2 get(uint32_t index) const;
+
+    private:
+      uint32_t  _shift[2];
+    };
+
+    /**
+       @short Scrambled two dimensions Halton sequence
+       @header <goptical/core/math/Random
+       @module {Core}
+
+       This is the Halton sequence in bases 2 and 3 with a random
+       toroidal shift computed from the seed.
+     */
+    class Halton2
+    {
+    public:
+      /** Create a sequence scrambled with the given seed */
+      inline Halton2(uint64_t seed = 0);
+
+      /** Get point of the sequence in the unit square */
+      inline Vector2 get(uint32_t index) const;
+
+    private:
+      static inline double radical_inverse(uint32_t index, uint32_t base);
+
+      double    _shift[2];
+    };
+
+  }
+}
+
+#endif
+
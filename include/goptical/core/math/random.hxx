@@ -0,0 +1,140 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+#ifndef GOPTICAL_MATH_RANDOM_HXX_
+#define GOPTICAL_MATH_RANDOM_HXX_
+
+#include "goptical/core/math/vector.hxx"
+
+namespace _goptical {
+
+  namespace math {
+
+    Philox::Philox(uint64_t seed)
+    {
+      _key[0] = (uint32_t)seed;
+      _key[1] = (uint32_t)(seed >> 32);
+    }
+
+    void Philox::get(uint64_t counter, uint32_t r[4]) const
+    {
+      uint32_t k0 = _key[0], k1 = _key[1];
+
+      r[0] = (uint32_t)counter;
+      r[1] = (uint32_t)(counter >> 32);
+      r[2] = 0;
+      r[3] = 0;
+
+      for (unsigned int i = 0; i < 10; i++)
+        {
+          uint64_t p0 = (uint64_t)0xd2511f53 * r[0];
+          uint64_t p1 = (uint64_t)0xcd9e8d57 * r[2];
+
+          uint32_t t0 = (uint32_t)(p1 >> 32) ^ r[1] ^ k0;
+          uint32_t t2 = (uint32_t)(p0 >> 32) ^ r[3] ^ k1;
+
+          r[0] = t0;
+          r[1] = (uint32_t)p1;
+          r[2] = t2;
+          r[3] = (uint32_t)p0;
+
+          k0 += 0x9e3779b9;
+          k1 += 0xbb67ae85;
+        }
+    }
+
+    double Philox::to_uniform(uint32_t hi, uint32_t lo)
+    {
+      // 53 bits mantissa
+      return ((hi >> 5) * 67108864.0 + (lo >> 6)) * (1.0 / 9007199254740992.0);
+    }
+
+    void Philox::get_uniform(uint64_t counter, double &a, double &b) const
+    {
+      uint32_t r[4];
+
+      get(counter, r);
+      a = to_uniform(r[0], r[1]);
+      b = to_uniform(r[2], r[3]);
+    }
+
+    Sobol2::Sobol2(uint64_t seed)
+    {
+      uint32_t r[4];
+
+      Philox(seed).get(0, r);
+      _shift[0] = r[0];
+      _shift[1] = r[1];
+    }
+
+    Vector2 Sobol2::get(uint32_t index) const
+    {
+      uint32_t x = 0, y = 0;
+      uint32_t v = 1U << 31;
+
+      // first dimension direction numbers are powers of 2, second
+      // dimension uses primitive polynomial x + 1
+      for (unsigned int k = 0; index; k++, index >>= 1)
+        {
+          if (index & 1)
+            {
+              x ^= 1U << (31 - k);
+              y ^= v;
+            }
+
+          v ^= v >> 1;
+        }
+
+      return Vector2((x ^ _shift[0]) * (1.0 / 4294967296.0),
+                     (y ^ _shift[1]) * (1.0 / 4294967296.0));
+    }
+
+    Halton2::Halton2(uint64_t seed)
+    {
+      Philox(seed).get_uniform(0, _shift[0], _shift[1]);
+    }
+
+    double Halton2::radical_inverse(uint32_t index, uint32_t base)
+    {
+      double inv = 1.0 / base, f = inv, r = 0;
+
+      for (; index; index /= base, f *= inv)
+        r += (index % base) * f;
+
+      return r;
+    }
+
+    Vector2 Halton2::get(uint32_t index) const
+    {
+      double x = radical_inverse(index, 2) + _shift[0];
+      double y = radical_inverse(index, 3) + _shift[1];
+
+      return Vector2(x < 1. ? x : x - 1., y < 1. ? y : y - 1.);
+    }
+
+  }
+}
+
+#endif
+
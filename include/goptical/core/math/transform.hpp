@@ -72,6 +72,9 @@ namespace _goptical {
       /** get linear transform matrix */
       inline Matrix<N> & get_linear();
 
+      /** test if linear transform matrix is not identity */
+      inline bool get_use_linear() const;
+
       /** set current translation */
       inline void set_translation(const Vector<N> &v);
 
@@ -162,6 +162,12 @@ namespace _goptical {
       return _linear;
     }
 
+    template <int N>
+    bool TransformBase<N>::get_use_linear() const
+    {
+      return _use_linear;
+    }
+
     template <int N>
     Matrix<N> & TransformBase<N>::get_linear()
     {
@@ -89,6 +89,24 @@ namespace _goptical {
       /** Get shape teselation triangles */
       virtual void get_triangles(const math::Triangle<2>::put_delegate_t &f,
                                  double resolution) const = 0;
+
+      /** Compute lazily updated data so that later calls to const
+          member functions do not modify the shape. @see
+          sys::system::freeze */
+      virtual void freeze() const;
+
+      /** Get shape version. Version changes each time the shape is
+          modified, it is used to invalidate data computed from the
+          shape. */
+      virtual inline unsigned int get_version() const;
+
+    protected:
+
+      /** Must be called by functions which modify the shape */
+      inline void update_version();
+
+    private:
+      unsigned int _version;
     };
 
   }
@@ -31,9 +31,20 @@ namespace _goptical {
   namespace shape {
 
     Base::Base()
+      : _version(0)
     {
     }
 
+    unsigned int Base::get_version() const
+    {
+      return _version;
+    }
+
+    void Base::update_version()
+    {
+      _version++;
+    }
+
   }
 }
 
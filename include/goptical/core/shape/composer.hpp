@@ -76,6 +76,10 @@ namespace _goptical {
       void get_contour(unsigned int contour, const math::Vector2::put_delegate_t  &f, double resolution) const;
       /** @override */
       void get_triangles(const math::Triangle<2>::put_delegate_t  &f, double resolution) const;
+      /** @override */
+      void freeze() const;
+      /** @override */
+      unsigned int get_version() const;
 
       /** Add a new shape to shape composer.
           
@@ -126,12 +130,15 @@ namespace _goptical {
 
       private:
         bool inside(const math::Vector2 &point) const;
+        void freeze() const;
+        unsigned int get_version() const;
 
         const_ref<Base>         _shape;
         bool                    _exclude;
         std::list <Attributes>  _list;
         math::Transform<2>      _transform;
         math::Transform<2>      _inv_transform;
+        unsigned int            _version;
       };
 
       Composer();
@@ -37,6 +37,7 @@ namespace _goptical {
     {
       _transform.affine_scaling(factor);
       _inv_transform = _transform.inverse();
+      _version++;
 
       return *this;
     }
@@ -45,6 +46,7 @@ namespace _goptical {
     {
       _transform.affine_rotation(0, angle);
       _inv_transform = _transform.inverse();
+      _version++;
 
       return *this;
     }
@@ -53,6 +55,7 @@ namespace _goptical {
     {
       _transform.apply_translation(offset);
       _inv_transform = _transform.inverse();
+      _version++;
 
       return *this;
     }
@@ -60,6 +63,7 @@ namespace _goptical {
     void Composer::use_global_distribution(bool use_global)
     {
       _global_dist = use_global;
+      update_version();
     }
 
   }
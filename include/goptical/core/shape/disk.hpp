@@ -50,6 +50,9 @@ namespace _goptical {
       /** Get disk radius */
       inline double get_radius(void) const;
 
+      /** @override */
+      bool inside(const math::Vector2 &point) const;
+
     protected:
 
       /** @override */
@@ -60,8 +63,6 @@ namespace _goptical {
       double get_outter_radius(const math::Vector2 &dir) const;
       /** @override */
       math::VectorPair2 get_bounding_box() const;
-      /** @override */
-      bool inside(const math::Vector2 &point) const;
 
       inline double get_external_xradius() const;
       inline double get_internal_xradius() const;
@@ -80,6 +80,8 @@ namespace _goptical {
       void get_contour(unsigned int contour, const math::Vector2::put_delegate_t  &f, double resolution) const;
       /** @override */
       void get_triangles(const math::Triangle<2>::put_delegate_t &f, double resolution) const;
+      /** @override */
+      void freeze() const;
 
       /** update _min_radius and bounding box */
       void update();
@@ -45,6 +45,7 @@ namespace _goptical {
 
       _radius = radius;
       _hole_radius = hole_radius;
+      update_version();
     }
 
     double RingBase::get_radius(void) const
@@ -40,6 +40,7 @@ namespace _goptical {
     void Round::set_radius(double r)
     {
       _radius = r;
+      update_version();
     }
 
     double Round::get_radius(void) const
@@ -219,6 +219,11 @@ protected:
           when the local 3d transform has been updated. */
       virtual void system_moved();
 
+      /** This function is called from @ref system::freeze. It must
+          be reimplemented by subclasses which use objects with
+          lazily updated data during ray tracing. */
+      virtual void freeze() const;
+
 private:
       system *_system;
       Container *_container;
@@ -32,6 +32,7 @@
 #include "goptical/core/shape/infinite.hpp"
 #include "goptical/core/curve/flat.hpp"
 #include "goptical/core/sys/surface.hpp"
+#include "goptical/core/trace/ray_packet.hpp"
 
 namespace _goptical {
 
@@ -104,6 +105,31 @@ namespace _goptical {
       void trace_ray_intensity(trace::Result &result, trace::Ray &incident,
                                const math::VectorPair3 &local, const math::VectorPair3 &intersect) const;
 
+      /** @override */
+      void trace_packet_simple(trace::Result &result, trace::RayPacket &packet) const;
+
+      /** @override */
+      void trace_packet_intensity(trace::Result &result, trace::RayPacket &packet) const;
+
+      /** find packet rays propagation direction and discard rays
+          which escaped from their material */
+      void select_packet_materials(trace::RayPacket &packet, bool right_to_left[]) const;
+
+      /** compute refracted and reflected directions for all rays in
+          packet, the refract array is set to false on total
+          internal reflection. */
+      void refract_packet(const trace::Result &result,
+                          const trace::RayPacket &packet,
+                          const bool right_to_left[],
+                          double refracted[3][trace::RayPacket::size],
+                          double reflected[3][trace::RayPacket::size],
+                          bool refract[]) const;
+
+      /** create a new ray generated from a packet ray */
+      inline void new_packet_ray(trace::Result &result, trace::RayPacket &packet,
+                                 unsigned int i, const double dir[3][trace::RayPacket::size],
+                                 double intensity, const material::Base *mat) const;
+
       /** @override */
       void system_register(system &s);
 
@@ -113,6 +139,9 @@ namespace _goptical {
       /** @override */      
       void print(std::ostream &o) const;
 
+      /** @override */
+      void freeze() const;
+
       /** compute refracted ray direction according to fresnel law */
       bool refract(const math::VectorPair3 &ray,
                    math::Vector3 &direction,
@@ -104,6 +104,30 @@ namespace _goptical {
 
       void refresh_intensity_limits();
 
+      /** Spectral line parameters of generated rays */
+      struct line_s
+      {
+        double          _wavelen;
+        double          _intensity;
+        unsigned int    _wavelen_index;
+      };
+
+      /** Get spectral lines along with wavelen indexes in result */
+      void get_lines(trace::Result &result, std::vector<line_s> &lines) const;
+
+      /** Get material where rays are generated */
+      const material::Base * get_ray_material() const;
+
+      /** Allocate a ray for each spectral line, spectral line
+          intensity is scaled by the given weight. Origin and direction
+          use source coordinates. */
+      void emit_rays(trace::Result &result, const std::vector<line_s> &lines,
+                     const material::Base *mat, const math::Vector3 &origin,
+                     const math::Vector3 &direction, double weight) const;
+
+      /** @override */
+      void freeze() const;
+
       std::vector<light::SpectralLine>  _spectrum;
       double                            _min_intensity, _max_intensity;
       const_ref<material::Base>     _mat;
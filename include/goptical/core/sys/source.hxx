@@ -41,18 +41,21 @@ namespace _goptical {
     void Source::set_material(const const_ref<material::Base> &m)
     {
       _mat = m;
+      update_version();
     }
 
     void Source::clear_spectrum()
     {
       _spectrum.clear();
       _max_intensity = _min_intensity = 0.0;
+      update_version();
     }
 
     void Source::single_spectral_line(const light::SpectralLine & l)
     {
       _spectrum.clear();
       _spectrum.push_back(l);
+      update_version();
     }
 
     void Source::add_spectral_line(const light::SpectralLine & l)
@@ -60,12 +63,14 @@ namespace _goptical {
       _spectrum.push_back(l);
       _max_intensity = std::max(_max_intensity, l.get_intensity());
       _min_intensity = std::min(_min_intensity, l.get_intensity());
+      update_version();
     }
 
     void Source::set_spectral_line(const light::SpectralLine & l, int index)
     {
       _spectrum[index] = l;
       refresh_intensity_limits();
+      update_version();
     }
 
     double Source::get_max_intensity() const
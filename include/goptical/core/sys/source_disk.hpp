@@ -26,6 +26,8 @@
 #ifndef GOPTICAL_SOURCE_DISK_HH_
 #define GOPTICAL_SOURCE_DISK_HH_
 
+#include <functional>
+
 #include "goptical/core/common.hpp"
 
 #include "goptical/core/sys/source.hpp"
@@ -40,6 +42,14 @@ namespace _goptical {
          @module {Core}
          @main
 
+         At infinity, parallel rays are generated toward the target
+         surface pattern. At finite distance, the source is an
+         elliptical emitter of given size lying in the source xy
+         plane and facing the z axis. Rays are sampled jointly over
+         the emitter area and the emission cone which encloses the
+         target surface: both domains are split in strata and strata
+         pairs are shuffled so that each projection stays stratified.
+
       */
       
     class SourceDisk : public Source
@@ -67,6 +77,14 @@ namespace _goptical {
         void set_limits(const math::Vector2& limit1,
                         const math::Vector2& limit2);
 
+        /** Angular radiance weighting function. Argument is the
+            angle in radians between ray and emitter normal. */
+        typedef std::function<double (double angle)> angular_t;
+
+        /** Set angular radiance weighting of rays emitted at finite
+            distance. Emitter is lambertian when no function is set. */
+        void set_angular_distribution(const angular_t &f);
+
         
     private:
         
@@ -78,12 +96,16 @@ namespace _goptical {
         template <SourceInfinityMode mode>
         inline void get_lightrays_(trace::Result &result,
                                    const Element &target) const;
+
+        void get_finite_lightrays(trace::Result &result,
+                                  const Surface &target) const;
         
         SourceInfinityMode _mode;
         math::Vector2 _size;
         math::Vector3 _direction;
         math::Vector2 _limit1;
         math::Vector2 _limit2;
+        angular_t _angular;
 
     };
       
@@ -35,6 +35,7 @@ namespace _goptical {
     void SourcePoint::set_mode(SourceInfinityMode mode)
     {
       _mode = mode;
+      update_version();
     }
 
   }
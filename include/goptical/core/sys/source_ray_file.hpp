@@ -0,0 +1,130 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+#ifndef GOPTICAL_SOURCE_RAY_FILE_HH_
+#define GOPTICAL_SOURCE_RAY_FILE_HH_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "goptical/core/common.hpp"
+
+#include "goptical/core/sys/source.hpp"
+#include "goptical/core/light/ray.hpp"
+
+namespace _goptical {
+
+  namespace sys {
+
+      /**
+         @short Memory mapped ray file light source
+         @header <goptical/core/sys/SourceRayFile
+         @module {Core}
+         @main
+
+         This class implement a light source which generates rays
+         read from a binary ray file. The file is memory mapped and
+         rays are streamed to the tracer in chunks, it is never
+         loaded in memory as a whole. This is suitable for large
+         rays sets produced by illumination tools.
+
+         The file starts with a @ref header_s header which is
+         followed by @ref record_s records in host byte order. Ray
+         origins and directions are expressed in source element
+         coordinates, directions must be unit vectors. Ray flux is
+         used as ray intensity and wavelen is in nanometers.
+
+         The file must not be modified while mapped. A file may not
+         contain more distinct wavelens than the ray wavelen index
+         range allows, @ref open throws in this case.
+      */
+
+    class SourceRayFile : public Source
+    {
+    public:
+      /** Ray file header */
+      struct header_s
+      {
+        char            _magic[8];      // "GORAYS01"
+        uint32_t        _record_size;   // size of @ref record_s
+        uint32_t        _reserved;
+        uint64_t        _count;         // number of records
+      };
+
+      /** Ray file record */
+      struct record_s
+      {
+        float           _origin[3];
+        float           _direction[3];
+        float           _wavelen;
+        float           _flux;
+      };
+
+      /** Create a ray file source and map the specified file. */
+      SourceRayFile(const std::string &filename,
+                    const math::Vector3 &position = math::vector3_0);
+
+      ~SourceRayFile();
+
+      /** Map a new ray file, previous file is unmapped */
+      void open(const std::string &filename);
+
+      /** Unmap current ray file */
+      void close();
+
+      /** Get number of rays in mapped file */
+      inline size_t get_ray_count() const;
+
+      /** Write a ray file from light rays expressed in source
+          coordinates */
+      static void write(const std::string &filename,
+                        const std::vector<light::Ray> &rays);
+
+    private:
+      SourceRayFile(const SourceRayFile &);
+      SourceRayFile & operator=(const SourceRayFile &);
+
+      void generate_rays_simple(trace::Result &result,
+                                const targets_t &entry) const;
+
+      void generate_rays_intensity(trace::Result &result,
+                                   const targets_t &entry) const;
+
+      /** number of rays generated between two storage reservations */
+      static const unsigned int _chunk_size = 4096;
+
+      void              *_map;
+      size_t            _map_size;
+      const record_s    *_records;
+      size_t            _count;
+      /* distinct wavelens found in file, sorted */
+      std::vector<float> _wavelens;
+    };
+
+  }
+}
+
+#endif
+
@@ -63,12 +63,17 @@ namespace _goptical {
           radius. */
       Stop(const math::VectorPair3 &p, double radius);
 
-      GOPTICAL_ACCESSORS(double, external_radius,
-                         "stop external radius. @see Stop");
+      /** Set stop external radius. @see Stop */
+      inline void set_external_radius(double radius);
+      /** Get stop external radius. @see Stop */
+      inline double get_external_radius() const;
 
       GOPTICAL_ACCESSORS(bool, intercept_reemit,
                          "intercept and reemit enabled. @see Stop");
 
+      /** @override Rays are blocked up to the external radius */
+      math::VectorPair3 get_intersect_bounding_box() const;
+
     private:
 
       /** @override */
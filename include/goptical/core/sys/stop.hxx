@@ -31,6 +31,17 @@ namespace _goptical {
 
   namespace sys {
 
+    void Stop::set_external_radius(double radius)
+    {
+      _external_radius = radius;
+      update_version();
+    }
+
+    double Stop::get_external_radius() const
+    {
+      return _external_radius;
+    }
+
   }
 }
 
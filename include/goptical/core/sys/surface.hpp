@@ -27,12 +27,16 @@
 #define GOPTICAL_SURFACE_HH_
 
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 #include "goptical/core/common.hpp"
 
 #include "goptical/core/sys/element.hpp"
 #include "goptical/core/shape/base.hpp"
 #include "goptical/core/curve/base.hpp"
+#include "goptical/core/trace/distribution.hpp"
 
 namespace _goptical {
 
@@ -54,6 +58,12 @@ namespace _goptical {
        @ref trace_ray_intensity or @ref trace_ray_polarized. These
        functions must be reimplemented in sub classes, default
        implementations will throw.
+
+       In sequential mode, incoming rays are processed in blocks
+       stored in @ref trace::RayPacket objects. Sub classes may
+       reimplement @ref trace_packet_simple and @ref
+       trace_packet_intensity to handle all rays of a packet at
+       once.
     */
 
     class Surface : public Element
@@ -83,16 +93,39 @@ namespace _goptical {
                              math::VectorPair3 &pt,
                              const math::VectorPair3 &ray) const;
 
+      /** Get intersection points and normals for all rays in a
+          packet and set the packet hit flags. Batched kernels are
+          used for library surface classes, @ref intersect is called
+          for each ray of other classes so that reimplementations
+          are honored. Subclasses may reimplement this function along
+          with @ref intersect to get batched intersection back. */
+      virtual void intersect_packet(const trace::Params &params,
+                                    trace::RayPacket &packet) const;
+
       /** Get distribution pattern points projected on the surface */
       void get_pattern(const math::Vector3::put_delegate_t &f,
                        const trace::Distribution &d,
                        bool unobstructed = false) const;
 
+      /** Get distribution pattern points projected on the
+          surface. Points sets of the last few distributions are
+          kept so that repeated traces do not compute them again.
+          Cached points are dropped when the curve or the shape is
+          replaced, and modifications made in place are detected
+          through the curve and shape versions. */
+      std::shared_ptr<const std::vector<math::Vector3> >
+      get_pattern(const trace::Distribution &d,
+                  bool unobstructed = false) const;
+
       /** trace a single ray through the surface */
       template <trace::IntensityMode m>
       void trace_ray(trace::Result &result, trace::Ray &incident,
                      const math::VectorPair3 &local, const math::VectorPair3 &intersect) const;
 
+      /** trace all rays of a packet which intersect the surface */
+      template <trace::IntensityMode m>
+      void trace_packet(trace::Result &result, trace::RayPacket &packet) const;
+
       /** Get surface apparent color */
       virtual io::Rgb get_color(const io::Renderer &r) const;
 
@@ -104,6 +137,13 @@ namespace _goptical {
 
       math::VectorPair3 get_bounding_box() const;
 
+      /** Get bounding box of all points where @ref intersect may
+          report an intersection in obstructed mode, in surface local
+          coordinates. Default implementation returns @ref
+          get_bounding_box, this must be reimplemented by subclasses
+          whose @ref intersect function reaches past the shape. */
+      virtual math::VectorPair3 get_intersect_bounding_box() const;
+
     protected:
 
       /** This function must be reimplemented by subclasses to handle
@@ -121,10 +161,29 @@ namespace _goptical {
       virtual void trace_ray_polarized(trace::Result &result, trace::Ray &incident,
                                        const math::VectorPair3 &local, const math::VectorPair3 &intersect) const;
 
+      /** Handle a packet of incoming rays in simple ray trace
+          mode. Default implementation calls @ref trace_ray_simple
+          for each ray which intersects the surface. */
+      virtual void trace_packet_simple(trace::Result &result, trace::RayPacket &packet) const;
+
+      /** Handle a packet of incoming rays in intensity ray trace
+          mode. Default implementation calls @ref trace_ray_intensity
+          for each ray which intersects the surface. */
+      virtual void trace_packet_intensity(trace::Result &result, trace::RayPacket &packet) const;
+
       /** @override */
       void draw_2d_e(io::Renderer &r, const Element *ref) const;
       /** @override */
       void draw_3d_e(io::Renderer &r, const Element *ref) const;
+      /** @override */
+      void freeze() const;
+
+      /** Test if the surface dynamic type is a built-in class, so
+          that batched kernels give the same results as the virtual
+          @ref intersect, @ref trace_ray_simple and @ref
+          trace_ray_intensity functions which user sub classes may
+          reimplement */
+      bool has_packet_kernels() const;
 
     private:
 
@@ -137,6 +196,20 @@ namespace _goptical {
       inline void process_rays_(trace::Result &result,
                                trace::rays_queue_t *input) const;
 
+      template <trace::IntensityMode m>
+      inline void process_packet(trace::Result &result,
+                                 trace::RayPacket &packet) const;
+
+      /** Compute single precision curve intersections of a packet
+          and report difference with double precision intersections */
+      void check_packet_precision(trace::Result &result, trace::RayPacket &packet,
+                                  double radius) const;
+
+      /** Get radius of a sphere centered on surface origin which
+          contains the intersect bounding box, used to move rays origins
+          near the surface before single precision computations. */
+      double get_intersect_radius(const trace::Params &params) const;
+
       virtual void process_rays_simple(trace::Result &result,
                                        trace::rays_queue_t *input) const;
 
@@ -146,9 +219,57 @@ namespace _goptical {
       virtual void process_rays_polarized(trace::Result &result,
                                           trace::rays_queue_t *input) const;
 
+      /** Intersection functions specialized for curve type C and
+          shape type S. Built-in curve and shape member functions are
+          called without virtual dispatch, @ref curve::Base and
+          @ref shape::Base are used as generic fallback. */
+      template <class C, class S>
+      bool intersect_(const trace::Params &params, math::VectorPair3 &pt,
+                      const math::VectorPair3 &ray) const;
+
+      template <class C, class S>
+      void intersect_packet_(const trace::Params &params,
+                             trace::RayPacket &packet) const;
+
+      template <class C>
+      void select_kernels();
+
+      /** Get intersections of packet rays one at a time with the
+          virtual @ref intersect function */
+      void intersect_packet_rays(const trace::Params &params,
+                                 trace::RayPacket &packet) const;
+
+      /** Select intersection functions from curve and shape
+          dynamic types */
+      void update_kernels();
+
+      typedef bool (Surface::*intersect_t)(const trace::Params &params, math::VectorPair3 &pt,
+                                           const math::VectorPair3 &ray) const;
+      typedef void (Surface::*intersect_packet_t)(const trace::Params &params,
+                                                  trace::RayPacket &packet) const;
+
+      /** Flush cached pattern points */
+      void flush_pattern_cache();
+
+      struct pattern_cache_s
+      {
+        trace::Distribution     _dist;
+        bool                    _unobstructed;
+        unsigned int            _curve_version;
+        unsigned int            _shape_version;
+        std::shared_ptr<const std::vector<math::Vector3> > _points;
+      };
+
+      /** number of cached distribution patterns */
+      static const unsigned int _pattern_cache_size = 4;
+
       double                    _discard_intensity;
       const_ref<curve::Base>   _curve;
       const_ref<shape::Base>   _shape;
+      intersect_t               _intersect;
+      intersect_packet_t        _intersect_packet;
+      mutable std::vector<pattern_cache_s> _pattern_cache; // most recent last
+      mutable std::mutex        _pattern_lock;
     };
 
   }
@@ -39,6 +39,9 @@ namespace _goptical {
     void Surface::set_curve(const const_ref<curve::Base> &c)
     {
       _curve = c;
+      update_kernels();
+      flush_pattern_cache();
+      update_version();
     }
 
     const curve::Base & Surface::get_curve() const
@@ -49,6 +52,9 @@ namespace _goptical {
     void Surface::set_shape(const const_ref<shape::Base> &s)
     {
       _shape = s;
+      update_kernels();
+      flush_pattern_cache();
+      update_version();
     }
 
     const shape::Base & Surface::get_shape() const
@@ -59,6 +65,7 @@ namespace _goptical {
     void Surface::set_discard_intensity(double intensity)
     {
       _discard_intensity = intensity;
+      update_version();
     }
 
     inline double Surface::get_discard_intensity() const
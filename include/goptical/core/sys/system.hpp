@@ -25,7 +25,12 @@
 #ifndef GOPTICAL_SYSTEM_HH_
 #define GOPTICAL_SYSTEM_HH_
 
+#include <atomic>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 
 #include "goptical/core/common.hpp"
 
@@ -38,6 +43,8 @@ namespace _goptical {
 
   namespace sys {
 
+    class Bvh;
+
     /**
        @short Optical system
        @header <goptical/core/sys/system
@@ -83,6 +90,12 @@ namespace _goptical {
       /** Get transform between two elements local coordinates */
       inline const math::Transform<3> & get_transform(const Element &from, const Element &to) const;
 
+      /** Compute transform between two elements local coordinates
+          from per element transforms. The pair transforms cache is
+          not used, this is safe on a frozen system shared by
+          several threads. */
+      inline math::Transform<3> compose_transform(const Element &from, const Element &to) const;
+
       /** Get transform from element local to global coordinates */
       inline const math::Transform<3> & get_global_transform(const Element &from) const;
 
@@ -93,6 +106,15 @@ namespace _goptical {
           associated elements properties are changed */
       inline unsigned int get_version() const;
 
+      /** Get sum of versions of curves, shapes and materials used by
+          system elements and environment. Changes made to these
+          objects are not reflected in the system version. */
+      unsigned int get_data_version() const;
+
+      /** Get versions of curve, shape and materials used by an
+          element, 0 when not used */
+      static void get_data_versions(const Element &e, unsigned int versions[4]);
+
       /** Get the number of registered elements in the system */
       inline unsigned int get_element_count() const;
 
@@ -107,6 +129,31 @@ namespace _goptical {
                             math::VectorPair3 &intersect,
                             const trace::Ray &ray) const;
 
+      /** @internal Rebuild surfaces bounding volume hierarchy used
+          by @ref colide_next if system version or data version
+          changed. @ref colide_next only checks the system version,
+          tracers call this function before each trace. */
+      void bvh_update() const;
+
+      /** Compute all lazily updated data of system and elements:
+          per element 3d transforms, transforms between sources and
+          other elements, surfaces bounding volume hierarchy and
+          curves, shapes and materials internal data. Functions used
+          while tracing do not modify any data afterwards, so that
+          the system can be shared by several tracers running in
+          different threads. Other pair transforms are obtained with
+          @ref compose_transform during tracing.
+
+          This is done by the @ref trace::tracer class before
+          multi-threaded tracing. Changes made in place to curves,
+          shapes or materials objects are detected through @ref
+          get_data_version. */
+      void freeze() const;
+
+      /** Test if system, curves, shapes and materials have not been
+          modified since last call to @ref freeze */
+      inline bool is_frozen() const;
+
       /** set environment material */
       void set_environment(const const_ref<material::Base> &env);
 
@@ -131,8 +178,8 @@ namespace _goptical {
       /** free the identifier associated with the given element */
       void index_put(const Element &element);
 
-      /** Get a reference to cache entry for transform between 2 elements (ids) */
-      inline math::Transform<3> * & transform_cache_entry(unsigned int from, unsigned int to) const;
+      /** Get key of pair transform cache entry for 2 elements ids */
+      inline static unsigned long long transform_pair_key(unsigned int from, unsigned int to);
 
       /** Compute and get 3d transform between element local and global coordinates */
       const math::Transform<3> & transform_l2g_cache_update(const Element &e) const;
@@ -140,6 +187,9 @@ namespace _goptical {
       const math::Transform<3> & transform_g2l_cache_update(const Element &e) const;
       /** Compute and get 3d transform between two elements local coordinates */
       const math::Transform<3> & transform_cache_update(const Element &from, const Element &to) const;
+      /** Compute local to global and global to local transforms of
+          all elements in a single pass */
+      void transform_cache_update() const;
 
       /** Flush all cached transforms associated with a given element */
       void transform_cache_flush(const Element &element);
@@ -149,6 +199,19 @@ namespace _goptical {
       /** Resize transform cache size */
       void transform_cache_resize(unsigned int newsize);
 
+      /** per element transforms, indexed by element id */
+      struct transform_entry_s
+      {
+        math::Transform<3> _l2g;
+        math::Transform<3> _g2l;
+        bool               _l2g_valid;
+        bool               _g2l_valid;
+        /** ids of elements involved in cached pair transforms */
+        std::vector<unsigned int> _pairs;
+      };
+
+      typedef std::unordered_map<unsigned long long, math::Transform<3> > transform_pair_map_t;
+
       unsigned int              _version;
 
       const_ref<Surface>        _entrance;
@@ -157,8 +220,16 @@ namespace _goptical {
       trace::Params             _tracer_params;
       unsigned int              _e_count;
       std::vector<Element *>    _index_map;
-      // FIXME use transform pool instead of new/delete
-      std::vector<math::Transform<3> *> _transform_cache;
+      mutable std::vector<transform_entry_s> _transforms;
+      mutable transform_pair_map_t      _pair_transforms;
+
+      mutable std::unique_ptr<Bvh>      _bvh;
+      mutable std::atomic<unsigned int> _bvh_version;
+      mutable std::atomic<unsigned int> _bvh_data_version;
+      mutable std::mutex                _bvh_lock;
+      mutable std::atomic<unsigned int> _frozen_version;
+      mutable std::atomic<unsigned int> _frozen_data_version;
+      mutable std::mutex                _freeze_lock;
     };
 
   }
@@ -85,39 +85,48 @@ namespace _goptical {
       return _tracer_params;
     }
 
-    math::Transform<3> * & system::transform_cache_entry(unsigned int from, unsigned int to) const
+    unsigned long long system::transform_pair_key(unsigned int from, unsigned int to)
     {
-      return const_cast<math::Transform<3> * &>(_transform_cache[from * _e_count + to]);
+      return ((unsigned long long)from << 32) | to;
     }
 
     const math::Transform<3> & system::get_transform(const Element &from, const Element &to) const
     {
-      math::Transform<3> * &e = transform_cache_entry(from.id(), to.id());
+      transform_pair_map_t::const_iterator i
+        = _pair_transforms.find(transform_pair_key(from.id(), to.id()));
 
-      if (!e)
-        transform_cache_update(from, to);
+      if (i == _pair_transforms.end())
+        return transform_cache_update(from, to);
 
-      return *e;
+      return i->second;
+    }
+
+    math::Transform<3> system::compose_transform(const Element &from, const Element &to) const
+    {
+      math::Transform<3> t(get_global_transform(from));
+      t.compose(get_local_transform(to));
+
+      return t;
     }
 
     const math::Transform<3> & system::get_global_transform(const Element &from) const
     {
-      math::Transform<3> * &e = transform_cache_entry(from.id(), 0);
+      const transform_entry_s &e = _transforms[from.id()];
 
-      if (!e)
-        transform_l2g_cache_update(from);
+      if (!e._l2g_valid)
+        return transform_l2g_cache_update(from);
 
-      return *e;
+      return e._l2g;
     }
 
     const math::Transform<3> & system::get_local_transform(const Element &to) const
     {
-      math::Transform<3> * &e = transform_cache_entry(0, to.id());
+      const transform_entry_s &e = _transforms[to.id()];
 
-      if (!e)
-        transform_g2l_cache_update(to);
+      if (!e._g2l_valid)
+        return transform_g2l_cache_update(to);
 
-      return *e;
+      return e._g2l;
     }
 
     void system::update_version()
@@ -135,6 +144,13 @@ namespace _goptical {
       return _e_count - 1;
     }
 
+    bool system::is_frozen() const
+    {
+      // _frozen_version is system version + 1, 0 when not frozen
+      return _frozen_version.load(std::memory_order_acquire) == _version + 1 &&
+        _frozen_data_version.load(std::memory_order_relaxed) == get_data_version();
+    }
+
     Element & system::get_element(unsigned int index) const
     {
       assert(index > 0 && index <= _e_count);
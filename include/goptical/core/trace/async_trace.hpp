@@ -0,0 +1,122 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+#ifndef GOPTICAL_TRACE_ASYNC_TRACE_HH_
+#define GOPTICAL_TRACE_ASYNC_TRACE_HH_
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+
+#include "goptical/core/common.hpp"
+
+#include "goptical/core/sys/element.hpp"
+
+namespace _goptical {
+
+  namespace trace {
+
+    /**
+       @short Handle of a ray trace running in background
+       @header <goptical/core/trace/AsyncTrace
+       @module {Core}
+
+       This class is returned by @ref tracer::trace_async. It can be
+       used to poll progress, request cancellation and wait for
+       completion of the trace. Copies of a handle refer to the same
+       trace.
+
+       Cancellation is cooperative: the tracer checks for it between
+       rays batches, so a canceled trace may take some time to
+       stop. Result content is incomplete when the trace has been
+       canceled.
+    */
+    class AsyncTrace
+    {
+      friend class tracer;
+
+    public:
+      /** Function called from the trace thread when the trace has
+          completed, has been canceled or has failed. The trace is
+          already done when the function is called, @ref
+          tracer::trace_async details what the function may do. */
+      typedef std::function<void (const AsyncTrace &)> completion_t;
+
+      /** Create an invalid handle */
+      AsyncTrace();
+
+      /** Test if handle refers to a trace */
+      inline bool valid() const;
+
+      /** Test if trace has completed */
+      bool is_done() const;
+
+      /** Wait for trace completion */
+      void wait() const;
+
+      /** Wait for trace completion and rethrow exception thrown by
+          the trace if any */
+      void get() const;
+
+      /** Request trace cancellation */
+      inline void cancel();
+
+      /** Test if trace has been stopped before completion because
+          of a cancellation request */
+      bool is_canceled() const;
+
+      /** Get number of rays processed so far by an element. This is
+          the number of generated rays for sources, the number of
+          incoming rays for other elements in sequential mode and
+          the number of intercepted rays in non sequential mode. */
+      inline size_t get_processed_count(const sys::Element &e) const;
+
+    private:
+      struct state_s
+      {
+        state_s(unsigned int element_count, const completion_t &completion);
+
+        std::unique_ptr<std::atomic<size_t>[]> _processed; // indexed by element id
+        unsigned int            _element_count;
+        std::atomic<bool>       _cancel;
+        mutable std::mutex      _lock;
+        std::condition_variable _cond;
+        bool                    _done;
+        bool                    _canceled;
+        std::exception_ptr      _error;
+        completion_t            _completion;
+      };
+
+      AsyncTrace(const std::shared_ptr<state_s> &state);
+
+      std::shared_ptr<state_s>  _state;
+    };
+
+  }
+}
+
+#endif
+
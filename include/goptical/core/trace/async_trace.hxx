@@ -0,0 +1,57 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+#ifndef GOPTICAL_TRACE_ASYNC_TRACE_HXX_
+#define GOPTICAL_TRACE_ASYNC_TRACE_HXX_
+
+#include "goptical/core/sys/element.hxx"
+
+namespace _goptical {
+
+  namespace trace {
+
+    bool AsyncTrace::valid() const
+    {
+      return _state != nullptr;
+    }
+
+    void AsyncTrace::cancel()
+    {
+      _state->_cancel = true;
+    }
+
+    size_t AsyncTrace::get_processed_count(const sys::Element &e) const
+    {
+      unsigned int id = e.id();
+
+      if (id >= _state->_element_count)
+        return 0;
+
+      return _state->_processed[id].load(std::memory_order_relaxed);
+    }
+
+  }
+}
+
+#endif
+
@@ -0,0 +1,119 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#ifndef GOPTICAL_TRACE_BOUNDED_QUEUE_HH_
+#define GOPTICAL_TRACE_BOUNDED_QUEUE_HH_
+
+#include <vector>
+#include <atomic>
+
+#include "goptical/core/common.hpp"
+
+namespace _goptical {
+
+  namespace trace {
+
+    /**
+       @short Lock free single producer single consumer queue
+       @header <goptical/core/trace/bounded_queue.hpp
+       @module {Core}
+       @internal
+
+       This class implements a fixed capacity ring buffer which can
+       be used to pass items from one thread to an other without
+       locking. Only one thread may push items and only one thread
+       may pop items.
+    */
+    template <typename T>
+    class BoundedQueue
+    {
+    public:
+      /** Create a queue able to hold @tt size items */
+      inline BoundedQueue(size_t size);
+
+      /** Append an item, return false if the queue is full */
+      inline bool push(const T &item);
+
+      /** Remove first item, return false if the queue is empty */
+      inline bool pop(T &item);
+
+    private:
+      BoundedQueue(const BoundedQueue &);
+      BoundedQueue & operator=(const BoundedQueue &);
+
+      inline size_t next(size_t i) const;
+
+      std::vector<T>            _items;
+      std::atomic<size_t>       _head; // written by consumer
+      char                      _pad[64]; // keep indexes in separate cache lines
+      std::atomic<size_t>       _tail; // written by producer
+    };
+
+    template <typename T>
+    BoundedQueue<T>::BoundedQueue(size_t size)
+      : _items(size + 1),
+        _head(0),
+        _tail(0)
+    {
+    }
+
+    template <typename T>
+    size_t BoundedQueue<T>::next(size_t i) const
+    {
+      return i + 1 == _items.size() ? 0 : i + 1;
+    }
+
+    template <typename T>
+    bool BoundedQueue<T>::push(const T &item)
+    {
+      size_t tail = _tail.load(std::memory_order_relaxed);
+      size_t n = next(tail);
+
+      if (n == _head.load(std::memory_order_acquire))
+        return false;
+
+      _items[tail] = item;
+      _tail.store(n, std::memory_order_release);
+      return true;
+    }
+
+    template <typename T>
+    bool BoundedQueue<T>::pop(T &item)
+    {
+      size_t head = _head.load(std::memory_order_relaxed);
+
+      if (head == _tail.load(std::memory_order_acquire))
+        return false;
+
+      item = _items[head];
+      _head.store(next(head), std::memory_order_release);
+      return true;
+    }
+
+  }
+}
+
+#endif
+
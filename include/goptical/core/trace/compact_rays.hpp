@@ -0,0 +1,136 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#ifndef GOPTICAL_TRACE_COMPACT_RAYS_HH_
+#define GOPTICAL_TRACE_COMPACT_RAYS_HH_
+
+#include <vector>
+#include <stdint.h>
+
+#include "goptical/core/common.hpp"
+
+#include "goptical/core/math/vector.hpp"
+
+namespace _goptical {
+
+  namespace trace {
+
+    /**
+       @short Compact copy of traced rays
+       @header <goptical/core/trace/CompactRays
+       @module {Core}
+
+       This class stores a copy of all rays allocated in a @ref
+       Result object using a compact layout. Links between rays are
+       stored as 32 bits indexes in the rays table and elements and
+       materials are stored as 16 bits identifiers. Elements
+       identifiers are system element ids and materials identifiers
+       are indexes in a table built along with rays. Wavelens are
+       stored as 16 bits indexes in a wavelens table which starts with
+       the result declared wavelens, see @ref Ray::get_wavelen_index.
+
+       Positions, directions, intensities and lengths are stored using
+       the @tt P template parameter type. Records are 120 bytes with
+       @tt double, @tt float can be used to get 68 bytes records
+       against 160 bytes for @ref Ray at the expense of precision.
+
+       The copy is built after tracing, for keeping or exporting large
+       results: the @ref Result rays are not affected and peak memory
+       usage during the trace is not reduced. Once the copy is made,
+       the result can be cleared or destroyed to release its rays.
+    */
+    template <typename P = double>
+    class CompactRays
+    {
+    public:
+      /** Invalid ray index */
+      static const uint32_t none = 0xffffffff;
+      /** Invalid element or material identifier */
+      static const uint16_t no_id = 0xffff;
+
+      /** Compact ray record */
+      struct ray_s
+      {
+        P               _origin[3];
+        P               _direction[3];
+        P               _point[3];      // surface local coordinates
+        P               _intensity;
+        P               _intercept_intensity;
+        P               _len;
+        uint32_t        _parent;
+        uint32_t        _child;
+        uint32_t        _next;
+        uint16_t        _creator;
+        uint16_t        _element;       // no_id if ray is lost
+        uint16_t        _material;
+        uint16_t        _wavelen;       // index in wavelens table
+      };
+
+      /** Copy all rays of a trace result. Streaming mode results
+          can not be copied as rays are recycled. */
+      CompactRays(const Result &result);
+
+      /** Get number of rays */
+      inline unsigned int get_count() const;
+
+      /** Get ray record */
+      inline const ray_s & get_ray(unsigned int index) const;
+
+      /** Get ray creator element */
+      inline const sys::Element * get_creator(unsigned int index) const;
+
+      /** Get ray interception element, null if ray is lost */
+      inline const sys::Element * get_intercept_element(unsigned int index) const;
+
+      /** Get ray material */
+      inline const material::Base * get_material(unsigned int index) const;
+
+      /** Get ray wavelen */
+      inline double get_wavelen(unsigned int index) const;
+
+      /** Get ray interception point in surface local coordinates */
+      inline math::Vector3 get_intercept_point(unsigned int index) const;
+
+      /** Get materials table */
+      inline const std::vector<const material::Base *> & get_materials() const;
+
+      /** Get wavelens table */
+      inline const std::vector<double> & get_wavelens() const;
+
+    private:
+      uint16_t element_id(const sys::Element *e);
+      uint16_t material_id(const material::Base *m);
+      uint16_t wavelen_id(const Ray &r);
+
+      const sys::system                 *_system;
+      std::vector<ray_s>                _rays;
+      std::vector<const material::Base *> _materials;
+      std::vector<double>               _wavelens;
+    };
+
+  }
+}
+
+#endif
@@ -0,0 +1,203 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#ifndef GOPTICAL_TRACE_COMPACT_RAYS_HXX_
+#define GOPTICAL_TRACE_COMPACT_RAYS_HXX_
+
+#include "goptical/core/error.hpp"
+#include "goptical/core/trace/result.hxx"
+#include "goptical/core/sys/system.hxx"
+
+namespace _goptical {
+
+  namespace trace {
+
+    template <typename P>
+    CompactRays<P>::CompactRays(const Result &result)
+      : _system(result._system),
+        _rays(),
+        _materials(),
+        _wavelens(result._wavelen_list)
+    {
+      if (result._streaming)
+        throw Error("can not copy rays of a streaming mode result");
+
+      if (result._rays.size() >= none)
+        throw Error("too many rays for compact representation");
+
+      // ray index is its position in arena
+      RayArena::Positions positions(result._rays);
+
+      auto ray_index = [&](const Ray *r) -> uint32_t
+        {
+          size_t i = r ? positions.find(r) : RayArena::Positions::none;
+
+          return i == RayArena::Positions::none ? none : i;
+        };
+
+      _rays.resize(result._rays.size());
+
+      unsigned int i = 0;
+
+      for (const Ray &r : result._rays)
+        {
+          ray_s &c = _rays[i++];
+
+          for (unsigned int j = 0; j < 3; j++)
+            {
+              c._origin[j] = r.origin()[j];
+              c._direction[j] = r.direction()[j];
+              c._point[j] = r.get_intercept_point()[j];
+            }
+
+          c._wavelen = wavelen_id(r);
+          c._intensity = r.get_intensity();
+          c._intercept_intensity = r.get_intercept_intensity();
+          c._len = r.get_len();
+          c._parent = ray_index(r.get_parent());
+          c._child = ray_index(r.get_first_child());
+          // sibling link is only meaningful for generated rays
+          c._next = r.get_parent() ? ray_index(r.get_next_child()) : none;
+          c._creator = element_id(r.get_creator());
+          c._element = r.is_lost() ? no_id : element_id(&r.get_intercept_element());
+          c._material = material_id(r.get_material());
+        }
+    }
+
+    template <typename P>
+    uint16_t CompactRays<P>::element_id(const sys::Element *e)
+    {
+      if (!e)
+        return no_id;
+
+      if (e->id() >= no_id)
+        throw Error("too many elements for compact representation");
+
+      return e->id();
+    }
+
+    template <typename P>
+    uint16_t CompactRays<P>::material_id(const material::Base *m)
+    {
+      if (!m)
+        return no_id;
+
+      for (unsigned int i = 0; i < _materials.size(); i++)
+        if (_materials[i] == m)
+          return i;
+
+      if (_materials.size() >= no_id)
+        throw Error("too many materials for compact representation");
+
+      _materials.push_back(m);
+      return _materials.size() - 1;
+    }
+
+    template <typename P>
+    uint16_t CompactRays<P>::wavelen_id(const Ray &r)
+    {
+      unsigned int i = r.get_wavelen_index();
+
+      // declared wavelens keep their result index
+      if (i < _wavelens.size() && _wavelens[i] == r.get_wavelen())
+        return i;
+
+      for (i = 0; i < _wavelens.size(); i++)
+        if (_wavelens[i] == r.get_wavelen())
+          return i;
+
+      if (_wavelens.size() >= no_id)
+        throw Error("too many wavelens for compact representation");
+
+      _wavelens.push_back(r.get_wavelen());
+      return _wavelens.size() - 1;
+    }
+
+    template <typename P>
+    unsigned int CompactRays<P>::get_count() const
+    {
+      return _rays.size();
+    }
+
+    template <typename P>
+    const typename CompactRays<P>::ray_s & CompactRays<P>::get_ray(unsigned int index) const
+    {
+      return _rays[index];
+    }
+
+    template <typename P>
+    const sys::Element * CompactRays<P>::get_creator(unsigned int index) const
+    {
+      uint16_t id = _rays[index]._creator;
+
+      return id == no_id ? 0 : &_system->get_element(id);
+    }
+
+    template <typename P>
+    const sys::Element * CompactRays<P>::get_intercept_element(unsigned int index) const
+    {
+      uint16_t id = _rays[index]._element;
+
+      return id == no_id ? 0 : &_system->get_element(id);
+    }
+
+    template <typename P>
+    const material::Base * CompactRays<P>::get_material(unsigned int index) const
+    {
+      uint16_t id = _rays[index]._material;
+
+      return id == no_id ? 0 : _materials[id];
+    }
+
+    template <typename P>
+    double CompactRays<P>::get_wavelen(unsigned int index) const
+    {
+      return _wavelens[_rays[index]._wavelen];
+    }
+
+    template <typename P>
+    math::Vector3 CompactRays<P>::get_intercept_point(unsigned int index) const
+    {
+      const P *p = _rays[index]._point;
+
+      return math::Vector3(p[0], p[1], p[2]);
+    }
+
+    template <typename P>
+    const std::vector<const material::Base *> & CompactRays<P>::get_materials() const
+    {
+      return _materials;
+    }
+
+    template <typename P>
+    const std::vector<double> & CompactRays<P>::get_wavelens() const
+    {
+      return _wavelens;
+    }
+
+  }
+}
+
+#endif
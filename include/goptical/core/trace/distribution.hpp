@@ -46,6 +46,9 @@ namespace _goptical
        Ray density is expressed as average number of rays along
        surface radius.
 
+       Random and low discrepancy patterns depend on a seed value
+       only, the same points are generated on each trace.
+
        @image dist_patterns.png {Different patterns rendered on a disk with default density}
      */
 
@@ -59,7 +62,8 @@ namespace _goptical
           distributing rays too close to the surface edge. */
       inline Distribution(Pattern pattern = DefaultDist,
                           unsigned int radial_density = 5,
-                          double scaling = 0.999);
+                          double scaling = 0.999,
+                          unsigned int seed = 0);
 
       /** Set distribution pattern */
       inline void set_pattern(Pattern p);
@@ -81,15 +85,25 @@ namespace _goptical
       /** get current scaling */
       inline double get_scaling() const;
 
+      /** Set seed used by random and low discrepancy patterns */
+      inline void set_seed(unsigned int seed);
+
+      /** Get current seed */
+      inline unsigned int get_seed() const;
+
       /** Ensure uniform 2d pattern suitable for spot diagram and
           image analysis is selected. Change to default pattern if
           not. */
       inline void set_uniform_pattern();
 
+      /** Test if two distributions generate the same points */
+      inline bool operator==(const Distribution &d) const;
+
     private:
       Pattern           _pattern;
       unsigned int      _radial_density;
       double            _scaling;
+      unsigned int      _seed;
     };
   }
 }
@@ -36,10 +36,12 @@ namespace _goptical
 
     Distribution::Distribution(Pattern pattern,
                                unsigned int radial_density,
-                               double scaling)
+                               double scaling,
+                               unsigned int seed)
     : _pattern(pattern),
       _radial_density(radial_density),
-      _scaling(scaling)
+      _scaling(scaling),
+      _seed(seed)
     {
       if (radial_density < 1)
         throw Error("ray distribution radial density must be greater than 1");
@@ -75,6 +77,22 @@ namespace _goptical
       _scaling = margin;
     }
 
+    unsigned int Distribution::get_seed() const
+    {
+      return _seed;
+    }
+
+    void Distribution::set_seed(unsigned int seed)
+    {
+      _seed = seed;
+    }
+
+    bool Distribution::operator==(const Distribution &d) const
+    {
+      return _pattern == d._pattern && _radial_density == d._radial_density &&
+        _scaling == d._scaling && _seed == d._seed;
+    }
+
     void Distribution::set_uniform_pattern()
     {
       switch (_pattern)
@@ -75,6 +75,18 @@ namespace _goptical {
       GOPTICAL_ACCESSORS(PropagationMode, propagation_mode,
         "physical light propagation mode. @experimental @hidden");
 
+      GOPTICAL_ACCESSORS(unsigned int, thread_count,
+        "ray tracing worker threads count, 0 for all cpus, default is 1");
+
+      GOPTICAL_ACCESSORS(PrecisionMode, precision_mode,
+        "floating point precision of rays intersections in sequential mode, default is DoublePrecision");
+
+      GOPTICAL_ACCESSORS(bool, incremental_retrace,
+        "sequential trace restarts from the first element modified since previous trace, default is false");
+
+      GOPTICAL_ACCESSORS(bool, pipelined_trace,
+        "sequential trace runs groups of consecutive elements as pipeline stages in worker threads, default is false");
+
       /** Set sequential ray tracing mode */
       inline void set_sequential_mode(const const_ref<Sequence> &seq);
 
@@ -105,6 +117,10 @@ namespace _goptical {
       PropagationMode           _propagation_mode;
       bool                      _unobstructed;
       double                    _lost_ray_length;
+      unsigned int              _thread_count;
+      PrecisionMode             _precision_mode;
+      bool                      _incremental_retrace;
+      bool                      _pipelined_trace;
     };
   }
 }
@@ -42,7 +42,11 @@ namespace _goptical {
         _sequential_mode(false),
         _propagation_mode(RayPropagation),
         _unobstructed(false),
-        _lost_ray_length(1000)
+        _lost_ray_length(1000),
+        _thread_count(1),
+        _precision_mode(DoublePrecision),
+        _incremental_retrace(false),
+        _pipelined_trace(false)
     {
     }
 
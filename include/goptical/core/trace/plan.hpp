@@ -0,0 +1,93 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#ifndef GOPTICAL_TRACE_PLAN_HH_
+#define GOPTICAL_TRACE_PLAN_HH_
+
+#include <vector>
+
+#include "goptical/core/common.hpp"
+
+#include "goptical/core/math/transform.hpp"
+
+namespace _goptical {
+
+  namespace trace {
+
+    /**
+       @short Precompiled sequential light propagation plan
+       @header <goptical/core/trace/Plan
+       @module {Core}
+
+       This class holds the enabled elements of a @ref Sequence in
+       order, along with the transform from the previous element
+       local coordinates resolved once for each element. Surfaces
+       bind their curve and shape functions by themselves.
+
+       A plan is only valid for the system version it was built
+       with. The @ref tracer class rebuilds its plan when the system
+       or sequence is modified.
+    */
+    class Plan
+    {
+    public:
+      /** Element record */
+      struct step_s
+      {
+        const sys::Element      *_element;
+        /** not null if element is a source */
+        const sys::Source       *_source;
+        /** previous enabled element in sequence, may be null */
+        const sys::Element      *_previous;
+        /** transform from previous element local coordinates */
+        math::Transform<3>      _transform;
+      };
+
+      /** Build plan for given system and sequence. Throw if
+          sequence contains an element which is not part of the system */
+      Plan(const sys::system &system, const Sequence &sequence);
+
+      /** Test if plan was built from the same system version and
+          sequence content */
+      bool is_valid(const sys::system &system, const Sequence &sequence) const;
+
+      /** Get element records in sequence order */
+      inline const std::vector<step_s> & get_steps() const;
+
+      /** Get first non source element of the sequence, may be null */
+      inline const sys::Element * get_entrance() const;
+
+    private:
+      const sys::system         *_system;
+      unsigned int              _version;
+      std::vector<const sys::Element *> _sequence;
+      const sys::Element        *_entrance;
+      std::vector<step_s>       _steps;
+    };
+
+  }
+}
+
+#endif
@@ -61,6 +61,12 @@ namespace _goptical {
 
       GOPTICAL_ACCESSORS(double, len, "light ray length.");
 
+      /** Wavelen index value of rays which wavelen has not been
+          declared to the @ref Result object */
+      static const unsigned int no_wavelen_index = 0xffff;
+
+      GOPTICAL_ACCESSORS(unsigned int, wavelen_index, "index of ray wavelen in result wavelen list.");
+
       /** Define a new child generated ray */
       inline void add_generated(trace::Ray *r);
 
@@ -92,6 +98,14 @@ namespace _goptical {
       inline math::Vector3 get_direction(const sys::Element &e) const;
 
     private:
+      friend class Result;
+
+      /** Detach ray from its parent and children rays */
+      inline void unlink();
+      /** Forget interception and generated rays, generated rays
+          are left untouched */
+      inline void reset_intercept();
+
       Ray(const Ray &);
       const Ray & operator=(const Ray &r);
 
@@ -105,6 +119,7 @@ namespace _goptical {
       Ray                       *_child;        // pointer to generated ray
       Ray                       *_next;         // pointer to sibling generated ray
       bool                      _lost;          // does the ray intersect with an element ?
+      unsigned short            _wavelen_index; // index in result wavelen list
     };
 
   }
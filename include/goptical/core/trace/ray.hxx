@@ -48,7 +48,8 @@ namespace _goptical {
         _creator(0),
         _parent(0),
         _child(0),
-        _lost(true)
+        _lost(true),
+        _wavelen_index(no_wavelen_index)
     {
     }
 
@@ -58,7 +59,8 @@ namespace _goptical {
         _creator(0),
         _parent(0),
         _child(0),
-        _lost(true)
+        _lost(true),
+        _wavelen_index(no_wavelen_index)
     {
     }
 
@@ -70,6 +72,32 @@ namespace _goptical {
       _child = r;
     }
 
+    void Ray::unlink()
+    {
+      for (Ray *c = _child; c; c = c->_next)
+        c->_parent = 0;
+
+      _child = 0;
+
+      if (_parent)
+        {
+          Ray **r;
+
+          for (r = &_parent->_child; *r != this; r = &(*r)->_next)
+            ;
+
+          *r = _next;
+          _parent = 0;
+        }
+    }
+
+    void Ray::reset_intercept()
+    {
+      _len = std::numeric_limits<double>::max();
+      _child = 0;
+      _lost = true;
+    }
+
     void Ray::set_intercept(const sys::Element &e, const math::Vector3 &point)
     {
       _i_element = (sys::Element*)&e;
@@ -0,0 +1,185 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+#ifndef GOPTICAL_TRACE_RAY_ARENA_HH_
+#define GOPTICAL_TRACE_RAY_ARENA_HH_
+
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+#include "goptical/core/common.hpp"
+
+#include "goptical/core/trace/ray.hpp"
+
+namespace _goptical {
+
+  namespace trace {
+
+    /**
+       @short Rays allocation arena
+       @header <goptical/core/trace/RayArena
+       @module {Core}
+
+       This class allocates @ref Ray objects in fixed size storage
+       blocks. Allocation does not involve any synchronization, a
+       separate arena is used by each tracing thread.
+
+       Rays never move once allocated. Rays of an arena can be moved
+       to an other arena with @ref splice, which only moves blocks
+       pointers.
+    */
+    class RayArena
+    {
+      struct block_s
+      {
+        Ray             *_rays;
+        unsigned int    _count;
+      };
+
+      typedef std::vector<block_s> block_list_t;
+
+      /** @internal Iterate over rays of all blocks */
+      template <typename X>
+      class iterator_
+      {
+      public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef X value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef X * pointer;
+        typedef X & reference;
+
+        inline iterator_(const block_s *block, unsigned int i);
+
+        inline X & operator*() const;
+        inline X * operator->() const;
+        inline iterator_ & operator++();
+        inline bool operator==(const iterator_ &i) const;
+        inline bool operator!=(const iterator_ &i) const;
+
+      private:
+        const block_s   *_block;
+        unsigned int    _i;
+      };
+
+    public:
+      /** Arena allocation state, see @ref get_mark */
+      struct mark_s
+      {
+        size_t          _blocks;
+        unsigned int    _count;
+        size_t          _size;
+      };
+
+      typedef iterator_<Ray> iterator;
+      typedef iterator_<const Ray> const_iterator;
+
+      /** Rays position lookup table. Find position of rays in
+          arena iteration order from their address, lookup time is
+          logarithmic in blocks count. The arena must not be
+          modified while the table is in use. */
+      class Positions
+      {
+      public:
+        /** Invalid position */
+        static const size_t none = (size_t)-1;
+
+        Positions(const RayArena &arena);
+
+        /** Get ray position, @ref none if the ray is not in arena */
+        size_t find(const Ray *ray) const;
+
+      private:
+        struct entry_s
+        {
+          const Ray     *_rays;
+          unsigned int  _count;
+          size_t        _first;
+        };
+
+        std::vector<entry_s> _blocks; // sorted by address
+      };
+
+      /** Number of rays in a storage block */
+      static const unsigned int block_size = 1024;
+
+      RayArena();
+      ~RayArena();
+
+      /** Allocate and construct a new ray */
+      inline Ray & create();
+      /** Allocate and construct a new ray from a light ray */
+      inline Ray & create(const light::Ray &ray);
+
+      /** Get number of rays in arena */
+      inline size_t size() const;
+      /** Test if arena is empty */
+      inline bool empty() const;
+
+      /** Destroy all rays, storage blocks are kept for reuse */
+      void clear();
+      /** Free storage blocks not in use */
+      void shrink();
+      /** Allocate storage blocks so that at least @tt count rays
+          can be added without further memory allocation */
+      void reserve(size_t count);
+      /** Get number of rays which can be held by allocated blocks */
+      inline size_t capacity() const;
+      /** Move unused storage blocks to an other arena until it can
+          hold at least @tt count rays */
+      void move_spare(RayArena &other, size_t count);
+
+      /** Get current allocation state */
+      inline mark_s get_mark() const;
+      /** Destroy all rays allocated after the given mark was taken.
+          Rays spliced in after the mark are destroyed as well. */
+      void truncate(const mark_s &mark);
+
+      /** Move all rays of an other arena at end of this arena. Rays
+          are not copied and pointers to them remain valid. */
+      void splice(RayArena &other);
+
+      inline iterator begin();
+      inline iterator end();
+      inline const_iterator begin() const;
+      inline const_iterator end() const;
+
+    private:
+      RayArena(const RayArena &);
+      RayArena & operator=(const RayArena &);
+
+      inline Ray * alloc();
+      void add_block();
+      /** Get number of rays which can be allocated from free storage */
+      size_t available() const;
+
+      block_list_t        _blocks; // blocks holding rays, last one is filled first
+      std::vector<Ray *>  _spare;  // empty blocks
+      size_t              _size;
+    };
+
+  }
+}
+
+#endif
@@ -0,0 +1,148 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+#ifndef GOPTICAL_TRACE_RAY_ARENA_HXX_
+#define GOPTICAL_TRACE_RAY_ARENA_HXX_
+
+#include <new>
+
+#include "goptical/core/trace/ray.hxx"
+
+namespace _goptical {
+
+  namespace trace {
+
+    template <typename X>
+    RayArena::iterator_<X>::iterator_(const block_s *block, unsigned int i)
+      : _block(block),
+        _i(i)
+    {
+    }
+
+    template <typename X>
+    X & RayArena::iterator_<X>::operator*() const
+    {
+      return _block->_rays[_i];
+    }
+
+    template <typename X>
+    X * RayArena::iterator_<X>::operator->() const
+    {
+      return _block->_rays + _i;
+    }
+
+    template <typename X>
+    RayArena::iterator_<X> & RayArena::iterator_<X>::operator++()
+    {
+      if (++_i == _block->_count)
+        {
+          _block++;
+          _i = 0;
+        }
+
+      return *this;
+    }
+
+    template <typename X>
+    bool RayArena::iterator_<X>::operator==(const iterator_ &i) const
+    {
+      return _block == i._block && _i == i._i;
+    }
+
+    template <typename X>
+    bool RayArena::iterator_<X>::operator!=(const iterator_ &i) const
+    {
+      return _block != i._block || _i != i._i;
+    }
+
+    Ray * RayArena::alloc()
+    {
+      if (_blocks.empty() || _blocks.back()._count == block_size)
+        add_block();
+
+      block_s &b = _blocks.back();
+      _size++;
+
+      return b._rays + b._count++;
+    }
+
+    Ray & RayArena::create()
+    {
+      return *new (alloc()) Ray();
+    }
+
+    Ray & RayArena::create(const light::Ray &ray)
+    {
+      return *new (alloc()) Ray(ray);
+    }
+
+    size_t RayArena::size() const
+    {
+      return _size;
+    }
+
+    bool RayArena::empty() const
+    {
+      return _size == 0;
+    }
+
+    size_t RayArena::capacity() const
+    {
+      return (_blocks.size() + _spare.size()) * block_size;
+    }
+
+    RayArena::mark_s RayArena::get_mark() const
+    {
+      mark_s m;
+
+      m._blocks = _blocks.size();
+      m._count = _blocks.empty() ? 0 : _blocks.back()._count;
+      m._size = _size;
+
+      return m;
+    }
+
+    RayArena::iterator RayArena::begin()
+    {
+      return iterator(_blocks.data(), 0);
+    }
+
+    RayArena::iterator RayArena::end()
+    {
+      return iterator(_blocks.data() + _blocks.size(), 0);
+    }
+
+    RayArena::const_iterator RayArena::begin() const
+    {
+      return const_iterator(_blocks.data(), 0);
+    }
+
+    RayArena::const_iterator RayArena::end() const
+    {
+      return const_iterator(_blocks.data() + _blocks.size(), 0);
+    }
+
+  }
+}
+
+#endif
@@ -0,0 +1,101 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#ifndef GOPTICAL_TRACE_RAY_BUFFER_HH_
+#define GOPTICAL_TRACE_RAY_BUFFER_HH_
+
+#include <vector>
+
+#include "goptical/core/common.hpp"
+
+namespace _goptical {
+
+  namespace trace {
+
+    /**
+       @short Contiguous list of rays
+       @header <goptical/core/trace/RayBuffer
+       @module {Core}
+
+       This class stores pointers to rays in contiguous memory. It
+       can be iterated like a @ref std::vector and used as a first
+       in first out queue.
+
+       Storage is never released when the buffer is cleared or
+       emptied so that buffers can be reused without memory
+       allocation. Entries removed from the front are reclaimed when
+       the buffer becomes empty.
+    */
+    class RayBuffer
+    {
+      typedef std::vector<Ray *> vector_t;
+
+    public:
+      typedef Ray * value_type;
+      typedef vector_t::iterator iterator;
+      typedef vector_t::const_iterator const_iterator;
+      typedef vector_t::size_type size_type;
+
+      inline RayBuffer();
+
+      /** Get number of rays in buffer */
+      inline size_type size() const;
+      /** Test if buffer is empty */
+      inline bool empty() const;
+      /** Preallocate storage for given number of rays */
+      inline void reserve(size_type count);
+      /** Remove all rays, storage is kept */
+      inline void clear();
+
+      inline iterator begin();
+      inline iterator end();
+      inline const_iterator begin() const;
+      inline const_iterator end() const;
+
+      inline Ray * operator[](size_type i) const;
+      inline Ray * front() const;
+      inline Ray * back() const;
+
+      /** Append a ray at end of buffer */
+      inline void push_back(Ray *ray);
+      /** Remove first ray of buffer */
+      inline void pop_front();
+
+      /** Append a range of rays at end of buffer */
+      template <typename I>
+      inline void append(I first, I last);
+      /** Replace buffer content with a range of rays */
+      template <typename I>
+      inline void assign(I first, I last);
+
+    private:
+      vector_t          _rays;
+      size_type         _head;
+    };
+
+  }
+}
+
+#endif
@@ -0,0 +1,128 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#ifndef GOPTICAL_TRACE_RAY_BUFFER_HXX_
+#define GOPTICAL_TRACE_RAY_BUFFER_HXX_
+
+#include <cassert>
+
+namespace _goptical {
+
+  namespace trace {
+
+    RayBuffer::RayBuffer()
+      : _rays(),
+        _head(0)
+    {
+    }
+
+    RayBuffer::size_type RayBuffer::size() const
+    {
+      return _rays.size() - _head;
+    }
+
+    bool RayBuffer::empty() const
+    {
+      return _rays.size() == _head;
+    }
+
+    void RayBuffer::reserve(size_type count)
+    {
+      _rays.reserve(_head + count);
+    }
+
+    void RayBuffer::clear()
+    {
+      _rays.clear();
+      _head = 0;
+    }
+
+    RayBuffer::iterator RayBuffer::begin()
+    {
+      return _rays.begin() + _head;
+    }
+
+    RayBuffer::iterator RayBuffer::end()
+    {
+      return _rays.end();
+    }
+
+    RayBuffer::const_iterator RayBuffer::begin() const
+    {
+      return _rays.begin() + _head;
+    }
+
+    RayBuffer::const_iterator RayBuffer::end() const
+    {
+      return _rays.end();
+    }
+
+    Ray * RayBuffer::operator[](size_type i) const
+    {
+      return _rays[_head + i];
+    }
+
+    Ray * RayBuffer::front() const
+    {
+      assert(!empty());
+      return _rays[_head];
+    }
+
+    Ray * RayBuffer::back() const
+    {
+      assert(!empty());
+      return _rays.back();
+    }
+
+    void RayBuffer::push_back(Ray *ray)
+    {
+      _rays.push_back(ray);
+    }
+
+    void RayBuffer::pop_front()
+    {
+      assert(!empty());
+
+      if (++_head == _rays.size())
+        clear();
+    }
+
+    template <typename I>
+    void RayBuffer::append(I first, I last)
+    {
+      _rays.insert(_rays.end(), first, last);
+    }
+
+    template <typename I>
+    void RayBuffer::assign(I first, I last)
+    {
+      clear();
+      _rays.insert(_rays.end(), first, last);
+    }
+
+  }
+}
+
+#endif
@@ -0,0 +1,118 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#ifndef GOPTICAL_TRACE_RAY_PACKET_HH_
+#define GOPTICAL_TRACE_RAY_PACKET_HH_
+
+#include "goptical/core/common.hpp"
+
+#include "goptical/core/math/vector_pair.hpp"
+#include "goptical/core/math/transform.hpp"
+
+namespace _goptical {
+
+  namespace trace {
+
+    /**
+       @short Structure of arrays block of rays
+       @header <goptical/core/trace/RayPacket
+       @module {Core}
+
+       This class stores a small block of rays in structure of arrays
+       form so that a surface can process several rays with the same
+       operations. Coordinates are expressed in the local coordinates
+       of the surface processing the packet.
+
+       Arrays are indexed by axis first and by ray second. Only
+       entries below @ref get_count are valid. The @tt _hit array
+       tells which rays have a valid intersection point and normal.
+    */
+    class RayPacket
+    {
+    public:
+      /** Maximum number of rays in a packet */
+      static const unsigned int size = 16;
+
+      inline RayPacket();
+
+      /** Get number of rays in packet */
+      inline unsigned int get_count() const;
+
+      /** Test if packet is full */
+      inline bool is_full() const;
+
+      /** Remove all rays from packet */
+      inline void clear();
+
+      /** Add a ray to packet. Local ray line is computed later by
+          the @ref transform function. */
+      inline void add(Ray &ray);
+
+      /** Get ray at given packet index */
+      inline Ray & get_ray(unsigned int i) const;
+
+      /** Compute local incident rays lines for all rays in packet
+          using transform from rays creator to surface. */
+      void transform(const math::Transform<3> &t);
+
+      /** Compute single precision local incident rays lines from
+          lines computed by @ref transform. Origins are moved along
+          rays up to the entry in the sphere of given radius centered
+          on surface origin, so that rounding error does not depend
+          on distance to the rays creator. The sphere must contain
+          all intersection points. */
+      void narrow_local(double radius);
+
+      /** Get local incident ray line */
+      inline math::VectorPair3 get_local(unsigned int i) const;
+
+      /** Get intersection point and normal */
+      inline math::VectorPair3 get_intersect(unsigned int i) const;
+
+      /** Set intersection point and normal */
+      inline void set_intersect(unsigned int i, const math::VectorPair3 &pt);
+
+      alignas(32) double _origin[3][size];
+      alignas(32) double _direction[3][size];
+      alignas(32) double _point[3][size];
+      alignas(32) double _normal[3][size];
+      alignas(32) double _wavelen[size];
+      alignas(32) double _intensity[size];
+      alignas(32) float  _origin_f[3][size];
+      alignas(32) float  _direction_f[3][size];
+      alignas(32) float  _point_f[3][size];
+      unsigned int      _wavelen_index[size];
+      bool              _hit[size];
+      Ray               *_rays[size];
+
+    private:
+      unsigned int      _count;
+    };
+
+  }
+}
+
+#endif
+
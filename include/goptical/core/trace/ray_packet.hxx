@@ -0,0 +1,99 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#ifndef GOPTICAL_TRACE_RAY_PACKET_HXX_
+#define GOPTICAL_TRACE_RAY_PACKET_HXX_
+
+#include "goptical/core/trace/ray.hpp"
+#include "goptical/core/trace/ray.hxx"
+#include "goptical/core/math/vector_pair.hxx"
+
+namespace _goptical {
+
+  namespace trace {
+
+    RayPacket::RayPacket()
+      : _count(0)
+    {
+    }
+
+    unsigned int RayPacket::get_count() const
+    {
+      return _count;
+    }
+
+    bool RayPacket::is_full() const
+    {
+      return _count == size;
+    }
+
+    void RayPacket::clear()
+    {
+      _count = 0;
+    }
+
+    void RayPacket::add(Ray &ray)
+    {
+      assert(_count < size);
+
+      _rays[_count] = &ray;
+      _wavelen[_count] = ray.get_wavelen();
+      _wavelen_index[_count] = ray.get_wavelen_index();
+      _intensity[_count] = ray.get_intensity();
+      _hit[_count] = false;
+      _count++;
+    }
+
+    Ray & RayPacket::get_ray(unsigned int i) const
+    {
+      return *_rays[i];
+    }
+
+    math::VectorPair3 RayPacket::get_local(unsigned int i) const
+    {
+      return math::VectorPair3(_origin[0][i], _origin[1][i], _origin[2][i],
+                               _direction[0][i], _direction[1][i], _direction[2][i]);
+    }
+
+    math::VectorPair3 RayPacket::get_intersect(unsigned int i) const
+    {
+      return math::VectorPair3(_point[0][i], _point[1][i], _point[2][i],
+                               _normal[0][i], _normal[1][i], _normal[2][i]);
+    }
+
+    void RayPacket::set_intersect(unsigned int i, const math::VectorPair3 &pt)
+    {
+      for (unsigned int j = 0; j < 3; j++)
+        {
+          _point[j][i] = pt.origin()[j];
+          _normal[j][i] = pt.normal()[j];
+        }
+    }
+
+  }
+}
+
+#endif
+
@@ -27,14 +27,21 @@
 #define GOPTICAL_TRACE_RESULT_HH_
 
 #include <set>
+#include <unordered_map>
 #include <deque>
 #include <memory>
+#include <mutex>
+#include <functional>
 
 #include "goptical/core/common.hpp"
 
 #include "goptical/core/sys/element.hpp"
 #include "goptical/core/sys/surface.hpp"
 #include "goptical/core/trace/ray.hpp"
+#include "goptical/core/trace/ray_arena.hpp"
+#include "goptical/core/trace/ray_buffer.hpp"
+#include "goptical/core/trace/plan.hpp"
+#include "goptical/core/trace/spectral_table.hpp"
 
 namespace _goptical {
 
@@ -59,10 +66,16 @@ namespace _goptical {
     class Result
     {
       friend class tracer;
+      template <typename P> friend class CompactRays;
 
     public:
       typedef std::vector<const sys::Source *> sources_t;
 
+      /** Function called with rays intercepted by a surface in
+          streaming mode. Ray is only valid during the call and
+          has no parent or children rays. */
+      typedef std::function<void (const Ray &ray)> sink_t;
+
       /** Crate a new empty result object */
       Result();
 
@@ -101,7 +114,56 @@ namespace _goptical {
       /** Set all save states to false */
       void clear_save_states();
 
-      /** Get maximum intensity for a single ray FIXME */
+      /** Report rays intercepted by a surface to the given sink
+          function and enable streaming mode.
+
+          In streaming mode rays are recycled as soon as they have
+          been traced and their reflected/refracted rays have been
+          generated, so that memory usage only depends on the
+          number of rays in flight. Rays lists can not be saved in
+          this mode. When tracing with multiple threads, sinks may
+          be called from worker threads but calls are serialized. */
+      void set_intercepted_sink(const sys::Surface &s, const sink_t &sink);
+
+      /** Remove all sinks and disable streaming mode */
+      void clear_sinks();
+
+      /** Test if streaming mode is enabled */
+      inline bool is_streaming() const;
+
+      /** Keep rays storage and rays lists capacity when the result
+          is cleared between traces. Storage is then preallocated
+          from the largest rays count seen so far, see @ref
+          get_max_ray_count. Memory is released when disabled. */
+      void set_retain_capacity(bool retain = true);
+
+      /** Test if rays storage is kept between traces */
+      inline bool get_retain_capacity() const;
+
+      /** Get largest number of rays allocated by a single trace since
+          capacity retaining was enabled */
+      inline size_t get_max_ray_count() const;
+
+      /** Get largest difference between double and single precision
+          intersection points coordinates found when tracing with
+          @ref CheckPrecision mode */
+      inline double get_precision_error() const;
+
+      /** Get number of rays which intersect a surface in double
+          precision but not in single precision when tracing with
+          @ref CheckPrecision mode */
+      inline size_t get_precision_mismatch_count() const;
+
+      /** Get number of rays which have not been traced because the
+          non sequential bounce limit was reached, see @ref
+          Params::set_max_bounce */
+      inline unsigned int get_bounce_limit_count() const;
+
+      /** Update single precision check statistics */
+      inline void update_precision_error(double error, unsigned int mismatch_count);
+
+      /** Get maximum intensity for a single ray FIXME. Throw in
+          streaming mode as rays are not retained. */
       double get_max_ray_intensity() const;
 
       /* Get raytracing mode used FIXME */
@@ -113,28 +175,50 @@ namespace _goptical {
       /** Allocate a new trace::Ray object from result */
       inline Ray & new_ray(const light::Ray &r);
 
+      /** Ensure that @tt count rays can be allocated with @ref
+          new_ray without further memory allocation */
+      inline void reserve_rays(size_t count);
+
       /** Declare a new ray interception */
       inline void add_intercepted(const sys::Surface &s, Ray &ray);
       /** Declare a new ray generation */
       inline void add_generated(const sys::Element &s, Ray &ray);
 
-      /** Declare ray wavelen used for tracing */
-      inline void add_ray_wavelen(double wavelen);
+      /** Declare ray wavelen used for tracing and return its index
+          in declaration order, for use with @ref Ray::set_wavelen_index.
+          Wavelens declared once the index range is exhausted get
+          @ref Ray::no_wavelen_index, material properties of such
+          rays are not precomputed but evaluated for each ray. */
+      inline unsigned int add_ray_wavelen(double wavelen);
+
+      /** Get index of a declared ray wavelen, return @ref
+          Ray::no_wavelen_index if not declared or out of index range */
+      inline unsigned int get_ray_wavelen_index(double wavelen) const;
 
       /** Get ray wavelen in use set */
       inline const std::set<double> & get_ray_wavelen_set() const;
 
+      /** Get materials properties precomputed for declared wavelens */
+      inline const SpectralTable & get_spectral_table() const;
+
       /** Get reference to tracer parameters used */
       inline const Params & get_params() const;
 
+      /** Get transform between two elements local coordinates. The
+          transform precomputed in the sequential trace plan is used
+          when available, it is composed from per element transforms
+          otherwise. */
+      math::Transform<3> get_transform(const sys::Element &from,
+                                              const sys::Element &to) const;
+
       /** Draw all tangential rays using specified renderer. Only rays
           which end up hitting the image plane are drawn when @tt
-          hit_image is set. */
+          hit_image is set. Throw in streaming mode. */
       void draw_2d(io::Renderer &r, bool hit_image = false,
                    const sys::Element *ref = 0) const;
       /** Draw all rays using specified renderer. Only rays
           which end up hitting the image plane are drawn when @tt
-          hit_image is set.*/
+          hit_image is set. Throw in streaming mode. */
       void draw_3d(io::Renderer &r, bool hit_image = false,
                    const sys::Element *ref = 0) const;
 
@@ -144,6 +228,49 @@ namespace _goptical {
 
       void prepare();
 
+      /** Get result object used by a worker thread to allocate rays
+          when processing a batch in parallel. Rays allocated in
+          shards are owned by this result. */
+      Result & get_shard(unsigned int worker);
+      /** Allocate shard rays lists for elements which save rays in this result */
+      void init_shard_lists(Result &shard) const;
+      /** Move rays lists and counters of a shard to this result */
+      void merge_shard_lists(Result &shard);
+      /** Move rays allocated by all shards to this result, rays are
+          not copied so that lists and rays links remain valid.
+          Precision check statistics are merged too. */
+      void merge_shard_rays();
+      /** Get an empty rays list, reusing storage of released lists */
+      std::shared_ptr<rays_queue_t> new_list();
+      /** Release a rays list and keep its storage for reuse */
+      void release_list(std::shared_ptr<rays_queue_t> &list);
+
+      /** Destroy rays allocated after the given mark, drop sources
+          added after the given count and forget interception of
+          rays in the given list, so that they can be traced again */
+      void rewind(const RayArena::mark_s &mark, size_t source_count,
+                  const rays_queue_t &rays);
+
+      /** Update spectral table with wavelens declared since last update */
+      void update_spectral_table();
+
+      /** Spread recycled rays evenly between this result and its shards */
+      void balance_free_rays();
+
+      /** Report ray to sink if any and make it available for reuse
+          in streaming mode */
+      void recycle_ray(Ray &ray);
+      /** Report ray to sink if any and append it to the given list
+          of rays to be reused by an other result */
+      void recycle_ray(Ray &ray, std::vector<Ray *> &free_rays);
+      /** Make rays recycled by an other result available for reuse,
+          the list is cleared */
+      void reuse_rays(std::vector<Ray *> &free_rays);
+
+      /** Throw if rays storage holds recycled rays or will hold
+          recycled rays once traced, as in streaming mode */
+      void check_rays_retained() const;
+
       struct element_result_s
       {
         std::shared_ptr<rays_queue_t> 
@@ -152,19 +279,40 @@ namespace _goptical {
             _generated; // list of rays for each generator surfaces
         bool _save_intercepted_list;
         bool _save_generated_list;
+        sink_t _sink;
+        size_t _intercepted_max; // largest lists sizes, used to presize lists
+        size_t _generated_max;
       };
 
       inline struct element_result_s & get_element_result(const sys::Element &e);
       inline const struct element_result_s & get_element_result(const sys::Element &e) const;
 
-      vector_pool<Ray, 1024> _rays; // rays allocation pool
+      RayArena                  _rays; // rays allocation arena
       std::vector<struct element_result_s> _elements;
       std::set<double>          _wavelengths;
+      std::vector<double>       _wavelen_list; // wavelens in declaration order
+      std::unordered_map<double, unsigned int> _wavelen_index; // position in _wavelen_list
+      SpectralTable             _spectral_table;
+      const SpectralTable       *_spectral; // table shared with shards
       rays_queue_t              *_generated_queue;
+      size_t                    _generated_limit; // _generated_flush is called when queue size reaches limit
+      std::function<void ()>    _generated_flush;
       trace::Result::sources_t  _sources;
       unsigned int              _bounce_limit_count;
       const sys::system         *_system;
       const trace::Params       *_params;
+      std::vector<std::unique_ptr<Result> > _shards;
+      const Plan::step_s        *_plan_step;
+      bool                      _streaming;
+      bool                      _retain_capacity;
+      size_t                    _max_ray_count;
+      unsigned int              _version; // changed on clear and save states update
+      double                    _precision_error;
+      size_t                    _precision_mismatch;
+      std::vector<Ray *>        _free_rays;
+      std::vector<std::shared_ptr<rays_queue_t> > _free_lists;
+      Result                    *_sink_result; // result which holds sinks
+      std::mutex                _sink_lock;
       //  tracer::Mode          _mode;
     };
   }
@@ -26,12 +26,17 @@
 #ifndef GOPTICAL_TRACE_RESULT_HXX_
 #define GOPTICAL_TRACE_RESULT_HXX_
 
+#include <algorithm>
 #include <cassert>
+#include <new>
 
 #include "goptical/core/error.hpp"
 #include "goptical/core/sys/element.hxx"
 #include "goptical/core/sys/surface.hxx"
 #include "goptical/core/trace/ray.hxx"
+#include "goptical/core/trace/ray_arena.hxx"
+#include "goptical/core/trace/ray_buffer.hxx"
+#include "goptical/core/trace/spectral_table.hxx"
 
 namespace _goptical {
 
@@ -88,9 +93,25 @@ namespace _goptical {
         er._generated->push_back(&ray);
     }
 
-    void Result::add_ray_wavelen(double wavelen)
+    unsigned int Result::add_ray_wavelen(double wavelen)
     {
-      _wavelengths.insert(wavelen);
+      if (_wavelen_index.insert(std::make_pair(wavelen, _wavelen_list.size())).second)
+        {
+          _wavelengths.insert(wavelen);
+          _wavelen_list.push_back(wavelen);
+        }
+
+      return get_ray_wavelen_index(wavelen);
+    }
+
+    unsigned int Result::get_ray_wavelen_index(double wavelen) const
+    {
+      auto i = _wavelen_index.find(wavelen);
+
+      if (i == _wavelen_index.end() || i->second >= Ray::no_wavelen_index)
+        return Ray::no_wavelen_index;
+
+      return i->second;
     }
 
     const std::set<double> & Result::get_ray_wavelen_set() const
@@ -98,24 +119,99 @@ namespace _goptical {
       return _wavelengths;
     }
 
+    const SpectralTable & Result::get_spectral_table() const
+    {
+      return *_spectral;
+    }
+
     trace::Ray & Result::new_ray()
     {
-      trace::Ray        &r = _rays.create();
+      trace::Ray        *r;
+
+      // previously allocated rays are complete when a new ray is requested
+      if (_generated_queue && _generated_queue->size() >= _generated_limit)
+        _generated_flush();
+
+      if (_free_rays.empty())
+        {
+          r = &_rays.create();
+        }
+      else
+        {
+          r = new (_free_rays.back()) trace::Ray();
+          _free_rays.pop_back();
+        }
 
       if (_generated_queue)
-        _generated_queue->push_back(&r);
+        _generated_queue->push_back(r);
 
-      return r;
+      return *r;
     }
 
     trace::Ray & Result::new_ray(const light::Ray &ray)
     {
-      trace::Ray        &r = _rays.create(ray);
+      trace::Ray        *r;
+
+      // previously allocated rays are complete when a new ray is requested
+      if (_generated_queue && _generated_queue->size() >= _generated_limit)
+        _generated_flush();
+
+      if (_free_rays.empty())
+        {
+          r = &_rays.create(ray);
+        }
+      else
+        {
+          r = new (_free_rays.back()) trace::Ray(ray);
+          _free_rays.pop_back();
+        }
 
       if (_generated_queue)
-        _generated_queue->push_back(&r);
+        _generated_queue->push_back(r);
+
+      return *r;
+    }
+
+    void Result::reserve_rays(size_t count)
+    {
+      if (count > _free_rays.size())
+        _rays.reserve(count - _free_rays.size());
+    }
+
+    bool Result::is_streaming() const
+    {
+      return _streaming;
+    }
 
-      return r;
+    bool Result::get_retain_capacity() const
+    {
+      return _retain_capacity;
+    }
+
+    size_t Result::get_max_ray_count() const
+    {
+      return _max_ray_count;
+    }
+
+    double Result::get_precision_error() const
+    {
+      return _precision_error;
+    }
+
+    size_t Result::get_precision_mismatch_count() const
+    {
+      return _precision_mismatch;
+    }
+
+    unsigned int Result::get_bounce_limit_count() const
+    {
+      return _bounce_limit_count;
+    }
+
+    void Result::update_precision_error(double error, unsigned int mismatch_count)
+    {
+      _precision_error = std::max(_precision_error, error);
+      _precision_mismatch += mismatch_count;
     }
 
     const Params & Result::get_params() const
@@ -51,6 +51,7 @@ namespace _goptical {
     {
       friend std::ostream & operator<<(std::ostream &o, const Sequence &s);
       friend class tracer;
+      friend class Plan;
 
     public:
       /** Create a new empty sequence */
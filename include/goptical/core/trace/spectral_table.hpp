@@ -0,0 +1,105 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#ifndef GOPTICAL_TRACE_SPECTRAL_TABLE_HH_
+#define GOPTICAL_TRACE_SPECTRAL_TABLE_HH_
+
+#include <vector>
+
+#include "goptical/core/common.hpp"
+
+#include "goptical/core/sys/element.hpp"
+
+namespace _goptical {
+
+  namespace trace {
+
+    /**
+       @short Materials properties precomputed for traced wavelens
+       @header <goptical/core/trace/SpectralTable
+       @module {Core}
+
+       This class holds refractive index ratio, normal transmittance
+       and normal reflectance of each optical surface interface, for
+       both propagation directions and all wavelens declared to a
+       @ref Result object. Traced rays carry the index of their
+       wavelen so that surfaces can look up these values instead of
+       evaluating materials for each ray.
+
+       The table is cleared for each trace and is updated by the
+       @ref tracer class when new wavelens are declared by sources.
+       Entries which could not be evaluated are flagged invalid so
+       that materials are evaluated again, and report errors, when
+       actually needed.
+    */
+    class SpectralTable
+    {
+    public:
+      /** Interface properties for a direction and a wavelen */
+      struct interface_s
+      {
+        /** previous to next material refractive index ratio */
+        double  _index_ratio;
+        /** next material normal transmittance */
+        double  _transmittance;
+        /** next material normal reflectance */
+        double  _reflectance;
+        bool    _index_valid;
+        bool    _intensity_valid;
+      };
+
+      /** Create an empty table */
+      SpectralTable();
+
+      /** Remove all entries */
+      void clear();
+
+      /** Compute entries for all optical surfaces of the system
+          and given wavelens. Nothing is done if the table already
+          holds the same number of wavelens. */
+      void update(const sys::system &system, const std::vector<double> &wavelens);
+
+      /** Get number of wavelens in table */
+      inline unsigned int get_wavelen_count() const;
+
+      /** Get interface properties of an optical surface for given
+          propagation direction and wavelen index. Return null if not
+          available. */
+      inline const interface_s * get_interface(const sys::Element &e, bool right_to_left,
+                                              unsigned int wavelen_index) const;
+
+    private:
+      static const unsigned int no_offset = ~0u;
+
+      std::vector<unsigned int> _offsets; // first entry for each element id
+      std::vector<interface_s>  _interfaces;
+      unsigned int              _wavelen_count;
+    };
+
+  }
+}
+
+#endif
+
@@ -0,0 +1,57 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#ifndef GOPTICAL_TRACE_SPECTRAL_TABLE_HXX_
+#define GOPTICAL_TRACE_SPECTRAL_TABLE_HXX_
+
+#include "goptical/core/sys/element.hxx"
+
+namespace _goptical {
+
+  namespace trace {
+
+    unsigned int SpectralTable::get_wavelen_count() const
+    {
+      return _wavelen_count;
+    }
+
+    const SpectralTable::interface_s *
+    SpectralTable::get_interface(const sys::Element &e, bool right_to_left,
+                                 unsigned int wavelen_index) const
+    {
+      unsigned int id = e.id();
+
+      if (wavelen_index >= _wavelen_count || id >= _offsets.size() ||
+          _offsets[id] == no_offset)
+        return 0;
+
+      return &_interfaces[_offsets[id] + right_to_left * _wavelen_count + wavelen_index];
+    }
+
+  }
+}
+
+#endif
+
@@ -0,0 +1,102 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#ifndef GOPTICAL_TRACE_THREAD_POOL_HH_
+#define GOPTICAL_TRACE_THREAD_POOL_HH_
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+
+#include "goptical/core/common.hpp"
+
+namespace _goptical {
+
+  namespace trace {
+
+    /**
+       @short Worker threads pool used by the tracer
+       @header <goptical/core/trace/thread_pool.hpp
+       @module {Core}
+       @internal
+
+       This class holds a fixed set of worker threads which are used
+       to run batches of independent tasks. The calling thread takes
+       part in the processing and is always worker number 0.
+    */
+    class ThreadPool
+    {
+    public:
+      /** Task function, called with task index and worker index */
+      typedef std::function<void (unsigned int task, unsigned int worker)> task_t;
+
+      /** Create a pool with specified workers count, including the
+          calling thread. */
+      ThreadPool(unsigned int count);
+
+      ~ThreadPool();
+
+      /** Get number of workers, including the calling thread */
+      inline unsigned int get_worker_count() const;
+
+      /** Run @tt count tasks and return when all tasks have
+          completed. The first exception thrown by a task is
+          rethrown in the calling thread. */
+      void run(unsigned int count, const task_t &task);
+
+    private:
+      ThreadPool(const ThreadPool &);
+      ThreadPool & operator=(const ThreadPool &);
+
+      void worker_main(unsigned int worker);
+      void run_tasks(unsigned int worker);
+
+      std::vector<std::thread>  _threads;
+      std::mutex                _lock;
+      std::condition_variable   _start_cond;
+      std::condition_variable   _done_cond;
+      const task_t              *_task;
+      unsigned int              _task_count;
+      std::atomic<unsigned int> _next_task;
+      unsigned int              _busy;
+      unsigned int              _generation;
+      bool                      _quit;
+      std::exception_ptr        _error;
+    };
+
+    unsigned int ThreadPool::get_worker_count() const
+    {
+      return _threads.size() + 1;
+    }
+
+  }
+}
+
+#endif
+
@@ -26,10 +26,15 @@
 #ifndef GOPTICAL_TRACER_HH_
 #define GOPTICAL_TRACER_HH_
 
+#include <memory>
+#include <thread>
+#include <vector>
+
 #include "goptical/core/common.hpp"
 
 #include "goptical/core/trace/result.hpp"
 #include "goptical/core/trace/params.hpp"
+#include "goptical/core/trace/async_trace.hpp"
 #include "goptical/core/sys/system.hpp"
 
 namespace _goptical {
@@ -83,15 +88,101 @@ namespace _goptical {
       /** Launch ray tracing operation */
       void trace();
 
+      /** Launch ray tracing operation in a separate thread and
+          return immediately. The returned handle can be used to
+          monitor and cancel the trace. The optional completion
+          function is called from the trace thread once the trace
+          has finished.
+
+          The tracer, its parameters, its result and the system must
+          not be used or modified until the trace is done. The trace
+          is done when the completion function is called, which may
+          use the result, start a new trace or destroy the tracer.
+          Exceptions thrown by the completion function are ignored. */
+      AsyncTrace trace_async(const AsyncTrace::completion_t &completion = AsyncTrace::completion_t());
+
     private:
 
       template <IntensityMode m> void trace_template();
+      template <IntensityMode m> void trace_parallel(const rays_queue_t &source_rays);
+      template <IntensityMode m> void trace_ray(Result &result, Ray &ray) const;
       template <IntensityMode m> void trace_seq_template();
+      template <IntensityMode m> void process_rays_parallel(const Plan::step_s &step,
+                                                            rays_queue_t *input,
+                                                            rays_queue_t *generated);
+      template <IntensityMode m> void trace_pipeline(size_t source_step);
+      template <IntensityMode m> void generate_rays(Result &result,
+                                                    const sys::Source &source,
+                                                    const std::vector<const sys::Element *> &targets);
+      template <IntensityMode m> void process_rays(Result &result,
+                                                   const Plan::step_s &step,
+                                                   rays_queue_t *input);
+
+      /** Test if a non sequential ray must be dropped instead of
+          traced. Only the @ref Params::get_max_bounce first rays of
+          a source ray tree in breadth first order are traced, rank
+          is the ray position in this order, starting at 0 with the
+          source ray. */
+      bool bounce_limit(size_t rank) const;
+      /** Throw if cancellation of the running asynchronous trace
+          has been requested */
+      void async_check() const;
+      /** Report rays processed by an element to the running
+          asynchronous trace handle */
+      void async_progress(const sys::Element &e, size_t count) const;
+      /** Wait for the previous asynchronous trace thread to leave,
+          detach it when called from the completion function */
+      void async_release();
+
+      /** Get index of the source step whose rays are streamed
+          through pipeline stages, steps count when the sequence is
+          not traced in pipelined mode */
+      size_t pipeline_start() const;
+
+      /** Get index of first sequential step which must be traced
+          again, 0 when the whole sequence must be traced */
+      size_t retrace_start();
+
+      struct tree_level_s;
+      struct steal_queue_s;
+      struct nonseq_s;
+      struct pipeline_s;
+
+      /** Sequential trace state saved after each step for
+          incremental retrace */
+      struct retrace_step_s
+      {
+        const sys::Element      *_element;
+        unsigned int            _version;
+        unsigned int            _data_versions[4]; // curve, shape and materials versions
+        math::Transform<3>      _transform;
+        RayArena::mark_s        _mark;
+        size_t                  _sources;
+        rays_queue_t            _generated;
+      };
+
+      /** minimum number of rays in a batch processed by a worker thread */
+      static const unsigned int _parallel_batch_min = 256;
+      /** number of rays in a batch passed between pipeline stages */
+      static const unsigned int _pipeline_batch_size = 256;
+      /** number of batches which can be queued between two pipeline stages */
+      static const unsigned int _pipeline_queue_size = 8;
+      /** number of rays processed between two cancellation checks */
+      static const unsigned int _async_batch_size = 1024;
 
       const_ref<sys::system>    _system;
       Params                    _params;
       Result                    _result;
       Result                    *_result_ptr;
+      std::unique_ptr<ThreadPool> _pool;
+      std::unique_ptr<Plan>     _plan;
+      std::vector<retrace_step_s> _retrace;
+      size_t                    _retrace_first;
+      const Result              *_retrace_result; // null when saved state is not valid
+      unsigned int              _retrace_version;
+      const material::Base      *_retrace_env;
+      std::shared_ptr<AsyncTrace::state_s> _async; // null when not traced asynchronously
+      std::thread               _async_thread;
     };
   }
 }
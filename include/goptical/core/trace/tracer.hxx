@@ -27,6 +27,7 @@
 #define GOPTICAL_TRACER_HXX_
 
 #include "goptical/core/trace/result.hpp"
+#include "goptical/core/trace/async_trace.hxx"
 
 namespace _goptical {
 
@@ -35,6 +36,7 @@ namespace _goptical {
     void tracer::set_trace_result(Result &res)
     {
       _result_ptr = &res;
+      _retrace_result = 0;
     }
 
     trace::Result & tracer::get_trace_result() const
@@ -44,6 +46,7 @@ namespace _goptical {
 
     trace::Result & tracer::set_default_trace_result()
     {
+      _retrace_result = 0;
       return *(_result_ptr = &_result);
     }
 
@@ -59,6 +62,8 @@ namespace _goptical {
 
     Params & tracer::get_params()
     {
+      // parameters may be changed, previous trace can not be reused
+      _retrace_result = 0;
       return _params;
     }
 
@@ -108,6 +108,11 @@ namespace _goptical {
       _curve->derivative((this->*_transform)(xy), dxdy);
     }
 
+    void Array::freeze() const
+    {
+      _curve->freeze();
+    }
+
   }
 
 }
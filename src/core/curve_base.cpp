@@ -106,6 +106,44 @@ namespace _goptical {
       return p->c->sagitta(math::Vector2(p->x, y));
     }
 
+    void Base::intersect_batch(unsigned int count,
+                               const double *const origin[3],
+                               const double *const direction[3],
+                               double *const point[3], bool hit[]) const
+    {
+      for (unsigned int i = 0; i < count; i++)
+        {
+          math::Vector3 p;
+          math::VectorPair3 ray(origin[0][i], origin[1][i], origin[2][i],
+                                direction[0][i], direction[1][i], direction[2][i]);
+
+          hit[i] = intersect(p, ray);
+
+          if (hit[i])
+            for (unsigned int j = 0; j < 3; j++)
+              point[j][i] = p[j];
+        }
+    }
+
+    void Base::intersect_batch(unsigned int count,
+                               const float *const origin[3],
+                               const float *const direction[3],
+                               float *const point[3], bool hit[]) const
+    {
+      for (unsigned int i = 0; i < count; i++)
+        {
+          math::Vector3 p;
+          math::VectorPair3 ray(origin[0][i], origin[1][i], origin[2][i],
+                                direction[0][i], direction[1][i], direction[2][i]);
+
+          hit[i] = intersect(p, ray);
+
+          if (hit[i])
+            for (unsigned int j = 0; j < 3; j++)
+              point[j][i] = p[j];
+        }
+    }
+
     void Base::derivative(const math::Vector2 & xy, math::Vector2 & dxdy) const
     {
       double abserr;
@@ -135,6 +173,10 @@ namespace _goptical {
       normal.normalize();
     }
 
+    void Base::freeze() const
+    {
+    }
+
   }
 
 }
@@ -0,0 +1,70 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#include "curve_batch_.hxx"
+
+namespace _goptical {
+
+  namespace curve {
+
+    const batch_kernels_s batch_kernels_scalar =
+      {
+        "scalar",
+        &sphere_kernel<scalar_vec>,
+        &conic_kernel<scalar_vec>,
+        &parabola_kernel<scalar_vec>,
+        &flat_kernel<scalar_vec>,
+        &sphere_kernel<scalar_vecf>,
+        &conic_kernel<scalar_vecf>,
+        &parabola_kernel<scalar_vecf>,
+        &flat_kernel<scalar_vecf>,
+      };
+
+    static const batch_kernels_s * select_batch_kernels()
+    {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+      __builtin_cpu_init();
+
+      if (batch_kernels_avx2 && __builtin_cpu_supports("avx2"))
+        return batch_kernels_avx2;
+
+      if (batch_kernels_sse2 && __builtin_cpu_supports("sse2"))
+        return batch_kernels_sse2;
+#endif
+
+      return &batch_kernels_scalar;
+    }
+
+    const batch_kernels_s & get_batch_kernels()
+    {
+      static const batch_kernels_s *k = select_batch_kernels();
+
+      return *k;
+    }
+
+  }
+
+}
+
@@ -0,0 +1,344 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+/*
+  Batch ray/curve intersection kernels.
+
+  Kernels are written once using a small vector type interface and
+  instantiated in separate compilation units for each supported
+  instruction set. Operations order is the same as in the scalar
+  intersect functions of curves classes so that results are bit
+  identical whatever the kernel in use.
+
+  Kernels templates have internal linkage as the same template
+  instances are compiled with different target instruction sets.
+
+  Single precision kernels share the same code, vector types define
+  the scalar type in use.
+*/
+
+#ifndef GOPTICAL_CURVE_BATCH_HXX_
+#define GOPTICAL_CURVE_BATCH_HXX_
+
+#include <cmath>
+
+namespace _goptical {
+
+  namespace curve {
+
+    /** @internal batch intersection kernel, @tt sh is the
+        Schwarzschild constant + 1 and is only used by conic kernel. */
+    typedef void (*batch_kernel_t)(unsigned int count, double roc, double sh,
+                                   const double *const origin[3],
+                                   const double *const direction[3],
+                                   double *const point[3], bool hit[]);
+
+    /** @internal single precision batch intersection kernel */
+    typedef void (*batch_kernel_f_t)(unsigned int count, double roc, double sh,
+                                     const float *const origin[3],
+                                     const float *const direction[3],
+                                     float *const point[3], bool hit[]);
+
+    /** @internal set of batch intersection kernels */
+    struct batch_kernels_s
+    {
+      const char        *_name;
+      batch_kernel_t    _sphere;
+      batch_kernel_t    _conic;
+      batch_kernel_t    _parabola;
+      batch_kernel_t    _flat;
+      batch_kernel_f_t  _sphere_f;
+      batch_kernel_f_t  _conic_f;
+      batch_kernel_f_t  _parabola_f;
+      batch_kernel_f_t  _flat_f;
+    };
+
+    /** @internal get best kernels set supported by the processor */
+    const batch_kernels_s & get_batch_kernels();
+
+    extern const batch_kernels_s batch_kernels_scalar;
+    /** null when not available in this build */
+    extern const batch_kernels_s * const batch_kernels_sse2;
+    /** null when not available in this build */
+    extern const batch_kernels_s * const batch_kernels_avx2;
+
+    namespace {
+
+      /** scalar implementation of the vector interface, used for
+          trailing rays which do not fill a whole vector */
+      template <typename T>
+      struct scalar_vec_
+      {
+        typedef T scalar_t;
+        typedef bool mask_t;
+        static const unsigned int width = 1;
+
+        scalar_vec_() { }
+        scalar_vec_(T x) : _v(x) { }
+
+        static scalar_vec_ load(const T *p) { return *p; }
+        void store(T *p) const { *p = _v; }
+        static void store_mask(bool m, bool *p) { *p = m; }
+
+        T _v;
+      };
+
+      typedef scalar_vec_<double> scalar_vec;
+      typedef scalar_vec_<float> scalar_vecf;
+
+      template <typename T>
+      inline scalar_vec_<T> operator+(scalar_vec_<T> a, scalar_vec_<T> b) { return a._v + b._v; }
+      template <typename T>
+      inline scalar_vec_<T> operator-(scalar_vec_<T> a, scalar_vec_<T> b) { return a._v - b._v; }
+      template <typename T>
+      inline scalar_vec_<T> operator*(scalar_vec_<T> a, scalar_vec_<T> b) { return a._v * b._v; }
+      template <typename T>
+      inline scalar_vec_<T> operator/(scalar_vec_<T> a, scalar_vec_<T> b) { return a._v / b._v; }
+      template <typename T>
+      inline scalar_vec_<T> operator-(scalar_vec_<T> a) { return -a._v; }
+      template <typename T>
+      inline bool operator<(scalar_vec_<T> a, scalar_vec_<T> b) { return a._v < b._v; }
+      template <typename T>
+      inline bool operator<=(scalar_vec_<T> a, scalar_vec_<T> b) { return a._v <= b._v; }
+      template <typename T>
+      inline bool operator>(scalar_vec_<T> a, scalar_vec_<T> b) { return a._v > b._v; }
+      template <typename T>
+      inline bool operator==(scalar_vec_<T> a, scalar_vec_<T> b) { return a._v == b._v; }
+      template <typename T>
+      inline scalar_vec_<T> vsqrt(scalar_vec_<T> a) { return std::sqrt(a._v); }
+      template <typename T>
+      inline scalar_vec_<T> select(bool m, scalar_vec_<T> a, scalar_vec_<T> b) { return m ? a : b; }
+
+      template <class V>
+      inline V sq(V a)
+      {
+        return a * a;
+      }
+
+      template <class V>
+      inline void store_point(unsigned int i, const V &t,
+                              const V &ax, const V &ay, const V &az,
+                              const V &bx, const V &by, const V &bz,
+                              typename V::scalar_t *const point[3])
+      {
+        // ray.origin() + ray.direction() * t
+        (ax + t * bx).store(point[0] + i);
+        (ay + t * by).store(point[1] + i);
+        (az + t * bz).store(point[2] + i);
+      }
+
+#define GOPTICAL_BATCH_LOAD_RAYS                                \
+      V ax = V::load(origin[0] + i);                            \
+      V ay = V::load(origin[1] + i);                            \
+      V az = V::load(origin[2] + i);                            \
+      V bx = V::load(direction[0] + i);                         \
+      V by = V::load(direction[1] + i);                         \
+      V bz = V::load(direction[2] + i);
+
+      /** see Sphere::intersect */
+      template <class V>
+      inline void sphere_lanes(unsigned int i, double roc,
+                               const typename V::scalar_t *const origin[3],
+                               const typename V::scalar_t *const direction[3],
+                               typename V::scalar_t *const point[3], bool hit[])
+      {
+        GOPTICAL_BATCH_LOAD_RAYS;
+
+        V r(roc);
+        V d = az - r;
+        V ay_by = ay * by;
+        V ax_bx = ax * bx;
+
+        V s =
+          V(roc * roc)
+          + V(2.0) * (ax_bx + ay_by) * bz * d
+          + V(2.0) * ax_bx * ay_by
+          - sq(ay * bx)
+          - sq(ax * by)
+          - (sq(bx) + sq(by)) * sq(d)
+          - (sq(ax) + sq(ay)) * sq(bz)
+          ;
+
+        typename V::mask_t m = !(s < V(0.0));
+
+        s = vsqrt(s);
+        s = select(r * bz > V(0.0), -s, s);
+
+        V t = (s - (bz * d + ax_bx + ay_by));
+
+        m = m & !(t <= V(0.0));
+
+        store_point(i, t, ax, ay, az, bx, by, bz, point);
+        V::store_mask(m, hit + i);
+      }
+
+      /** see Conic::intersect */
+      template <class V>
+      inline void conic_lanes(unsigned int i, double roc, double sh,
+                              const typename V::scalar_t *const origin[3],
+                              const typename V::scalar_t *const direction[3],
+                              typename V::scalar_t *const point[3], bool hit[])
+      {
+        GOPTICAL_BATCH_LOAD_RAYS;
+
+        V r(roc);
+        V h(sh);
+        V a = (h * sq(bz) + sq(by) + sq(bx));
+        V b = ((h * bz * az + by * ay + bx * ax) / r - bz) * V(2.0);
+        V c = (h * sq(az) + sq(ay) + sq(ax)) / r - V(2.0) * az;
+
+        typename V::mask_t a0 = a == V(0.0);
+
+        V d = sq(b) - V(4.0) * a * c / r;
+        typename V::mask_t m = a0 | !(d < V(0.0));
+
+        V s = vsqrt(d);
+        s = select(a * bz < V(0.0), -s, s);
+
+        if (sh < 0)
+          s = -s;
+
+        V t = select(a0, -c / b, (V(2.0) * c) / (s - b));
+
+        m = m & !(t <= V(0.0));
+
+        store_point(i, t, ax, ay, az, bx, by, bz, point);
+        V::store_mask(m, hit + i);
+      }
+
+      /** see Parabola::intersect */
+      template <class V>
+      inline void parabola_lanes(unsigned int i, double roc,
+                                 const typename V::scalar_t *const origin[3],
+                                 const typename V::scalar_t *const direction[3],
+                                 typename V::scalar_t *const point[3], bool hit[])
+      {
+        GOPTICAL_BATCH_LOAD_RAYS;
+
+        V r(roc);
+        V a = (sq(by) + sq(bx));
+        V b = ((by * ay + bx * ax) / r - bz) * V(2.0);
+        V c = (sq(ay) + sq(ax)) / r - V(2.0) * az;
+
+        typename V::mask_t a0 = a == V(0.0);
+
+        V d = sq(b) - V(4.0) * a * c / r;
+        typename V::mask_t m = a0 | !(d < V(0.0));
+
+        V s = vsqrt(d);
+        s = select(a * bz < V(0.0), -s, s);
+
+        V t = select(a0, -c / b, (V(2.0) * c) / (s - b));
+
+        m = m & !(t <= V(0.0));
+
+        store_point(i, t, ax, ay, az, bx, by, bz, point);
+        V::store_mask(m, hit + i);
+      }
+
+      /** see Flat::intersect */
+      template <class V>
+      inline void flat_lanes(unsigned int i,
+                             const typename V::scalar_t *const origin[3],
+                             const typename V::scalar_t *const direction[3],
+                             typename V::scalar_t *const point[3], bool hit[])
+      {
+        GOPTICAL_BATCH_LOAD_RAYS;
+
+        typename V::mask_t m = !(bz == V(0.0));
+        V a = -az / bz;
+
+        m = m & !(a < V(0.0));
+
+        store_point(i, a, ax, ay, az, bx, by, bz, point);
+        V::store_mask(m, hit + i);
+      }
+
+#undef GOPTICAL_BATCH_LOAD_RAYS
+
+      template <class V>
+      void sphere_kernel(unsigned int count, double roc, double,
+                         const typename V::scalar_t *const origin[3],
+                         const typename V::scalar_t *const direction[3],
+                         typename V::scalar_t *const point[3], bool hit[])
+      {
+        unsigned int i = 0;
+
+        for (; i + V::width <= count; i += V::width)
+          sphere_lanes<V>(i, roc, origin, direction, point, hit);
+        for (; i < count; i++)
+          sphere_lanes<scalar_vec_<typename V::scalar_t> >(i, roc, origin, direction, point, hit);
+      }
+
+      template <class V>
+      void conic_kernel(unsigned int count, double roc, double sh,
+                        const typename V::scalar_t *const origin[3],
+                        const typename V::scalar_t *const direction[3],
+                        typename V::scalar_t *const point[3], bool hit[])
+      {
+        unsigned int i = 0;
+
+        for (; i + V::width <= count; i += V::width)
+          conic_lanes<V>(i, roc, sh, origin, direction, point, hit);
+        for (; i < count; i++)
+          conic_lanes<scalar_vec_<typename V::scalar_t> >(i, roc, sh, origin, direction, point, hit);
+      }
+
+      template <class V>
+      void parabola_kernel(unsigned int count, double roc, double,
+                           const typename V::scalar_t *const origin[3],
+                           const typename V::scalar_t *const direction[3],
+                           typename V::scalar_t *const point[3], bool hit[])
+      {
+        unsigned int i = 0;
+
+        for (; i + V::width <= count; i += V::width)
+          parabola_lanes<V>(i, roc, origin, direction, point, hit);
+        for (; i < count; i++)
+          parabola_lanes<scalar_vec_<typename V::scalar_t> >(i, roc, origin, direction, point, hit);
+      }
+
+      template <class V>
+      void flat_kernel(unsigned int count, double, double,
+                       const typename V::scalar_t *const origin[3],
+                       const typename V::scalar_t *const direction[3],
+                       typename V::scalar_t *const point[3], bool hit[])
+      {
+        unsigned int i = 0;
+
+        for (; i + V::width <= count; i += V::width)
+          flat_lanes<V>(i, origin, direction, point, hit);
+        for (; i < count; i++)
+          flat_lanes<scalar_vec_<typename V::scalar_t> >(i, origin, direction, point, hit);
+      }
+
+    }
+
+  }
+
+}
+
+#endif
+
@@ -0,0 +1,212 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+
+/*
+  This file is not compiled with an AVX2 compiler flag. Inline
+  functions of standard headers are emitted as weak symbols which may
+  be picked by the linker for other compilation units, so they must
+  keep the default target. Standard headers are included first and
+  only kernels code is compiled for AVX2 using a target pragma.
+*/
+
+#include <cmath>
+#include <immintrin.h>
+
+#ifdef __clang__
+# pragma clang attribute push (__attribute__((target("avx2"))), apply_to = function)
+#else
+# pragma GCC push_options
+# pragma GCC target("avx2")
+#endif
+
+#include "curve_batch_.hxx"
+
+namespace _goptical {
+
+  namespace curve {
+
+    namespace {
+
+      struct avx2_mask
+      {
+        avx2_mask(__m256d m) : _m(m) { }
+
+        __m256d _m;
+      };
+
+      inline avx2_mask operator&(avx2_mask a, avx2_mask b) { return _mm256_and_pd(a._m, b._m); }
+      inline avx2_mask operator|(avx2_mask a, avx2_mask b) { return _mm256_or_pd(a._m, b._m); }
+      inline avx2_mask operator!(avx2_mask a)
+      {
+        return _mm256_xor_pd(a._m, _mm256_castsi256_pd(_mm256_set1_epi64x(-1)));
+      }
+
+      struct avx2_vec
+      {
+        typedef double scalar_t;
+        typedef avx2_mask mask_t;
+        static const unsigned int width = 4;
+
+        avx2_vec(__m256d v) : _v(v) { }
+        avx2_vec(double x) : _v(_mm256_set1_pd(x)) { }
+
+        static avx2_vec load(const double *p) { return _mm256_loadu_pd(p); }
+        void store(double *p) const { _mm256_storeu_pd(p, _v); }
+
+        static void store_mask(avx2_mask m, bool *p)
+        {
+          int b = _mm256_movemask_pd(m._m);
+
+          p[0] = b & 1;
+          p[1] = (b >> 1) & 1;
+          p[2] = (b >> 2) & 1;
+          p[3] = (b >> 3) & 1;
+        }
+
+        __m256d _v;
+      };
+
+      inline avx2_vec operator+(avx2_vec a, avx2_vec b) { return _mm256_add_pd(a._v, b._v); }
+      inline avx2_vec operator-(avx2_vec a, avx2_vec b) { return _mm256_sub_pd(a._v, b._v); }
+      inline avx2_vec operator*(avx2_vec a, avx2_vec b) { return _mm256_mul_pd(a._v, b._v); }
+      inline avx2_vec operator/(avx2_vec a, avx2_vec b) { return _mm256_div_pd(a._v, b._v); }
+      inline avx2_vec operator-(avx2_vec a) { return _mm256_xor_pd(a._v, _mm256_set1_pd(-0.0)); }
+      inline avx2_mask operator<(avx2_vec a, avx2_vec b) { return _mm256_cmp_pd(a._v, b._v, _CMP_LT_OQ); }
+      inline avx2_mask operator<=(avx2_vec a, avx2_vec b) { return _mm256_cmp_pd(a._v, b._v, _CMP_LE_OQ); }
+      inline avx2_mask operator>(avx2_vec a, avx2_vec b) { return _mm256_cmp_pd(a._v, b._v, _CMP_GT_OQ); }
+      inline avx2_mask operator==(avx2_vec a, avx2_vec b) { return _mm256_cmp_pd(a._v, b._v, _CMP_EQ_OQ); }
+      inline avx2_vec vsqrt(avx2_vec a) { return _mm256_sqrt_pd(a._v); }
+
+      inline avx2_vec select(avx2_mask m, avx2_vec a, avx2_vec b)
+      {
+        return _mm256_blendv_pd(b._v, a._v, m._m);
+      }
+
+      struct avx2_maskf
+      {
+        avx2_maskf(__m256 m) : _m(m) { }
+
+        __m256 _m;
+      };
+
+      inline avx2_maskf operator&(avx2_maskf a, avx2_maskf b) { return _mm256_and_ps(a._m, b._m); }
+      inline avx2_maskf operator|(avx2_maskf a, avx2_maskf b) { return _mm256_or_ps(a._m, b._m); }
+      inline avx2_maskf operator!(avx2_maskf a)
+      {
+        return _mm256_xor_ps(a._m, _mm256_castsi256_ps(_mm256_set1_epi32(-1)));
+      }
+
+      struct avx2_vecf
+      {
+        typedef float scalar_t;
+        typedef avx2_maskf mask_t;
+        static const unsigned int width = 8;
+
+        avx2_vecf(__m256 v) : _v(v) { }
+        avx2_vecf(float x) : _v(_mm256_set1_ps(x)) { }
+
+        static avx2_vecf load(const float *p) { return _mm256_loadu_ps(p); }
+        void store(float *p) const { _mm256_storeu_ps(p, _v); }
+
+        static void store_mask(avx2_maskf m, bool *p)
+        {
+          int b = _mm256_movemask_ps(m._m);
+
+          for (unsigned int i = 0; i < width; i++)
+            p[i] = (b >> i) & 1;
+        }
+
+        __m256 _v;
+      };
+
+      inline avx2_vecf operator+(avx2_vecf a, avx2_vecf b) { return _mm256_add_ps(a._v, b._v); }
+      inline avx2_vecf operator-(avx2_vecf a, avx2_vecf b) { return _mm256_sub_ps(a._v, b._v); }
+      inline avx2_vecf operator*(avx2_vecf a, avx2_vecf b) { return _mm256_mul_ps(a._v, b._v); }
+      inline avx2_vecf operator/(avx2_vecf a, avx2_vecf b) { return _mm256_div_ps(a._v, b._v); }
+      inline avx2_vecf operator-(avx2_vecf a) { return _mm256_xor_ps(a._v, _mm256_set1_ps(-0.0f)); }
+      inline avx2_maskf operator<(avx2_vecf a, avx2_vecf b) { return _mm256_cmp_ps(a._v, b._v, _CMP_LT_OQ); }
+      inline avx2_maskf operator<=(avx2_vecf a, avx2_vecf b) { return _mm256_cmp_ps(a._v, b._v, _CMP_LE_OQ); }
+      inline avx2_maskf operator>(avx2_vecf a, avx2_vecf b) { return _mm256_cmp_ps(a._v, b._v, _CMP_GT_OQ); }
+      inline avx2_maskf operator==(avx2_vecf a, avx2_vecf b) { return _mm256_cmp_ps(a._v, b._v, _CMP_EQ_OQ); }
+      inline avx2_vecf vsqrt(avx2_vecf a) { return _mm256_sqrt_ps(a._v); }
+
+      inline avx2_vecf select(avx2_maskf m, avx2_vecf a, avx2_vecf b)
+      {
+        return _mm256_blendv_ps(b._v, a._v, m._m);
+      }
+
+      const batch_kernels_s kernels =
+        {
+          "avx2",
+          &sphere_kernel<avx2_vec>,
+          &conic_kernel<avx2_vec>,
+          &parabola_kernel<avx2_vec>,
+          &flat_kernel<avx2_vec>,
+          &sphere_kernel<avx2_vecf>,
+          &conic_kernel<avx2_vecf>,
+          &parabola_kernel<avx2_vecf>,
+          &flat_kernel<avx2_vecf>,
+        };
+
+    }
+
+  }
+
+}
+
+#ifdef __clang__
+# pragma clang attribute pop
+#else
+# pragma GCC pop_options
+#endif
+
+namespace _goptical {
+
+  namespace curve {
+
+    const batch_kernels_s * const batch_kernels_avx2 = &kernels;
+
+  }
+
+}
+
+#else
+
+#include "curve_batch_.hxx"
+
+namespace _goptical {
+
+  namespace curve {
+
+    const batch_kernels_s * const batch_kernels_avx2 = 0;
+
+  }
+
+}
+
+#endif
+
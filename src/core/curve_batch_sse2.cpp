@@ -0,0 +1,180 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#include "curve_batch_.hxx"
+
+#ifdef __SSE2__
+
+#include <emmintrin.h>
+
+namespace _goptical {
+
+  namespace curve {
+
+    namespace {
+
+      struct sse2_mask
+      {
+        sse2_mask(__m128d m) : _m(m) { }
+
+        __m128d _m;
+      };
+
+      inline sse2_mask operator&(sse2_mask a, sse2_mask b) { return _mm_and_pd(a._m, b._m); }
+      inline sse2_mask operator|(sse2_mask a, sse2_mask b) { return _mm_or_pd(a._m, b._m); }
+      inline sse2_mask operator!(sse2_mask a)
+      {
+        return _mm_xor_pd(a._m, _mm_castsi128_pd(_mm_set1_epi32(-1)));
+      }
+
+      struct sse2_vec
+      {
+        typedef double scalar_t;
+        typedef sse2_mask mask_t;
+        static const unsigned int width = 2;
+
+        sse2_vec(__m128d v) : _v(v) { }
+        sse2_vec(double x) : _v(_mm_set1_pd(x)) { }
+
+        static sse2_vec load(const double *p) { return _mm_loadu_pd(p); }
+        void store(double *p) const { _mm_storeu_pd(p, _v); }
+
+        static void store_mask(sse2_mask m, bool *p)
+        {
+          int b = _mm_movemask_pd(m._m);
+
+          p[0] = b & 1;
+          p[1] = (b >> 1) & 1;
+        }
+
+        __m128d _v;
+      };
+
+      inline sse2_vec operator+(sse2_vec a, sse2_vec b) { return _mm_add_pd(a._v, b._v); }
+      inline sse2_vec operator-(sse2_vec a, sse2_vec b) { return _mm_sub_pd(a._v, b._v); }
+      inline sse2_vec operator*(sse2_vec a, sse2_vec b) { return _mm_mul_pd(a._v, b._v); }
+      inline sse2_vec operator/(sse2_vec a, sse2_vec b) { return _mm_div_pd(a._v, b._v); }
+      inline sse2_vec operator-(sse2_vec a) { return _mm_xor_pd(a._v, _mm_set1_pd(-0.0)); }
+      inline sse2_mask operator<(sse2_vec a, sse2_vec b) { return _mm_cmplt_pd(a._v, b._v); }
+      inline sse2_mask operator<=(sse2_vec a, sse2_vec b) { return _mm_cmple_pd(a._v, b._v); }
+      inline sse2_mask operator>(sse2_vec a, sse2_vec b) { return _mm_cmpgt_pd(a._v, b._v); }
+      inline sse2_mask operator==(sse2_vec a, sse2_vec b) { return _mm_cmpeq_pd(a._v, b._v); }
+      inline sse2_vec vsqrt(sse2_vec a) { return _mm_sqrt_pd(a._v); }
+
+      inline sse2_vec select(sse2_mask m, sse2_vec a, sse2_vec b)
+      {
+        return _mm_or_pd(_mm_and_pd(m._m, a._v), _mm_andnot_pd(m._m, b._v));
+      }
+
+      struct sse2_maskf
+      {
+        sse2_maskf(__m128 m) : _m(m) { }
+
+        __m128 _m;
+      };
+
+      inline sse2_maskf operator&(sse2_maskf a, sse2_maskf b) { return _mm_and_ps(a._m, b._m); }
+      inline sse2_maskf operator|(sse2_maskf a, sse2_maskf b) { return _mm_or_ps(a._m, b._m); }
+      inline sse2_maskf operator!(sse2_maskf a)
+      {
+        return _mm_xor_ps(a._m, _mm_castsi128_ps(_mm_set1_epi32(-1)));
+      }
+
+      struct sse2_vecf
+      {
+        typedef float scalar_t;
+        typedef sse2_maskf mask_t;
+        static const unsigned int width = 4;
+
+        sse2_vecf(__m128 v) : _v(v) { }
+        sse2_vecf(float x) : _v(_mm_set1_ps(x)) { }
+
+        static sse2_vecf load(const float *p) { return _mm_loadu_ps(p); }
+        void store(float *p) const { _mm_storeu_ps(p, _v); }
+
+        static void store_mask(sse2_maskf m, bool *p)
+        {
+          int b = _mm_movemask_ps(m._m);
+
+          p[0] = b & 1;
+          p[1] = (b >> 1) & 1;
+          p[2] = (b >> 2) & 1;
+          p[3] = (b >> 3) & 1;
+        }
+
+        __m128 _v;
+      };
+
+      inline sse2_vecf operator+(sse2_vecf a, sse2_vecf b) { return _mm_add_ps(a._v, b._v); }
+      inline sse2_vecf operator-(sse2_vecf a, sse2_vecf b) { return _mm_sub_ps(a._v, b._v); }
+      inline sse2_vecf operator*(sse2_vecf a, sse2_vecf b) { return _mm_mul_ps(a._v, b._v); }
+      inline sse2_vecf operator/(sse2_vecf a, sse2_vecf b) { return _mm_div_ps(a._v, b._v); }
+      inline sse2_vecf operator-(sse2_vecf a) { return _mm_xor_ps(a._v, _mm_set1_ps(-0.0f)); }
+      inline sse2_maskf operator<(sse2_vecf a, sse2_vecf b) { return _mm_cmplt_ps(a._v, b._v); }
+      inline sse2_maskf operator<=(sse2_vecf a, sse2_vecf b) { return _mm_cmple_ps(a._v, b._v); }
+      inline sse2_maskf operator>(sse2_vecf a, sse2_vecf b) { return _mm_cmpgt_ps(a._v, b._v); }
+      inline sse2_maskf operator==(sse2_vecf a, sse2_vecf b) { return _mm_cmpeq_ps(a._v, b._v); }
+      inline sse2_vecf vsqrt(sse2_vecf a) { return _mm_sqrt_ps(a._v); }
+
+      inline sse2_vecf select(sse2_maskf m, sse2_vecf a, sse2_vecf b)
+      {
+        return _mm_or_ps(_mm_and_ps(m._m, a._v), _mm_andnot_ps(m._m, b._v));
+      }
+
+      const batch_kernels_s kernels =
+        {
+          "sse2",
+          &sphere_kernel<sse2_vec>,
+          &conic_kernel<sse2_vec>,
+          &parabola_kernel<sse2_vec>,
+          &flat_kernel<sse2_vec>,
+          &sphere_kernel<sse2_vecf>,
+          &conic_kernel<sse2_vecf>,
+          &parabola_kernel<sse2_vecf>,
+          &flat_kernel<sse2_vecf>,
+        };
+
+    }
+
+    const batch_kernels_s * const batch_kernels_sse2 = &kernels;
+
+  }
+
+}
+
+#else
+
+namespace _goptical {
+
+  namespace curve {
+
+    const batch_kernels_s * const batch_kernels_sse2 = 0;
+
+  }
+
+}
+
+#endif
+
@@ -39,8 +39,10 @@ namespace _goptical {
       attr._z_offset = 0.;
       attr._transform.reset();
       attr._inv_transform.reset();
+      attr._version = 0;
 
       _list.push_back(attr);
+      update_version();
 
       return _list.back();
     }
@@ -50,6 +52,16 @@ namespace _goptical {
     {
     }
 
+    unsigned int Composer::get_version() const
+    {
+      unsigned int v = Base::get_version();
+
+      for (auto &s : _list)
+        v += s._version + s._curve->get_version();
+
+      return v;
+    }
+
     double Composer::sagitta(const math::Vector2 & xy) const
     {
       double z = 0;
@@ -74,6 +86,12 @@ namespace _goptical {
         }
     }
 
+    void Composer::freeze() const
+    {
+      for (auto&c : _list)
+        c._curve->freeze();
+    }
+
   }
 }
 
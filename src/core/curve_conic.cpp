@@ -31,6 +31,8 @@
 #include <goptical/core/math/VectorPair>
 #include <goptical/core/math/VectorPair>
 
+#include "curve_batch_.hxx"
+
 namespace _goptical {
 
   namespace curve {
@@ -105,6 +107,27 @@ namespace _goptical {
       return true;
     }
 
+    void Conic::intersect_batch(unsigned int count,
+                                const double *const origin[3],
+                                const double *const direction[3],
+                                double *const point[3], bool hit[]) const
+    {
+      get_batch_kernels()._conic(count, _roc, _sh, origin, direction, point, hit);
+    }
+
+    void Conic::intersect_batch(unsigned int count,
+                                const float *const origin[3],
+                                const float *const direction[3],
+                                float *const point[3], bool hit[]) const
+    {
+      get_batch_kernels()._conic_f(count, _roc, _sh, origin, direction, point, hit);
+    }
+
+    void Conic::normal(math::Vector3 &normal, const math::Vector3 &point) const
+    {
+      normal_<Conic>(normal, point);
+    }
+
     /*
       ellipse and hyperbola equation standard forms:
 
@@ -184,6 +207,7 @@ namespace _goptical {
 
       _sh = -c1;
       _roc = c0 / 2.0;
+      update_version();
 
       return sqrt(chisq / count); // FIXME bad rms error
     }
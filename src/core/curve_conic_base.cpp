@@ -133,6 +133,7 @@ namespace _goptical {
           _roc = 2.0 * c1;
         }
 
+      update_version();
       return sqrt(chisq / count); // FIXME bad rms error
     }
 
@@ -28,6 +28,8 @@
 #include <goptical/core/math/VectorPair>
 #include <goptical/core/math/VectorPair>
 
+#include "curve_batch_.hxx"
+
 namespace _goptical {
 
   namespace curve {
@@ -80,6 +82,22 @@ namespace _goptical {
       return true;
     }
 
+    void Flat::intersect_batch(unsigned int count,
+                               const double *const origin[3],
+                               const double *const direction[3],
+                               double *const point[3], bool hit[]) const
+    {
+      get_batch_kernels()._flat(count, 0, 0, origin, direction, point, hit);
+    }
+
+    void Flat::intersect_batch(unsigned int count,
+                               const float *const origin[3],
+                               const float *const direction[3],
+                               float *const point[3], bool hit[]) const
+    {
+      get_batch_kernels()._flat_f(count, 0, 0, origin, direction, point, hit);
+    }
+
     void Flat::normal(math::Vector3 &normal, const math::Vector3 &point) const
     {
       normal = math::Vector3(0, 0, -1);
@@ -78,6 +78,8 @@ namespace _goptical {
 
           _reading.get_y_value(j) = c.sagitta(zn) + zn / c.derivative(zn);
         }
+
+      update_version();
     }
 
     void Foucault::add_reading(double zone_radius, double knife_offset)
@@ -88,6 +90,7 @@ namespace _goptical {
         _radius = zone_radius * 1.1;
 
       _reading.add_data(zone_radius, _roc + knife_offset);
+      update_version();
     }
 
     unsigned int Foucault::add_uniform_zones(double hole_radius, unsigned int count = 0)
@@ -105,6 +108,8 @@ namespace _goptical {
           hole_radius += step;
         }
 
+      update_version();
+
       return count;
     }
 
@@ -145,6 +150,7 @@ namespace _goptical {
 
       if (edge)
         edge->push_back(in);
+      update_version();
 
       return count;
     }
@@ -155,6 +161,7 @@ namespace _goptical {
 
       _reading.clear();
       _sagitta.clear();
+      update_version();
     }
 
     double Foucault::sagitta(double r) const
@@ -173,6 +180,14 @@ namespace _goptical {
       return _sagitta.interpolate(r, 1);
     }
 
+    void Foucault::freeze() const
+    {
+      if (!_updated)
+        const_cast<Foucault *>(this)->update();
+
+      _sagitta.freeze();
+    }
+
     void Foucault::update()
     {
       _sagitta.clear();
@@ -52,6 +52,8 @@ namespace _goptical {
             if (_data.get_interpolation() == data::BicubicDeriv)
               c.derivative(v, _data.get_d_value(x, y));
           }
+
+      update_version();
     }
 
     double Grid::sagitta(const math::Vector2 & xy) const
@@ -64,5 +66,10 @@ namespace _goptical {
       dxdy = _data.interpolate_deriv(xy);
     }
 
+    void Grid::freeze() const
+    {
+      _data.freeze();
+    }
+
   }
 }
@@ -73,6 +73,7 @@ namespace _goptical {
         _coeff[i] = va_arg(ap, double);
 
       va_end(ap);
+      update_version();
     }
 
     void Polynomial::set_even(unsigned int first_term, unsigned int last_term, ...)
@@ -93,6 +94,7 @@ namespace _goptical {
         _coeff[i] = va_arg(ap, double);
 
       va_end(ap);
+      update_version();
     }
 
     void Polynomial::set_odd(unsigned int first_term, unsigned int last_term, ...)
@@ -113,6 +115,7 @@ namespace _goptical {
         _coeff[i] = va_arg(ap, double);
 
       va_end(ap);
+      update_version();
     }
 
     void Polynomial::set_term_factor(unsigned int n, double c)
@@ -128,6 +131,7 @@ namespace _goptical {
         }
 
       _coeff[n] = c;
+      update_version();
     }
 
     void Polynomial::set_last_term(unsigned int n)
@@ -138,6 +142,7 @@ namespace _goptical {
         _first_term = _last_term;
 
       _coeff.resize(_last_term + 1, 0.0);
+      update_version();
     }
 
     void Polynomial::set_first_term(unsigned int n)
@@ -151,6 +156,7 @@ namespace _goptical {
 
       for (unsigned int i = 0; i < _first_term; i++)
         _coeff[i] = 0.0;
+      update_version();
     }
 
     double Polynomial::sagitta(double r) const
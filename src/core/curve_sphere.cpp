@@ -28,6 +28,8 @@
 #include <goptical/core/math/VectorPair>
 #include <goptical/core/math/VectorPair>
 
+#include "curve_batch_.hxx"
+
 namespace _goptical {
 
   namespace curve {
@@ -114,6 +116,22 @@ namespace _goptical {
       return true;
     }
 
+    void Sphere::intersect_batch(unsigned int count,
+                                 const double *const origin[3],
+                                 const double *const direction[3],
+                                 double *const point[3], bool hit[]) const
+    {
+      get_batch_kernels()._sphere(count, _roc, 0, origin, direction, point, hit);
+    }
+
+    void Sphere::intersect_batch(unsigned int count,
+                                 const float *const origin[3],
+                                 const float *const direction[3],
+                                 float *const point[3], bool hit[]) const
+    {
+      get_batch_kernels()._sphere_f(count, _roc, 0, origin, direction, point, hit);
+    }
+
     void Sphere::normal(math::Vector3 &normal, const math::Vector3 &point) const
     {
       // normalized vector to sphere center
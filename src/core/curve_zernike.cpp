@@ -747,6 +747,7 @@ namespace _goptical {
           _enabled_list[n++] = i;
 
       _enabled_count = n;
+      update_version();
     }
 
     void Zernike::set_term_state(unsigned int n, bool enabled)
@@ -759,10 +760,13 @@ namespace _goptical {
         {
           for (i = 0; i < _enabled_count; i++)
             if (_enabled_list[i] == n)
-              return;
-          assert(i < term_count);
-          _enabled_list[i] = n;
-          _enabled_count = i + 1;
+              break;
+          if (i == _enabled_count)
+            {
+              assert(i < term_count);
+              _enabled_list[i] = n;
+              _enabled_count = i + 1;
+            }
         }
       else
         {
@@ -771,9 +775,11 @@ namespace _goptical {
               {
                 _enabled_count--;
                 _enabled_list[i] = _enabled_list[_enabled_count];
-                return;
+                break;
               }
         }
+
+      update_version();
     }
 
     bool Zernike::get_term_state(unsigned int n)
@@ -149,6 +149,19 @@ namespace _goptical {
       _lookup = _update;
     }
 
+    void Grid::freeze() const
+    {
+      if (_lookup != _update)
+        return;
+
+      try {
+        unsigned int x[2];
+        (this->*_update)(x, _origin);
+      } catch (const Error &) {
+        // not enough data, thrown again on interpolation
+      }
+    }
+
     // **********************************************************************
 
     void Grid::update_nearest(unsigned int x[2], const math::Vector2 & v) const
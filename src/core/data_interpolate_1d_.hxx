@@ -699,6 +699,19 @@ namespace _goptical {
       return interpolate_cubic(d, x);
     }
 
+    template <class X>
+    void Interpolate1d<X>::freeze() const
+    {
+      if (_interpolate != _update)
+        return;
+
+      try {
+        (this->*_update)(0, X::get_count() ? X::get_x_value(0) : 0.0);
+      } catch (const Error &) {
+        // not enough data, thrown again on interpolation
+      }
+    }
+
     template <class X>
     void Interpolate1d<X>::invalidate()
     {
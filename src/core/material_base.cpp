@@ -31,14 +31,16 @@ namespace _goptical {
   namespace material {
 
     Base::Base()
-      : _temperature(20.0)
+      : _temperature(20.0),
+        _version(0)
     {
         std::cout << "material created" << std::endl;
     }
 
     Base::Base(const std::string& name_ )
       : _temperature(20.0),
-        name(name_)
+        name(name_),
+        _version(0)
     {
         std::cout << "material created " << name << std::endl;
     }
@@ -105,6 +107,7 @@ namespace _goptical {
     void Base::set_temperature(double temp)
     {
       _temperature = temp;
+      update_version();
     }
 
     double Base::get_temperature() const
@@ -112,6 +115,10 @@ namespace _goptical {
       return _temperature;
     }
 
+    void Base::freeze() const
+    {
+    }
+
   }
 }
 
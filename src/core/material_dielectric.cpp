@@ -38,7 +38,7 @@ namespace _goptical {
         _low_wavelen(350.0),
         _high_wavelen(750.0),
         _measurement_medium(std_air),
-        _last_wavelen(0)
+        _last_index()
     {
       _transmittance.set_interpolation(data::Cubic);
     }
@@ -65,6 +65,7 @@ namespace _goptical {
                                                 double transmittance)
     {
       _transmittance.add_data(wavelen, pow(transmittance, 1.0 / thickness));
+      update_version();
     }
 
     double Dielectric::get_internal_transmittance(double wavelen) const
@@ -90,9 +91,21 @@ namespace _goptical {
 
     double Dielectric::get_refractive_index(double wavelen) const
     {
-      if (wavelen == _last_wavelen) {
-          return _last_get_refractive_index;
-      }
+      unsigned int version = get_version();
+      unsigned int seq = _last_index._seq.load(std::memory_order_acquire);
+
+      if (!(seq & 1))
+        {
+          unsigned int v = _last_index._version.load(std::memory_order_relaxed);
+          double w = _last_index._wavelen.load(std::memory_order_relaxed);
+          double n = _last_index._index.load(std::memory_order_relaxed);
+
+          std::atomic_thread_fence(std::memory_order_acquire);
+
+          if (w == wavelen && v == version &&
+              _last_index._seq.load(std::memory_order_relaxed) == seq)
+            return n;
+        }
 
       double a = _measurement_medium->get_refractive_index(wavelen);
       double m = get_measurement_index(wavelen);
@@ -117,8 +130,15 @@ namespace _goptical {
           ;
         }
 
-      _last_wavelen = wavelen;
-      _last_get_refractive_index = n;
+      // skip cache update if an other thread is already writing
+      if (!(seq & 1) && _last_index._seq.compare_exchange_strong(seq, seq + 1,
+                                                                 std::memory_order_acquire))
+        {
+          _last_index._version.store(version, std::memory_order_relaxed);
+          _last_index._wavelen.store(wavelen, std::memory_order_relaxed);
+          _last_index._index.store(n, std::memory_order_relaxed);
+          _last_index._seq.store(seq + 2, std::memory_order_release);
+        }
 
       return n;
     }
@@ -150,6 +170,17 @@ namespace _goptical {
         / get_principal_dispersion();
     }
 
+    void Dielectric::freeze() const
+    {
+      _transmittance.freeze();
+      _measurement_medium->freeze();
+    }
+
+    unsigned int Dielectric::get_version() const
+    {
+      return Base::get_version() + _measurement_medium->get_version();
+    }
+
   }
 
 }
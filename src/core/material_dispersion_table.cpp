@@ -42,6 +42,12 @@ namespace _goptical {
       return _refractive_index.interpolate(wavelen);
     }
 
+    void DispersionTable::freeze() const
+    {
+      Dielectric::freeze();
+      _refractive_index.freeze();
+    }
+
   }
 
 }
@@ -65,6 +65,12 @@ namespace _goptical {
       return _extinction.interpolate(wavelen);
     }
 
+    void Metal::freeze() const
+    {
+      _extinction.freeze();
+      _refractive_index.freeze();
+    }
+
   }
 
 }
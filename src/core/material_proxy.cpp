@@ -79,6 +79,16 @@ namespace _goptical {
       return _m->get_color();
     }
 
+    void Proxy::freeze() const
+    {
+      _m->freeze();
+    }
+
+    unsigned int Proxy::get_version() const
+    {
+      return Base::get_version() + _m->get_version();
+    }
+
   }
 }
 
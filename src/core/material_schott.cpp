@@ -60,17 +60,11 @@ namespace _goptical {
 
       _coeff.resize(c / 2 + 1, 0.0);
       _first = first;
-
-      _last_wavelen = 0;
-      _last_wavelen_val = 0;
+      update_version();
     }
 
     double Schott::get_measurement_index(double wavelen) const
     {
-      if (_last_wavelen == wavelen) {
-          return _last_wavelen_val;
-      }
-        
       double wl = wavelen / 1000.0;
       double n = 0;
       double x = (double)_first;
@@ -81,10 +75,7 @@ namespace _goptical {
           x += 2.0;
         }
 
-      _last_wavelen = wavelen;
-      _last_wavelen_val = sqrt(n);
-
-      return _last_wavelen_val;
+      return sqrt(n);
     }
 
   }
@@ -26,6 +26,7 @@
 
 #include <goptical/core/shape/Base>
 #include <goptical/core/math/Vector>
+#include <goptical/core/math/Random>
 #include <goptical/core/trace/Distribution>
 
 namespace _goptical {
@@ -101,6 +102,8 @@ namespace _goptical {
 
         case trace::RandomDist: {
 
+          const math::Philox rng(d.get_seed());
+          uint64_t n = 0;
           double x, y;
 
           for (x = -tr; x < tr; x += step)
@@ -109,14 +112,37 @@ namespace _goptical {
 
               for (y = -ybound; y < ybound; y += step)
               {
-                  ADD_PATTERN_POINT(math::Vector2(x + (drand48() - .5) * step,
-                                                    y + (drand48() - .5) * step));
+                  double rx, ry;
+
+                  rng.get_uniform(n++, rx, ry);
+                  ADD_PATTERN_POINT(math::Vector2(x + (rx - .5) * step,
+                                                    y + (ry - .5) * step));
                 }
 
             }
           break;
         }
 
+        case trace::SobolDist:
+        case trace::HaltonDist: {
+
+          // points are drawn in the square which bounds the pattern
+          // disk, with the same average density as grid patterns
+          const unsigned int count = 4 * math::square(d.get_radial_density());
+          const math::Sobol2 sobol(d.get_seed());
+          const math::Halton2 halton(d.get_seed());
+
+          for (unsigned int i = 0; i < count; i++)
+            {
+              math::Vector2 u(p == trace::SobolDist ? sobol.get(i) : halton.get(i));
+              math::Vector2 v((u.x() * 2. - 1.) * tr, (u.y() * 2. - 1.) * tr);
+
+              if (math::square(v.x()) + math::square(v.y()) < math::square(tr))
+                ADD_PATTERN_POINT(v);
+            }
+          break;
+        }
+
         case trace::HexaPolarDist: {
 
           ADD_PATTERN_POINT(math::Vector2(0, 0));
@@ -210,6 +236,10 @@ namespace _goptical {
       return 0.;
     }
 
+    void Base::freeze() const
+    {
+    }
+
   }
 
 }
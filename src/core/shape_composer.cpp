@@ -46,7 +46,8 @@ namespace _goptical {
 
     Composer::Attributes::Attributes(const const_ref<Base> &shape)
       : _shape(shape),
-        _list()
+        _list(),
+        _version(0)
     {
       _transform.reset();
       _inv_transform.reset();
@@ -56,6 +57,7 @@ namespace _goptical {
     {
       _list.push_back(Attributes(shape));
       _update = true;
+      update_version();
       return _list.back();
     }
 
@@ -63,6 +65,7 @@ namespace _goptical {
     {
       _list.push_back(Attributes(shape));
       _list.back()._exclude = false;
+      _version++;
       return _list.back();
     }
 
@@ -70,6 +73,7 @@ namespace _goptical {
     {
       _list.push_back(Attributes(shape));
       _list.back()._exclude = true;
+      _version++;
       return _list.back();
     }
 
@@ -85,6 +89,34 @@ namespace _goptical {
       return res ^ _exclude;
     }
 
+    void Composer::Attributes::freeze() const
+    {
+      _shape->freeze();
+
+      for (auto& s:  _list)
+        s.freeze();
+    }
+
+    unsigned int Composer::Attributes::get_version() const
+    {
+      unsigned int v = _version + _shape->get_version();
+
+      for (auto& s:  _list)
+        v += s.get_version();
+
+      return v;
+    }
+
+    unsigned int Composer::get_version() const
+    {
+      unsigned int v = Base::get_version();
+
+      for (auto& s:  _list)
+        v += s.get_version();
+
+      return v;
+    }
+
     bool Composer::inside(const math::Vector2 &point) const
     {
       for (auto&s : _list)
@@ -141,6 +173,15 @@ namespace _goptical {
       const_cast<Composer*>(this)->update();
     }
 
+    void Composer::freeze() const
+    {
+      for (auto&s : _list)
+        s.freeze();
+
+      if (_update)
+        update();
+    }
+
     double Composer::max_radius() const
     {
       if (_update)
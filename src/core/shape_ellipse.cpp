@@ -43,6 +43,7 @@ namespace _goptical {
       _yr = y_radius;
       _xy_ratio = x_radius / y_radius;
       _e2 = math::square(sqrt(fabs(_xr * _xr - _yr * _yr)) / std::max(_xr, _yr));
+      update_version();
     }
 
     bool EllipseBase::inside(const math::Vector2 &point) const
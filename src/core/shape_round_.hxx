@@ -26,6 +26,7 @@
 
 #include <goptical/core/trace/Distribution>
 #include <goptical/core/math/Triangle>
+#include <goptical/core/math/Random>
 
 namespace _goptical {
 
@@ -102,6 +103,8 @@ namespace _goptical {
             f(math::Vector2(0, 0));
 
           const double bound = obstructed ? hr - epsilon : epsilon;
+          const math::Philox rng(d.get_seed());
+          uint64_t n = 0;
 
           double tr1 = tr / 20;
           for (double r = tr1; r > bound; r -= step)
@@ -110,8 +113,12 @@ namespace _goptical {
               // angle
               for (double a = 0; a < 2 * M_PI - epsilon; a += astep)
                 {
-                  math::Vector2 v(sin(a) * r       + (drand48() - .5) * step,
-                                    cos(a) * r * xyr + (drand48() - .5) * step);
+                  double rx, ry;
+
+                  rng.get_uniform(n++, rx, ry);
+
+                  math::Vector2 v(sin(a) * r       + (rx - .5) * step,
+                                    cos(a) * r * xyr + (ry - .5) * step);
                   double h = hypot(v.x(), v.y() / xyr);
                   if (h < tr && (h > hr || unobstructed))
                     f(v);
@@ -120,6 +127,29 @@ namespace _goptical {
 
         }  break;
 
+        case trace::SobolDist:
+        case trace::HaltonDist: {
+
+          if (!obstructed)
+            f(math::Vector2(0, 0));
+
+          // area preserving mapping of the unit square on the ring
+          const double area = math::square(tr) - math::square(hr);
+          const unsigned int count = ceil(M_PI * area / math::square(step));
+          const math::Sobol2 sobol(d.get_seed());
+          const math::Halton2 halton(d.get_seed());
+
+          for (unsigned int i = 0; i < count; i++)
+            {
+              math::Vector2 u(p == trace::SobolDist ? sobol.get(i) : halton.get(i));
+              double r = sqrt(math::square(hr) + u.x() * area);
+              double a = 2 * M_PI * u.y();
+
+              f(math::Vector2(sin(a) * r, cos(a) * r * xyr));
+            }
+
+        } break;
+
         case trace::DefaultDist:
         case trace::HexaPolarDist: {
 
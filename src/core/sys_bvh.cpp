@@ -0,0 +1,199 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#include <cmath>
+
+#include <goptical/core/sys/System>
+#include <goptical/core/sys/Surface>
+#include <goptical/core/curve/Base>
+#include <goptical/core/math/Transform>
+
+#include "sys_bvh_.hxx"
+
+namespace _goptical {
+
+  namespace sys {
+
+    Bvh::Bvh(const system &sys)
+      : _surfaces(),
+        _unbounded(),
+        _entries(),
+        _nodes()
+    {
+      for (unsigned int i = 1; i <= sys.get_element_count(); i++)
+        {
+          Surface *s = dynamic_cast<Surface*>(&sys.get_element(i));
+
+          if (!s)
+            continue;
+
+          _surfaces.push_back(s);
+
+          entry_s e;
+          e._surface = s;
+
+          if (global_box(*s, e._min, e._max))
+            _entries.push_back(e);
+          else
+            _unbounded.push_back(s);
+        }
+
+      if (!_entries.empty())
+        build(0, _entries.size());
+    }
+
+    bool Bvh::global_box(const Surface &s, math::Vector3 &min, math::Vector3 &max)
+    {
+      static const unsigned int samples = 16;
+
+      math::VectorPair3 b = s.get_intersect_bounding_box();
+
+      if (b[0].x() == b[1].x() || b[0].y() == b[1].y())
+        return false;
+
+      // Surface bounding box assumes a monotonic symmetric
+      // curve. Sample curve over the shape area to catch other
+      // curves extrema and add one sample step margin.
+
+      double zmin = b[0].z();
+      double zmax = b[1].z();
+
+      for (unsigned int i = 0; i <= samples; i++)
+        for (unsigned int j = 0; j <= samples; j++)
+          {
+            math::Vector2 p(b[0].x() + (b[1].x() - b[0].x()) * i / samples,
+                            b[0].y() + (b[1].y() - b[0].y()) * j / samples);
+            double z = s.get_curve().sagitta(p);
+
+            if (!std::isfinite(z))
+              continue;
+
+            zmin = std::min(zmin, z);
+            zmax = std::max(zmax, z);
+          }
+
+      double margin = (zmax - zmin) / samples;
+
+      b[0].z() = zmin - margin;
+      b[1].z() = zmax + margin;
+
+      const math::Transform<3> &t = s.get_global_transform();
+
+      min = math::Vector3(std::numeric_limits<double>::max());
+      max = math::Vector3(-std::numeric_limits<double>::max());
+
+      for (unsigned int c = 0; c < 8; c++)
+        {
+          math::Vector3 p(t.transform(math::Vector3(b[c & 1].x(),
+                                                    b[(c >> 1) & 1].y(),
+                                                    b[c >> 2].z())));
+
+          for (unsigned int j = 0; j < 3; j++)
+            {
+              min[j] = std::min(min[j], p[j]);
+              max[j] = std::max(max[j], p[j]);
+            }
+        }
+
+      // account for rounding errors in rays transforms
+      double eps = 1e-9 * (1.0 + (max - min).len()
+                           + std::max(min.len(), max.len()));
+
+      for (unsigned int j = 0; j < 3; j++)
+        {
+          min[j] -= eps;
+          max[j] += eps;
+        }
+
+      return true;
+    }
+
+    void Bvh::build(unsigned int first, unsigned int count)
+    {
+      unsigned int index = _nodes.size();
+
+      _nodes.push_back(node_s());
+
+      node_s n;
+      n._min = math::Vector3(std::numeric_limits<double>::max());
+      n._max = math::Vector3(-std::numeric_limits<double>::max());
+
+      math::Vector3 cmin(n._min);
+      math::Vector3 cmax(n._max);
+
+      for (unsigned int i = first; i < first + count; i++)
+        {
+          const entry_s &e = _entries[i];
+
+          for (unsigned int j = 0; j < 3; j++)
+            {
+              double c = (e._min[j] + e._max[j]) / 2.0;
+
+              n._min[j] = std::min(n._min[j], e._min[j]);
+              n._max[j] = std::max(n._max[j], e._max[j]);
+              cmin[j] = std::min(cmin[j], c);
+              cmax[j] = std::max(cmax[j], c);
+            }
+        }
+
+      if (count <= leaf_size)
+        {
+          n._index = first;
+          n._count = count;
+          _nodes[index] = n;
+          return;
+        }
+
+      // split along largest centers extent at median
+
+      unsigned int axis = 0;
+
+      for (unsigned int j = 1; j < 3; j++)
+        if (cmax[j] - cmin[j] > cmax[axis] - cmin[axis])
+          axis = j;
+
+      unsigned int half = count / 2;
+
+      std::nth_element(_entries.begin() + first,
+                       _entries.begin() + first + half,
+                       _entries.begin() + first + count,
+                       [=](const entry_s &a, const entry_s &b)
+                       {
+                         return a._min[axis] + a._max[axis] < b._min[axis] + b._max[axis];
+                       });
+
+      build(first, half);
+
+      n._index = _nodes.size();
+      n._count = 0;
+
+      build(first + half, count - half);
+
+      _nodes[index] = n;
+    }
+
+  }
+
+}
@@ -0,0 +1,194 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+/*
+  Bounding volume hierarchy of system surfaces.
+
+  Boxes are computed in global coordinates from surfaces local
+  intersect bounding boxes and are used to skip surfaces which can
+  not be hit by a ray line. Surfaces with unbounded shapes are always tested.
+*/
+
+#ifndef GOPTICAL_SYS_BVH_HXX_
+#define GOPTICAL_SYS_BVH_HXX_
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <vector>
+
+#include <goptical/core/sys/Surface>
+#include <goptical/core/math/VectorPair>
+
+namespace _goptical {
+
+  namespace sys {
+
+    /** @internal Surfaces bounding volume hierarchy */
+    class Bvh
+    {
+    public:
+      /** Build hierarchy from all surfaces of the system */
+      Bvh(const system &sys);
+
+      /** Call @tt f on all surfaces which may intersect the given
+          line in global coordinates. Line is not oriented as curves
+          intersections may lie behind the ray origin. */
+      template <typename F>
+      inline void find(const math::VectorPair3 &line, const F &f) const;
+
+      /** Get all system surfaces */
+      inline const std::vector<Surface *> & get_surfaces() const;
+
+    private:
+
+      struct entry_s
+      {
+        Surface         *_surface;
+        math::Vector3   _min;
+        math::Vector3   _max;
+      };
+
+      struct node_s
+      {
+        math::Vector3   _min;
+        math::Vector3   _max;
+        /** first entry for leaf nodes, right child for inner nodes,
+            left child immediately follows its parent */
+        unsigned int    _index;
+        /** entries count, 0 for inner nodes */
+        unsigned int    _count;
+      };
+
+      static const unsigned int leaf_size = 4;
+
+      /** Compute surface bounding box in global coordinates, return
+          false if surface is not bounded */
+      static bool global_box(const Surface &s, math::Vector3 &min, math::Vector3 &max);
+
+      void build(unsigned int first, unsigned int count);
+
+      static inline bool line_hit(const math::Vector3 &min, const math::Vector3 &max,
+                                  const math::Vector3 &o, const math::Vector3 &d,
+                                  const math::Vector3 &id);
+
+      std::vector<Surface *>    _surfaces;
+      std::vector<Surface *>    _unbounded;
+      std::vector<entry_s>      _entries;
+      std::vector<node_s>       _nodes;
+    };
+
+    const std::vector<Surface *> & Bvh::get_surfaces() const
+    {
+      return _surfaces;
+    }
+
+    bool Bvh::line_hit(const math::Vector3 &min, const math::Vector3 &max,
+                       const math::Vector3 &o, const math::Vector3 &d,
+                       const math::Vector3 &id)
+    {
+      double tmin = -std::numeric_limits<double>::infinity();
+      double tmax = std::numeric_limits<double>::infinity();
+
+      for (unsigned int j = 0; j < 3; j++)
+        {
+          if (d[j] == 0)
+            {
+              if (o[j] < min[j] || o[j] > max[j])
+                return false;
+              continue;
+            }
+
+          double t1 = (min[j] - o[j]) * id[j];
+          double t2 = (max[j] - o[j]) * id[j];
+
+          if (t1 > t2)
+            std::swap(t1, t2);
+
+          if (t1 > tmin)
+            tmin = t1;
+          if (t2 < tmax)
+            tmax = t2;
+
+          if (tmin > tmax)
+            return false;
+        }
+
+      return true;
+    }
+
+    template <typename F>
+    void Bvh::find(const math::VectorPair3 &line, const F &f) const
+    {
+      for (Surface *s : _unbounded)
+        f(s);
+
+      if (_nodes.empty())
+        return;
+
+      const math::Vector3 &o = line.origin();
+      const math::Vector3 &d = line.direction();
+      math::Vector3 id;
+
+      for (unsigned int j = 0; j < 3; j++)
+        id[j] = d[j] == 0 ? 0 : 1.0 / d[j];
+
+      unsigned int stack[64];
+      unsigned int sp = 0;
+
+      stack[sp++] = 0;
+
+      while (sp)
+        {
+          const node_s &n = _nodes[stack[--sp]];
+
+          if (!line_hit(n._min, n._max, o, d, id))
+            continue;
+
+          if (n._count)
+            {
+              for (unsigned int i = n._index; i < n._index + n._count; i++)
+                {
+                  const entry_s &e = _entries[i];
+
+                  if (n._count == 1 || line_hit(e._min, e._max, o, d, id))
+                    f(e._surface);
+                }
+            }
+          else
+            {
+              unsigned int self = &n - &_nodes[0];
+
+              assert(sp + 2 <= 64);
+              stack[sp++] = n._index;
+              stack[sp++] = self + 1;
+            }
+        }
+    }
+
+  }
+}
+
+#endif
@@ -236,6 +236,10 @@ namespace _goptical {
       update_version();
     }
 
+    void Element::freeze() const
+    {
+    }
+
     void Element::update_version()
     {
       Element *e;
@@ -30,6 +30,7 @@
 #include <goptical/core/curve/Flat>
 
 #include <goptical/core/trace/Ray>
+#include <goptical/core/trace/RayPacket>
 #include <goptical/core/trace/Distribution>
 #include <goptical/core/trace/Result>
 
@@ -136,7 +137,11 @@ namespace _goptical {
       }
 
       double wl = incident.get_wavelen();
-      double index = prev_mat->get_refractive_index(wl) / next_mat->get_refractive_index(wl);
+      unsigned int wl_index = incident.get_wavelen_index();
+      const trace::SpectralTable::interface_s *it
+        = result.get_spectral_table().get_interface(*this, right_to_left, wl_index);
+      double index = it && it->_index_valid ? it->_index_ratio
+        : prev_mat->get_refractive_index(wl) / next_mat->get_refractive_index(wl);
 
       if (!refract(local, direction, intersect.normal(), index))
         {
@@ -144,6 +149,7 @@ namespace _goptical {
           // total internal reflection
 
           r.set_wavelen(wl);
+          r.set_wavelen_index(wl_index);
           r.set_intensity(incident.get_intensity());
           r.set_material(prev_mat);
           r.origin() = intersect.origin();
@@ -160,6 +166,7 @@ namespace _goptical {
           trace::Ray &r = result.new_ray();
 
           r.set_wavelen(wl);
+          r.set_wavelen_index(wl_index);
           r.set_intensity(incident.get_intensity());
           r.set_material(next_mat);
           r.origin() = intersect.origin();
@@ -174,6 +181,7 @@ namespace _goptical {
           trace::Ray &r = result.new_ray();
 
           r.set_wavelen(wl);
+          r.set_wavelen_index(wl_index);
           r.set_intensity(incident.get_intensity());
           r.set_material(prev_mat);
           r.origin() = intersect.origin();
@@ -200,7 +208,11 @@ namespace _goptical {
         return;
 
       double wl = incident.get_wavelen();
-      double index = prev_mat->get_refractive_index(wl) / next_mat->get_refractive_index(wl);
+      unsigned int wl_index = incident.get_wavelen_index();
+      const trace::SpectralTable::interface_s *it
+        = result.get_spectral_table().get_interface(*this, right_to_left, wl_index);
+      double index = it && it->_index_valid ? it->_index_ratio
+        : prev_mat->get_refractive_index(wl) / next_mat->get_refractive_index(wl);
       double intensity = incident.get_intercept_intensity();
 
       if (!refract(local, direction, intersect.normal(), index))
@@ -209,6 +221,7 @@ namespace _goptical {
           trace::Ray &r = result.new_ray();
 
           r.set_wavelen(wl);
+          r.set_wavelen_index(wl_index);
           r.set_intensity(intensity);
           r.set_material(prev_mat);
           r.origin() = intersect.origin();
@@ -222,13 +235,15 @@ namespace _goptical {
       // transmit
       if (!next_mat->is_opaque())
         {
-          double tintensity = intensity * next_mat->get_normal_transmittance(prev_mat, wl);
+          double tintensity = intensity * (it && it->_intensity_valid ? it->_transmittance
+            : next_mat->get_normal_transmittance(prev_mat, wl));
 
           if (tintensity >= get_discard_intensity())
             {
               trace::Ray &r = result.new_ray();
 
               r.set_wavelen(wl);
+              r.set_wavelen_index(wl_index);
               r.set_intensity(tintensity);
               r.set_material(next_mat);
               r.origin() = intersect.origin();
@@ -240,13 +255,15 @@ namespace _goptical {
 
       // reflect
       {
-        double rintensity = intensity * next_mat->get_normal_reflectance(prev_mat, wl);
+        double rintensity = intensity * (it && it->_intensity_valid ? it->_reflectance
+          : next_mat->get_normal_reflectance(prev_mat, wl));
 
         if (rintensity >= get_discard_intensity())
           {
             trace::Ray &r = result.new_ray();
 
             r.set_wavelen(wl);
+            r.set_wavelen_index(wl_index);
             r.set_intensity(rintensity);
             r.set_material(prev_mat);
             r.origin() = intersect.origin();
@@ -258,6 +275,217 @@ namespace _goptical {
 
     }
 
+    void OpticalSurface::select_packet_materials(trace::RayPacket &packet,
+                                                 bool right_to_left[]) const
+    {
+      for (unsigned int i = 0; i < packet.get_count(); i++)
+        {
+          if (!packet._hit[i])
+            continue;
+
+          right_to_left[i] = packet._normal[2][i] > 0;
+
+          // check ray didn't "escaped" from its material
+          if (_mat[right_to_left[i]].ptr() != packet.get_ray(i).get_material())
+            packet._hit[i] = false;
+        }
+    }
+
+    void OpticalSurface::refract_packet(const trace::Result &result,
+                                        const trace::RayPacket &packet,
+                                        const bool right_to_left[],
+                                        double refracted[3][trace::RayPacket::size],
+                                        double reflected[3][trace::RayPacket::size],
+                                        bool refract[]) const
+    {
+      static const unsigned int size = trace::RayPacket::size;
+      double index[size];
+
+      const trace::SpectralTable &table = result.get_spectral_table();
+
+      // get index ratios from spectral table or computed once per
+      // wavelen and direction
+      double cache_wl[size];
+      bool cache_rtl[size];
+      double cache_index[size];
+      unsigned int cache_count = 0;
+
+      for (unsigned int i = 0; i < packet.get_count(); i++)
+        {
+          if (!packet._hit[i])
+            continue;
+
+          double wl = packet._wavelen[i];
+          bool rtl = right_to_left[i];
+          const trace::SpectralTable::interface_s *it
+            = table.get_interface(*this, rtl, packet._wavelen_index[i]);
+
+          if (it && it->_index_valid)
+            {
+              index[i] = it->_index_ratio;
+              continue;
+            }
+
+          unsigned int j;
+
+          for (j = 0; j < cache_count; j++)
+            if (cache_wl[j] == wl && cache_rtl[j] == rtl)
+              break;
+
+          if (j == cache_count)
+            {
+              cache_wl[j] = wl;
+              cache_rtl[j] = rtl;
+              cache_index[j] = _mat[rtl]->get_refractive_index(wl)
+                             / _mat[!rtl]->get_refractive_index(wl);
+              cache_count++;
+            }
+
+          index[i] = cache_index[j];
+        }
+
+      // same operations as refract and reflect functions
+      for (unsigned int i = 0; i < packet.get_count(); i++)
+        {
+          if (!packet._hit[i])
+            continue;
+
+          double cosi = 0;
+
+          for (unsigned int j = 0; j < 3; j++)
+            cosi += packet._normal[j][i] * packet._direction[j][i];
+
+          double sint2 = math::square(index[i]) * (1.0 - math::square(cosi));
+          double k = index[i] * cosi + sqrt(std::max(0.0, 1.0 - sint2));
+
+          refract[i] = !(sint2 > 1.0);
+
+          for (unsigned int j = 0; j < 3; j++)
+            {
+              refracted[j][i] = index[i] * packet._direction[j][i] - k * packet._normal[j][i];
+              reflected[j][i] = packet._direction[j][i] - (2.0 * cosi) * packet._normal[j][i];
+            }
+        }
+    }
+
+    void OpticalSurface::new_packet_ray(trace::Result &result, trace::RayPacket &packet,
+                                        unsigned int i, const double dir[3][trace::RayPacket::size],
+                                        double intensity, const material::Base *mat) const
+    {
+      trace::Ray &r = result.new_ray();
+
+      r.set_wavelen(packet._wavelen[i]);
+      r.set_wavelen_index(packet._wavelen_index[i]);
+      r.set_intensity(intensity);
+      r.set_material(mat);
+      r.origin() = math::Vector3(packet._point[0][i], packet._point[1][i], packet._point[2][i]);
+      r.direction() = math::Vector3(dir[0][i], dir[1][i], dir[2][i]);
+      r.set_creator(this);
+      packet.get_ray(i).add_generated(&r);
+    }
+
+    void OpticalSurface::trace_packet_simple(trace::Result &result,
+                                             trace::RayPacket &packet) const
+    {
+      // sub classes may reimplement trace_ray_simple
+      if (!has_packet_kernels())
+        return Surface::trace_packet_simple(result, packet);
+
+      static const unsigned int size = trace::RayPacket::size;
+      alignas(32) double refracted[3][size];
+      alignas(32) double reflected[3][size];
+      bool refract[size];
+      bool rtl[size];
+
+      select_packet_materials(packet, rtl);
+      refract_packet(result, packet, rtl, refracted, reflected, refract);
+
+      bool opaque[2] = { _mat[0]->is_opaque(), _mat[1]->is_opaque() };
+      bool reflecting[2] = { _mat[0]->is_reflecting(), _mat[1]->is_reflecting() };
+
+      for (unsigned int i = 0; i < packet.get_count(); i++)
+        {
+          if (!packet._hit[i])
+            continue;
+
+          const material::Base *prev_mat = _mat[rtl[i]].ptr();
+          const material::Base *next_mat = _mat[!rtl[i]].ptr();
+          double intensity = packet._intensity[i];
+
+          if (!refract[i])
+            {
+              // total internal reflection
+              new_packet_ray(result, packet, i, reflected, intensity, prev_mat);
+              continue;
+            }
+
+          // transmit
+          if (!opaque[!rtl[i]])
+            new_packet_ray(result, packet, i, refracted, intensity, next_mat);
+
+          // reflect
+          if (reflecting[!rtl[i]])
+            new_packet_ray(result, packet, i, reflected, intensity, prev_mat);
+        }
+    }
+
+    void OpticalSurface::trace_packet_intensity(trace::Result &result,
+                                                trace::RayPacket &packet) const
+    {
+      // sub classes may reimplement trace_ray_intensity
+      if (!has_packet_kernels())
+        return Surface::trace_packet_intensity(result, packet);
+
+      static const unsigned int size = trace::RayPacket::size;
+      alignas(32) double refracted[3][size];
+      alignas(32) double reflected[3][size];
+      bool refract[size];
+      bool rtl[size];
+
+      select_packet_materials(packet, rtl);
+      refract_packet(result, packet, rtl, refracted, reflected, refract);
+
+      bool opaque[2] = { _mat[0]->is_opaque(), _mat[1]->is_opaque() };
+      const trace::SpectralTable &table = result.get_spectral_table();
+
+      for (unsigned int i = 0; i < packet.get_count(); i++)
+        {
+          if (!packet._hit[i])
+            continue;
+
+          const material::Base *prev_mat = _mat[rtl[i]].ptr();
+          const material::Base *next_mat = _mat[!rtl[i]].ptr();
+          double intensity = packet._intensity[i];
+          double wl = packet._wavelen[i];
+          const trace::SpectralTable::interface_s *it
+            = table.get_interface(*this, rtl[i], packet._wavelen_index[i]);
+
+          if (!refract[i])
+            {
+              // total internal reflection
+              new_packet_ray(result, packet, i, reflected, intensity, prev_mat);
+              continue;
+            }
+
+          // transmit
+          if (!opaque[!rtl[i]])
+            {
+              double tintensity = intensity * (it && it->_intensity_valid ? it->_transmittance
+                : next_mat->get_normal_transmittance(prev_mat, wl));
+
+              if (tintensity >= get_discard_intensity())
+                new_packet_ray(result, packet, i, refracted, tintensity, next_mat);
+            }
+
+          // reflect
+          double rintensity = intensity * (it && it->_intensity_valid ? it->_reflectance
+            : next_mat->get_normal_reflectance(prev_mat, wl));
+
+          if (rintensity >= get_discard_intensity())
+            new_packet_ray(result, packet, i, reflected, rintensity, prev_mat);
+        }
+    }
+
     void OpticalSurface::set_material(unsigned index, const const_ref<material::Base> &m)
     {
       assert(index < 2);
@@ -266,6 +494,8 @@ namespace _goptical {
         _mat[index] = get_system()->get_environment_proxy();
       else
         _mat[index] = m;
+
+      update_version();
     }
 
     void OpticalSurface::system_register(system &s)
@@ -286,6 +516,14 @@ namespace _goptical {
       Surface::system_unregister();
     }
 
+    void OpticalSurface::freeze() const
+    {
+      Surface::freeze();
+
+      for (unsigned int i = 0; i < 2; i++)
+        _mat[i]->freeze();
+    }
+
     void OpticalSurface::print(std::ostream &o) const
     {
       o << " [" << id() << "]" << typeid(*this).name() << " at " << get_position() << " "
@@ -24,6 +24,10 @@
 
 
 #include <goptical/core/sys/Source>
+#include <goptical/core/sys/System>
+#include <goptical/core/material/Base>
+#include <goptical/core/trace/Result>
+#include <goptical/core/trace/Ray>
 
 namespace _goptical {
 
@@ -52,6 +56,43 @@ namespace _goptical {
         }
     }    
 
+    void Source::get_lines(trace::Result &result, std::vector<line_s> &lines) const
+    {
+      lines.clear();
+
+      for (auto &l : _spectrum)
+        {
+          line_s line = { l.get_wavelen(), l.get_intensity(),
+                          result.get_ray_wavelen_index(l.get_wavelen()) };
+          lines.push_back(line);
+        }
+    }
+
+    const material::Base * Source::get_ray_material() const
+    {
+      return _mat.valid() ? _mat.ptr() : &get_system()->get_environment_proxy();
+    }
+
+    void Source::emit_rays(trace::Result &result, const std::vector<line_s> &lines,
+                           const material::Base *mat, const math::Vector3 &origin,
+                           const math::Vector3 &direction, double weight) const
+    {
+      for (auto &l : lines)
+        {
+          trace::Ray &r = result.new_ray();
+
+          // generated rays use source coordinates
+          r.direction() = direction;
+          r.origin() = origin;
+
+          r.set_creator(this);
+          r.set_intensity(l._intensity * weight); // FIXME depends on distance from source and pattern density
+          r.set_wavelen(l._wavelen);
+          r.set_wavelen_index(l._wavelen_index);
+          r.set_material(mat);
+        }
+    }
+
     void Source::generate_rays_simple(trace::Result &result,
                                       const targets_t &entry) const
     {
@@ -70,6 +111,12 @@ namespace _goptical {
       throw Error("this light source is not designed generate light rays in polarized ray trace mode");
     }
 
+    void Source::freeze() const
+    {
+      if (_mat.valid())
+        _mat->freeze();
+    }
+
   }
 }
 
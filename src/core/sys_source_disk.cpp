@@ -22,9 +22,13 @@
 
 */
 
+#include <algorithm>
+#include <cmath>
 #include <limits>
 
 #include <goptical/core/math/Vector>
+#include <goptical/core/math/Random>
+#include <goptical/core/shape/Base>
 
 #include <goptical/core/sys/System>
 #include <goptical/core/sys/Source>
@@ -34,6 +38,7 @@
 #include <goptical/core/trace/Ray>
 #include <goptical/core/trace/Result>
 #include <goptical/core/trace/Params>
+#include <goptical/core/trace/Distribution>
 
 namespace _goptical {
 
@@ -49,7 +54,7 @@ namespace _goptical {
                    ? 
                    math::VectorPair3(-pos_dir, math::vector3_001)
 //                   math::VectorPair3(pos_dir, math::vector3_001)
-                   : math::VectorPair3(math::Vector3(0,0,0)/*pos_dir * -1e9*/, pos_dir)),
+                   : math::VectorPair3(pos_dir, math::vector3_001)),
             _mode(m),
             _size(size),
             _direction(pos_dir),
@@ -58,6 +63,140 @@ namespace _goptical {
       {
       }
       
+    /** Map unit square to unit disk, preserving strata areas */
+    static math::Vector2 square_to_disk(double u, double v)
+    {
+      double a = 2.0 * u - 1.0;
+      double b = 2.0 * v - 1.0;
+
+      if (a == 0.0 && b == 0.0)
+        return math::vector2_0;
+
+      double r, phi;
+
+      if (fabs(a) > fabs(b))
+        {
+          r = a;
+          phi = M_PI / 4.0 * (b / a);
+        }
+      else
+        {
+          r = b;
+          phi = M_PI / 2.0 - M_PI / 4.0 * (a / b);
+        }
+
+      return math::Vector2(r * cos(phi), r * sin(phi));
+    }
+
+    /** Stateless pseudo random permutation of [0, count), see
+        A. Kensler, Correlated Multi-Jittered Sampling */
+    static uint32_t permute(uint32_t i, uint32_t count, uint32_t p)
+    {
+      uint32_t w = count - 1;
+
+      w |= w >> 1;
+      w |= w >> 2;
+      w |= w >> 4;
+      w |= w >> 8;
+      w |= w >> 16;
+
+      do
+        {
+          i ^= p;
+          i *= 0xe170893d;
+          i ^= p >> 16;
+          i ^= (i & w) >> 4;
+          i ^= p >> 8;
+          i *= 0x0929eb3f;
+          i ^= p >> 23;
+          i ^= (i & w) >> 1;
+          i *= 1 | p >> 27;
+          i *= 0x6935fa69;
+          i ^= (i & w) >> 11;
+          i *= 0x74dcb303;
+          i ^= (i & w) >> 2;
+          i *= 0x9e501cc3;
+          i ^= (i & w) >> 2;
+          i *= 0xc860a3df;
+          i &= w;
+          i ^= i >> 5;
+        }
+      while (i >= count);
+
+      return (i + p) % count;
+    }
+
+    void SourceDisk::get_finite_lightrays(trace::Result &result,
+                                          const Surface &target) const
+    {
+      const trace::Distribution &d = result.get_params().get_distribution(target);
+
+      // half angle of the emission cone which contains rays from
+      // emitter edge to target edge
+      math::Vector3 c = target.get_position(*this);
+      double sin_max = 1.0;
+
+      if (c.z() > 0)
+        {
+          double t = (sqrt(math::square(c.x()) + math::square(c.y()))
+                      + target.get_shape().max_radius()
+                      + std::max(_size.x(), _size.y()) / 2.0) / c.z();
+
+          sin_max = t / sqrt(1.0 + t * t);
+        }
+
+      // both emitter area and emission cone are split in strata x
+      // strata cells, each emitter cell is paired with one cone cell
+      const uint32_t strata = 2 * d.get_radial_density();
+      const uint32_t count = strata * strata;
+      const math::Philox rng(d.get_seed());
+      uint32_t key[4];
+
+      rng.get(std::numeric_limits<uint64_t>::max(), key);
+
+      std::vector<line_s> lines;
+      get_lines(result, lines);
+
+      const material::Base *mat = get_ray_material();
+
+      // storage is recycled batch after batch when streaming
+      if (!result.is_streaming())
+        result.reserve_rays(count * lines.size());
+
+      // samples only depend on their index
+      for (uint32_t i = 0; i < count; i++)
+        {
+          double u[4];
+
+          rng.get_uniform(2 * (uint64_t)i, u[0], u[1]);
+          rng.get_uniform(2 * (uint64_t)i + 1, u[2], u[3]);
+
+          uint32_t k = permute(i, count, key[0]);
+
+          math::Vector2 e = square_to_disk((i % strata + u[0]) / strata,
+                                           (i / strata + u[1]) / strata);
+          math::Vector2 a = square_to_disk((k % strata + u[2]) / strata,
+                                           (k / strata + u[3]) / strata);
+
+          math::Vector3 origin(e.x() * _size.x() / 2.0,
+                               e.y() * _size.y() / 2.0, 0);
+
+          if (origin[0] < _limit1[0] ||
+              origin[0] > _limit2[0] ||
+              origin[1] < _limit1[1] ||
+              origin[1] > _limit2[1])
+            continue;
+
+          // uniform disk lifted to the cone is cosine weighted
+          math::Vector3 direction(a.x() * sin_max, a.y() * sin_max,
+                                  sqrt(std::max(0.0, 1.0 - (math::square(a.x()) +
+                                       math::square(a.y())) * math::square(sin_max))));
+
+          emit_rays(result, lines, mat, origin, direction,
+                    _angular ? _angular(acos(direction.z())) : 1.0);
+        }
+    }
+
     template <SourceInfinityMode mode>
     void SourceDisk::get_lightrays_(trace::Result &result,
                                      const Element &target) const
@@ -67,63 +206,35 @@ namespace _goptical {
       if (!starget)
         return;
 
-      double rlen = result.get_params().get_lost_ray_length();
+      if (mode == SourceAtFiniteDistance)
+        return get_finite_lightrays(result, *starget);
+
       const trace::Distribution &d = result.get_params().get_distribution(*starget);
 
-      // i is point on target surface
-      auto de = [&]( const math::Vector3 &i ) {
-          //math::Vector3 r_ = starget->get_transform_to(*this).transform(i);  // pattern point on target surface
+      std::shared_ptr<const std::vector<math::Vector3> > pattern =
+        starget->get_pattern(d, result.get_params().get_unobstructed());
 
-          if (i[0] < _limit1[0] ||
-              i[0] > _limit2[0] ||
-              i[1] < _limit1[1] ||
-              i[1] > _limit2[1]) {
-              return;
-          }
+      std::vector<line_s> lines;
+      get_lines(result, lines);
 
-          math::Vector3 direction;
-          math::Vector3 position;
-
-          switch (mode)
-          {
-          case (SourceAtFiniteDistance):
-              //position = math::vector3_0;
-              //direction = r_.normalized();
-              break;
-
-          case (SourceAtInfinity):
-//              std::cout << direction << " " << i << std::endl;
-//              exit(-1);
-//              for (double xi = -_size.x()/2.0; xi < _size.x()/2.0; xi+=_size.x()/10) {
-//                  for (double yi = -_size.y()/2.0; yi < _size.y()/2.0; yi+=_size.y()/10) {
-                      for (auto&l : this->_spectrum) {
-                          trace::Ray &r = result.new_ray();
-
-                          math::Vector3 z(0,0,10000);
-                          math::Vector3 v(0,0,1);
-
-//                          r.direction() = math::Vector3(0, 0, 1).normalize();
-                          r.direction() = math::Vector3(0, 0, 1).normalize();
-//_direction;//_direction.normalized();//_direction.normalized();
-                          r.origin() = i - r.direction() * 1.0;
-                          //(r_ - _direction.normalized() * 100.0);
-
-                          r.set_creator(this);
-                          r.set_intensity(l.get_intensity()); // FIXME depends on distance from source and pattern density
-                          r.set_wavelen(l.get_wavelen());
-                          r.set_material(_mat.valid() ? _mat.ptr() : &get_system()->get_environment_proxy());
-//                      }
-//                  }
-              }
-
-
-              break;
-          }
+      const math::Vector3 direction(0, 0, 1);
+      const material::Base *mat = get_ray_material();
 
-      };
+      // storage is recycled batch after batch when streaming
+      if (!result.is_streaming())
+        result.reserve_rays(pattern->size() * lines.size());
 
-      starget->get_pattern(de, d, result.get_params().get_unobstructed());
+      // i is point on target surface
+      for (auto &i : *pattern)
+        {
+          if (i[0] < _limit1[0] ||
+              i[0] > _limit2[0] ||
+              i[1] < _limit1[1] ||
+              i[1] > _limit2[1])
+            continue;
 
+          emit_rays(result, lines, mat, i - direction * 1.0, direction, 1.0);
+        }
     }
 
     void SourceDisk::generate_rays_simple(trace::Result &result,
@@ -160,6 +271,13 @@ namespace _goptical {
     {
         _limit1 = limit1;
         _limit2 = limit2;
+        update_version();
+    }
+
+    void SourceDisk::set_angular_distribution(const angular_t &f)
+    {
+      _angular = f;
+      update_version();
     }
 
   }
@@ -24,6 +24,7 @@
 
 #define DPP_DELEGATE_ARGC 5
 
+#include <algorithm>
 #include <limits>
 
 #include <goptical/core/math/Vector>
@@ -61,44 +62,40 @@ namespace _goptical {
       double rlen = result.get_params().get_lost_ray_length();
       const trace::Distribution &d = result.get_params().get_distribution(*starget);
 
-      auto de = [&]( const math::Vector3 &i ) {
-          math::Vector3 r = starget->get_transform_to(*this).transform(i);  // pattern point on target surface
-          math::Vector3 direction;
-          math::Vector3 position;
+      std::shared_ptr<const std::vector<math::Vector3> > pattern =
+        starget->get_pattern(d, result.get_params().get_unobstructed());
+
+      std::vector<line_s> lines;
+      get_lines(result, lines);
+
+      const math::Transform<3> &t = starget->get_transform_to(*this);
+      const math::VectorPair3 plane(starget->get_position(*this) -
+                                    math::vector3_001 * rlen, math::vector3_001);
+      const material::Base *mat = get_ray_material();
+
+      // storage is recycled batch after batch when streaming
+      if (!result.is_streaming())
+        result.reserve_rays(pattern->size() * lines.size());
+
+      for (auto &i : *pattern)
+        {
+          math::Vector3 r = t.transform(i);  // pattern point on target surface
 
           switch (mode)
-          {
-          case (SourceAtFiniteDistance):
-              position = math::vector3_0;
-              direction = r.normalized();
-              break;
-              
-          case (SourceAtInfinity):
-              direction = math::vector3_001;
-              position = math::VectorPair3(starget->get_position(*this) -
-                                           math::vector3_001 * rlen, math::vector3_001).
-                  pl_ln_intersect(math::VectorPair3(r, direction));
+            {
+            case (SourceAtFiniteDistance):
+              emit_rays(result, lines, mat, math::vector3_0, r.normalized(), 1.0);
               break;
-          }
-          
-          for (auto&l : this->_spectrum) {
-              trace::Ray &r = result.new_ray();
-              
-              // generated rays use source coordinates
-              r.direction() = direction;
-              r.origin() = position;
-              
-              r.set_creator(this);
-              r.set_intensity(l.get_intensity()); // FIXME depends on distance from source and pattern density
-              r.set_wavelen(l.get_wavelen());
-              r.set_material(_mat.valid() ? _mat.ptr() : &get_system()->get_environment_proxy());
-          }
-      };
-      
-      starget->get_pattern(de, d, result.get_params().get_unobstructed());
 
+            case (SourceAtInfinity):
+              emit_rays(result, lines, mat,
+                        plane.pl_ln_intersect(math::VectorPair3(r, math::vector3_001)),
+                        math::vector3_001, 1.0);
+              break;
+            }
+        }
     }
-        
+
     void SourcePoint::generate_rays_simple(trace::Result &result,
                                            const targets_t &entry) const
     {
@@ -0,0 +1,231 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <goptical/core/sys/SourceRayFile>
+#include <goptical/core/sys/System>
+#include <goptical/core/Error>
+
+#include <goptical/core/trace/Ray>
+#include <goptical/core/trace/Result>
+
+namespace _goptical {
+
+  namespace sys {
+
+    static const char ray_file_magic[8] = { 'G', 'O', 'R', 'A', 'Y', 'S', '0', '1' };
+
+    SourceRayFile::SourceRayFile(const std::string &filename,
+                                 const math::Vector3 &position)
+      : Source(position),
+        _map(0),
+        _map_size(0),
+        _records(0),
+        _count(0),
+        _wavelens()
+    {
+      open(filename);
+    }
+
+    SourceRayFile::~SourceRayFile()
+    {
+      close();
+    }
+
+    void SourceRayFile::open(const std::string &filename)
+    {
+      close();
+
+      int fd = ::open(filename.c_str(), O_RDONLY);
+
+      if (fd < 0)
+        throw Error("unable to open ray file " + filename);
+
+      struct stat st;
+
+      if (fstat(fd, &st) || (size_t)st.st_size < sizeof(header_s))
+        {
+          ::close(fd);
+          throw Error("bad ray file " + filename);
+        }
+
+      void *map = mmap(0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+      ::close(fd);
+
+      if (map == MAP_FAILED)
+        throw Error("unable to map ray file " + filename);
+
+      _map = map;
+      _map_size = st.st_size;
+
+      const header_s *h = static_cast<const header_s *>(_map);
+
+      if (memcmp(h->_magic, ray_file_magic, sizeof(ray_file_magic)) ||
+          h->_record_size != sizeof(record_s) ||
+          h->_count > (_map_size - sizeof(header_s)) / sizeof(record_s))
+        {
+          close();
+          throw Error("bad ray file " + filename);
+        }
+
+      // rays are read once in file order
+      madvise(_map, _map_size, MADV_SEQUENTIAL);
+
+      _records = reinterpret_cast<const record_s *>(h + 1);
+      _count = h->_count;
+
+      // wavelens must all be declared before rays generation
+      float last = std::numeric_limits<float>::quiet_NaN();
+
+      for (size_t i = 0; i < _count; i++)
+        {
+          float wl = _records[i]._wavelen;
+
+          if (wl != last)
+            _wavelens.push_back(wl);
+
+          last = wl;
+        }
+
+      std::sort(_wavelens.begin(), _wavelens.end());
+      _wavelens.erase(std::unique(_wavelens.begin(), _wavelens.end()), _wavelens.end());
+
+      // each ray must refer to a precomputed spectral table entry
+      if (_wavelens.size() >= trace::Ray::no_wavelen_index)
+        {
+          close();
+          throw Error("too many distinct wavelens in ray file " + filename);
+        }
+
+      update_version();
+    }
+
+    void SourceRayFile::close()
+    {
+      if (_map)
+        munmap(_map, _map_size);
+
+      _map = 0;
+      _map_size = 0;
+      _records = 0;
+      _count = 0;
+      _wavelens.clear();
+    }
+
+    void SourceRayFile::write(const std::string &filename,
+                              const std::vector<light::Ray> &rays)
+    {
+      std::ofstream out(filename.c_str(), std::ios::binary);
+      header_s h;
+
+      memset(&h, 0, sizeof(h));
+      memcpy(h._magic, ray_file_magic, sizeof(ray_file_magic));
+      h._record_size = sizeof(record_s);
+      h._count = rays.size();
+
+      out.write(reinterpret_cast<const char *>(&h), sizeof(h));
+
+      for (auto &r : rays)
+        {
+          record_s rec;
+
+          for (unsigned int j = 0; j < 3; j++)
+            {
+              rec._origin[j] = r.origin()[j];
+              rec._direction[j] = r.direction()[j];
+            }
+
+          rec._wavelen = r.get_wavelen();
+          rec._flux = r.get_intensity();
+
+          out.write(reinterpret_cast<const char *>(&rec), sizeof(rec));
+        }
+
+      if (!out)
+        throw Error("unable to write ray file " + filename);
+    }
+
+    void SourceRayFile::generate_rays_simple(trace::Result &result,
+                                             const targets_t &entry) const
+    {
+      const material::Base *m = _mat.valid()
+        ? _mat.ptr() : &get_system()->get_environment_proxy();
+
+      std::vector<unsigned int> wl_index;
+
+      for (auto &wl : _wavelens)
+        wl_index.push_back(result.add_ray_wavelen(wl));
+
+      float last_wl = std::numeric_limits<float>::quiet_NaN();
+      unsigned int last_index = trace::Ray::no_wavelen_index;
+
+      for (size_t first = 0; first < _count; first += _chunk_size)
+        {
+          size_t last = std::min<size_t>(_count, first + _chunk_size);
+
+          result.reserve_rays(last - first);
+
+          for (size_t i = first; i < last; i++)
+            {
+              const record_s &rec = _records[i];
+              trace::Ray &r = result.new_ray();
+
+              // rays of the same wavelen are usually grouped in file
+              if (rec._wavelen != last_wl)
+                {
+                  last_wl = rec._wavelen;
+                  last_index = wl_index[std::lower_bound(_wavelens.begin(), _wavelens.end(),
+                                                         last_wl) - _wavelens.begin()];
+                }
+
+              r.origin() = math::Vector3(rec._origin[0], rec._origin[1], rec._origin[2]);
+              r.direction() = math::Vector3(rec._direction[0], rec._direction[1], rec._direction[2]);
+              r.set_intensity(rec._flux);
+              r.set_wavelen(rec._wavelen);
+              r.set_wavelen_index(last_index);
+              r.set_creator(this);
+              r.set_material(m);
+            }
+        }
+    }
+
+    void SourceRayFile::generate_rays_intensity(trace::Result &result,
+                                                const targets_t &entry) const
+    {
+      generate_rays_simple(result, entry);
+    }
+
+  }
+
+}
+
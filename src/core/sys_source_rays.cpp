@@ -146,17 +146,33 @@ namespace _goptical {
       const material::Base *m = _mat.valid()
         ? _mat.ptr() : &get_system()->get_environment_proxy();
 
+      // wavelen indexes are resolved once per distinct wavelen
+      std::map<double, unsigned int> wl_index;
+
       for (auto&w :  _wl_map) {
           if (w.second)
-              result.add_ray_wavelen(w.first);
+              wl_index[w.first] = result.add_ray_wavelen(w.first);
       }
 
+      double last_wl = std::numeric_limits<double>::quiet_NaN();
+      unsigned int last_index = trace::Ray::no_wavelen_index;
+
       for (auto &lr : _rays)
         {
           trace::Ray &r = result.new_ray(lr);
 
+          // rays of the same wavelen are usually added in sequence
+          if (lr.get_wavelen() != last_wl)
+            {
+              auto i = wl_index.find(lr.get_wavelen());
+
+              last_wl = lr.get_wavelen();
+              last_index = i != wl_index.end() ? i->second : trace::Ray::no_wavelen_index;
+            }
+
           r.set_creator(this);
           r.set_material(m);
+          r.set_wavelen_index(last_index);
         }
     }
 
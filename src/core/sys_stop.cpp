@@ -22,6 +22,8 @@
 
 */
 
+#include <algorithm>
+
 #include <goptical/core/sys/Stop>
 
 #include <goptical/core/trace/Result>
@@ -80,6 +82,19 @@ namespace _goptical {
       return true;
     }
 
+    math::VectorPair3 Stop::get_intersect_bounding_box() const
+    {
+      math::VectorPair3 b = get_bounding_box();
+
+      for (unsigned int j = 0; j < 2; j++)
+        {
+          b[0][j] = std::min(b[0][j], -_external_radius);
+          b[1][j] = std::max(b[1][j], _external_radius);
+        }
+
+      return b;
+    }
+
     inline void Stop::trace_ray_simple(trace::Result &result, trace::Ray &incident,
                                        const math::VectorPair3 &local, const math::VectorPair3 &intersect) const
     {
@@ -93,6 +108,7 @@ namespace _goptical {
           trace::Ray &r = result.new_ray();
 
           r.set_wavelen(incident.get_wavelen());
+          r.set_wavelen_index(incident.get_wavelen_index());
           r.set_intensity(incident.get_intensity());
           r.set_material(incident.get_material());
           r.origin() = intersect.origin();
@@ -118,7 +134,7 @@ namespace _goptical {
           math::VectorPair3 intersect;
           trace::Ray  &ray = *i;
 
-          const math::Transform<3> &t = ray.get_creator()->get_transform_to(*this);
+          const math::Transform<3> &t = result.get_transform(*ray.get_creator(), *this);
           math::VectorPair3 local(t.transform_line(ray));
 
           if (get_curve().intersect(intersect.origin(), local))
@@ -23,14 +23,27 @@
 */
 
 
+#include <algorithm>
+#include <limits>
+#include <typeinfo>
+
 #include <goptical/core/sys/Surface>
+#include <goptical/core/sys/OpticalSurface>
+#include <goptical/core/sys/Image>
+#include <goptical/core/sys/Mirror>
 #include <goptical/core/sys/Element>
 #include <goptical/core/material/Base>
 
 #include <goptical/core/shape/Base>
 #include <goptical/core/shape/Ring>
+#include <goptical/core/shape/Disk>
+#include <goptical/core/shape/Rectangle>
 
 #include <goptical/core/curve/Base>
+#include <goptical/core/curve/Sphere>
+#include <goptical/core/curve/Conic>
+#include <goptical/core/curve/Parabola>
+#include <goptical/core/curve/Flat>
 
 #include <goptical/core/math/Vector>
 #include <goptical/core/math/Triangle>
@@ -39,6 +52,7 @@
 
 #include <goptical/core/trace/Distribution>
 #include <goptical/core/trace/Ray>
+#include <goptical/core/trace/RayPacket>
 #include <goptical/core/trace/Result>
 #include <goptical/core/trace/Params>
 
@@ -56,24 +70,85 @@ namespace _goptical {
       : Element(p),
         _discard_intensity(0),
         _curve(curve),
-        _shape(shape)
+        _shape(shape),
+        _pattern_cache(),
+        _pattern_lock()
     {
+      update_kernels();
     }
 
     Surface::~Surface()
     {
     }
 
+    void Surface::freeze() const
+    {
+      _curve->freeze();
+      _shape->freeze();
+    }
+
     void Surface::get_pattern(const math::Vector3::put_delegate_t &f,
                               const trace::Distribution &d,
                               bool unobstructed) const
     {
-        auto de = [&](const math::Vector2 &v2d) {
-          f(math::Vector3(v2d, _curve->sagitta(v2d)));
-        };
+      std::shared_ptr<const std::vector<math::Vector3> > points =
+        get_pattern(d, unobstructed);
+
+      for (auto &p : *points)
+        f(p);
+    }
+
+    std::shared_ptr<const std::vector<math::Vector3> >
+    Surface::get_pattern(const trace::Distribution &d, bool unobstructed) const
+    {
+      // system may be shared by tracers running in different threads
+      std::lock_guard<std::mutex> lock(_pattern_lock);
+
+      // curve and shape may have been modified in place since patterns
+      // were computed
+      unsigned int cv = _curve->get_version();
+      unsigned int sv = _shape->get_version();
+
+      for (auto i = _pattern_cache.begin(); i != _pattern_cache.end(); )
+        if (i->_curve_version != cv || i->_shape_version != sv)
+          i = _pattern_cache.erase(i);
+        else
+          ++i;
+
+      for (auto i = _pattern_cache.begin(); i != _pattern_cache.end(); ++i)
+        if (i->_dist == d && i->_unobstructed == unobstructed)
+          {
+            pattern_cache_s c = *i;
+
+            _pattern_cache.erase(i);
+            _pattern_cache.push_back(c);
+            return c._points;
+          }
+
+      std::shared_ptr<std::vector<math::Vector3> > points =
+        std::make_shared<std::vector<math::Vector3> >();
+
+      auto de = [&](const math::Vector2 &v2d) {
+        points->push_back(math::Vector3(v2d, _curve->sagitta(v2d)));
+      };
 
       // get distribution from shape
       _shape->get_pattern(de, d, unobstructed);
+
+      if (_pattern_cache.size() >= _pattern_cache_size)
+        _pattern_cache.erase(_pattern_cache.begin());
+
+      pattern_cache_s c = { d, unobstructed, cv, sv, points };
+      _pattern_cache.push_back(c);
+
+      return points;
+    }
+
+    void Surface::flush_pattern_cache()
+    {
+      std::lock_guard<std::mutex> lock(_pattern_lock);
+
+      _pattern_cache.clear();
     }
 
     void Surface::trace_ray_simple(trace::Result &result, trace::Ray &incident,
@@ -94,22 +169,307 @@ namespace _goptical {
       throw Error("polarized ray trace not handled by this surface class");
     }
 
+    // Curve and shape calls are bound at compile time when the exact
+    // type is known, overloads taking base classes use virtual calls.
+
+    template <class C>
+    static inline bool curve_intersect(const C &c, math::Vector3 &point,
+                                       const math::VectorPair3 &ray)
+    {
+      return c.C::intersect(point, ray);
+    }
+
+    static inline bool curve_intersect(const curve::Base &c, math::Vector3 &point,
+                                       const math::VectorPair3 &ray)
+    {
+      return c.intersect(point, ray);
+    }
+
+    template <class C, typename T>
+    static inline void curve_intersect_batch(const C &c, unsigned int count,
+                                             const T *const origin[3],
+                                             const T *const direction[3],
+                                             T *const point[3], bool hit[])
+    {
+      c.C::intersect_batch(count, origin, direction, point, hit);
+    }
+
+    template <typename T>
+    static inline void curve_intersect_batch(const curve::Base &c, unsigned int count,
+                                             const T *const origin[3],
+                                             const T *const direction[3],
+                                             T *const point[3], bool hit[])
+    {
+      c.intersect_batch(count, origin, direction, point, hit);
+    }
+
+    template <class C>
+    static inline void curve_normal(const C &c, math::Vector3 &normal,
+                                    const math::Vector3 &point)
+    {
+      c.C::normal(normal, point);
+    }
+
+    static inline void curve_normal(const curve::Base &c, math::Vector3 &normal,
+                                    const math::Vector3 &point)
+    {
+      c.normal(normal, point);
+    }
+
+    template <class S>
+    static inline bool shape_inside(const S &s, const math::Vector2 &point)
+    {
+      return s.S::inside(point);
+    }
+
+    static inline bool shape_inside(const shape::Base &s, const math::Vector2 &point)
+    {
+      return s.inside(point);
+    }
+
     bool Surface::intersect(const trace::Params &params, math::VectorPair3 &pt, const math::VectorPair3 &ray) const
     {
-      if (!_curve->intersect(pt.origin(), ray))
+      return (this->*_intersect)(params, pt, ray);
+    }
+
+    bool Surface::has_packet_kernels() const
+    {
+      const std::type_info &t = typeid(*this);
+
+      // exact type match only, user subclasses may reimplement intersect
+      return t == typeid(OpticalSurface) || t == typeid(Image) ||
+        t == typeid(Mirror);
+    }
+
+    void Surface::intersect_packet(const trace::Params &params,
+                                   trace::RayPacket &packet) const
+    {
+      if (has_packet_kernels())
+        (this->*_intersect_packet)(params, packet);
+      else
+        intersect_packet_rays(params, packet);
+    }
+
+    void Surface::intersect_packet_rays(const trace::Params &params,
+                                        trace::RayPacket &packet) const
+    {
+      for (unsigned int i = 0; i < packet.get_count(); i++)
+        {
+          math::VectorPair3 pt;
+
+          packet._hit[i] = intersect(params, pt, packet.get_local(i));
+
+          if (!packet._hit[i])
+            continue;
+
+          for (unsigned int j = 0; j < 3; j++)
+            {
+              packet._point[j][i] = pt.origin()[j];
+              packet._normal[j][i] = pt.normal()[j];
+            }
+        }
+    }
+
+    template <class C, class S>
+    bool Surface::intersect_(const trace::Params &params, math::VectorPair3 &pt,
+                             const math::VectorPair3 &ray) const
+    {
+      const C &curve = static_cast<const C &>(*_curve);
+      const S &shape = static_cast<const S &>(*_shape);
+
+      if (!curve_intersect(curve, pt.origin(), ray))
         return false;
 
       if (!params.get_unobstructed() &&
-          !_shape->inside(pt.origin().project_xy()))
+          !shape_inside(shape, pt.origin().project_xy()))
         return false;
 
-      _curve->normal(pt.normal(), pt.origin());
+      curve_normal(curve, pt.normal(), pt.origin());
       if (ray.direction().z() < 0)
         pt.normal() = -pt.normal();
 
       return true;
     }
 
+    template <class C, class S>
+    void Surface::intersect_packet_(const trace::Params &params,
+                                    trace::RayPacket &packet) const
+    {
+      const C &curve = static_cast<const C &>(*_curve);
+      const S &shape = static_cast<const S &>(*_shape);
+
+      const double *const origin[3] =
+        { packet._origin[0], packet._origin[1], packet._origin[2] };
+      const double *const direction[3] =
+        { packet._direction[0], packet._direction[1], packet._direction[2] };
+      double *const point[3] =
+        { packet._point[0], packet._point[1], packet._point[2] };
+
+      if (params.get_precision_mode() == trace::MixedPrecision)
+        {
+          const float *const origin_f[3] =
+            { packet._origin_f[0], packet._origin_f[1], packet._origin_f[2] };
+          const float *const direction_f[3] =
+            { packet._direction_f[0], packet._direction_f[1], packet._direction_f[2] };
+          float *const point_f[3] =
+            { packet._point_f[0], packet._point_f[1], packet._point_f[2] };
+
+          curve_intersect_batch(curve, packet.get_count(), origin_f, direction_f,
+                                point_f, packet._hit);
+
+          for (unsigned int j = 0; j < 3; j++)
+            for (unsigned int i = 0; i < packet.get_count(); i++)
+              point[j][i] = point_f[j][i];
+        }
+      else
+        {
+          curve_intersect_batch(curve, packet.get_count(), origin, direction,
+                                point, packet._hit);
+        }
+
+      for (unsigned int i = 0; i < packet.get_count(); i++)
+        {
+          if (!packet._hit[i])
+            continue;
+
+          math::Vector3 p(point[0][i], point[1][i], point[2][i]);
+
+          if (!params.get_unobstructed() &&
+              !shape_inside(shape, p.project_xy()))
+            {
+              packet._hit[i] = false;
+              continue;
+            }
+
+          math::Vector3 n;
+          curve_normal(curve, n, p);
+          if (direction[2][i] < 0)
+            n = -n;
+
+          for (unsigned int j = 0; j < 3; j++)
+            packet._normal[j][i] = n[j];
+        }
+    }
+
+    template <class C>
+    void Surface::select_kernels()
+    {
+      const std::type_info &t = typeid(*_shape);
+
+      // exact type match only, user subclasses use generic functions
+      if (t == typeid(shape::Disk))
+        {
+          _intersect = &Surface::intersect_<C, shape::Disk>;
+          _intersect_packet = &Surface::intersect_packet_<C, shape::Disk>;
+        }
+      else if (t == typeid(shape::Ring))
+        {
+          _intersect = &Surface::intersect_<C, shape::Ring>;
+          _intersect_packet = &Surface::intersect_packet_<C, shape::Ring>;
+        }
+      else if (t == typeid(shape::Rectangle))
+        {
+          _intersect = &Surface::intersect_<C, shape::Rectangle>;
+          _intersect_packet = &Surface::intersect_packet_<C, shape::Rectangle>;
+        }
+      else
+        {
+          _intersect = &Surface::intersect_<C, shape::Base>;
+          _intersect_packet = &Surface::intersect_packet_<C, shape::Base>;
+        }
+    }
+
+    void Surface::update_kernels()
+    {
+      const std::type_info &t = typeid(*_curve);
+
+      if (t == typeid(curve::Sphere))
+        select_kernels<curve::Sphere>();
+      else if (t == typeid(curve::Conic))
+        select_kernels<curve::Conic>();
+      else if (t == typeid(curve::Parabola))
+        select_kernels<curve::Parabola>();
+      else if (t == typeid(curve::Flat))
+        select_kernels<curve::Flat>();
+      else
+        select_kernels<curve::Base>();
+    }
+
+    void Surface::trace_packet_simple(trace::Result &result, trace::RayPacket &packet) const
+    {
+      for (unsigned int i = 0; i < packet.get_count(); i++)
+        if (packet._hit[i])
+          trace_ray_simple(result, packet.get_ray(i), packet.get_local(i), packet.get_intersect(i));
+    }
+
+    void Surface::trace_packet_intensity(trace::Result &result, trace::RayPacket &packet) const
+    {
+      for (unsigned int i = 0; i < packet.get_count(); i++)
+        if (packet._hit[i])
+          trace_ray_intensity(result, packet.get_ray(i), packet.get_local(i), packet.get_intersect(i));
+    }
+
+    template <trace::IntensityMode m>
+    void Surface::trace_packet(trace::Result &result, trace::RayPacket &packet) const
+    {
+      for (unsigned int i = 0; i < packet.get_count(); i++)
+        {
+          if (!packet._hit[i])
+            continue;
+
+          trace::Ray &incident = packet.get_ray(i);
+          double len = 0;
+
+          for (unsigned int j = 0; j < 3; j++)
+            len += math::square(packet._point[j][i] - packet._origin[j][i]);
+          len = sqrt(len);
+
+          incident.set_len(len);
+          incident.set_intercept(*this, math::Vector3(packet._point[0][i],
+                                                      packet._point[1][i],
+                                                      packet._point[2][i]));
+
+          if (m == trace::Simpletrace)
+            {
+              incident.set_intercept_intensity(1.0);
+            }
+          else
+            {
+              // apply absorbtion from current material
+              double i_intensity = packet._intensity[i] *
+                incident.get_material()->get_internal_transmittance(packet._wavelen[i], len);
+
+              incident.set_intercept_intensity(i_intensity);
+              packet._intensity[i] = i_intensity;
+
+              if (i_intensity < _discard_intensity)
+                packet._hit[i] = false;
+            }
+        }
+
+      switch (m)
+        {
+        case trace::Simpletrace:
+          return trace_packet_simple(result, packet);
+
+        case trace::Intensitytrace:
+          return trace_packet_intensity(result, packet);
+
+        case trace::Polarizedtrace:
+          for (unsigned int i = 0; i < packet.get_count(); i++)
+            if (packet._hit[i])
+              trace_ray_polarized(result, packet.get_ray(i), packet.get_local(i), packet.get_intersect(i));
+          return;
+        }
+    }
+
+    template void Surface::trace_packet<trace::Simpletrace>(trace::Result &result,
+                                                            trace::RayPacket &packet) const;
+    template void Surface::trace_packet<trace::Intensitytrace>(trace::Result &result,
+                                                               trace::RayPacket &packet) const;
+    template void Surface::trace_packet<trace::Polarizedtrace>(trace::Result &result,
+                                                               trace::RayPacket &packet) const;
+
     template <trace::IntensityMode m>
     void Surface::trace_ray(trace::Result &result, trace::Ray &incident,
                             const math::VectorPair3 &local, const math::VectorPair3 &pt) const
@@ -154,22 +514,108 @@ namespace _goptical {
     inline void Surface::process_rays_(trace::Result &result,
                                        trace::rays_queue_t *input) const
     {
-      const trace::Params &params = result.get_params();
+      trace::RayPacket packet;
+      const Element *creator = 0;
 
+      // rays sharing the same creator are processed in packets
       for(auto& i : *input)
         {
-          math::VectorPair3 pt;
-          trace::Ray  &ray = *i;
+          if (packet.is_full() || (packet.get_count() && i->get_creator() != creator))
+            {
+              process_packet<m>(result, packet);
+              packet.clear();
+            }
+
+          creator = i->get_creator();
+          packet.add(*i);
+        }
+
+      if (packet.get_count())
+        process_packet<m>(result, packet);
+    }
+
+    double Surface::get_intersect_radius(const trace::Params &params) const
+    {
+      // intersections are not bounded by shape in unobstructed mode
+      if (params.get_unobstructed())
+        return std::numeric_limits<double>::infinity();
+
+      math::VectorPair3 b = get_intersect_bounding_box();
+      double r = 0;
+
+      for (unsigned int j = 0; j < 3; j++)
+        r += math::square(std::max(fabs(b[0][j]), fabs(b[1][j])));
+
+      // bounding box assumes a symmetric curve, keep some margin
+      return 2.0 * sqrt(r);
+    }
 
-          const math::Transform<3> &t = ray.get_creator()->get_transform_to(*this);
-          math::VectorPair3 local(t.transform_line(ray));
+    void Surface::check_packet_precision(trace::Result &result, trace::RayPacket &packet,
+                                         double radius) const
+    {
+      const float *const origin_f[3] =
+        { packet._origin_f[0], packet._origin_f[1], packet._origin_f[2] };
+      const float *const direction_f[3] =
+        { packet._direction_f[0], packet._direction_f[1], packet._direction_f[2] };
+      float *const point_f[3] =
+        { packet._point_f[0], packet._point_f[1], packet._point_f[2] };
+      bool hit_f[trace::RayPacket::size];
+      double error = 0;
+      unsigned int mismatch = 0;
+
+      packet.narrow_local(radius);
+      _curve->intersect_batch(packet.get_count(), origin_f, direction_f,
+                              point_f, hit_f);
+
+      // compare rays which hit the surface in double precision
+      for (unsigned int i = 0; i < packet.get_count(); i++)
+        {
+          if (!packet._hit[i])
+            continue;
 
-          if (intersect(params, pt, local))
+          if (!hit_f[i])
             {
-              result.add_intercepted(*this, ray);
-              trace_ray<m>(result, ray, local, pt);
+              mismatch++;
+              continue;
             }
+
+          for (unsigned int j = 0; j < 3; j++)
+            error = std::max(error, fabs(packet._point[j][i] - point_f[j][i]));
         }
+
+      result.update_precision_error(error, mismatch);
+    }
+
+    template <trace::IntensityMode m>
+    inline void Surface::process_packet(trace::Result &result,
+                                        trace::RayPacket &packet) const
+    {
+      const Element *creator = packet.get_ray(0).get_creator();
+
+      const math::Transform<3> &t = result.get_transform(*creator, *this);
+      const trace::Params &params = result.get_params();
+
+      trace::PrecisionMode precision = params.get_precision_mode();
+      double radius = precision == trace::DoublePrecision
+        ? 0 : get_intersect_radius(params);
+
+      packet.transform(t);
+
+      if (precision == trace::MixedPrecision)
+        packet.narrow_local(radius);
+
+      intersect_packet(params, packet);
+
+      // single precision kernels can only be checked against their
+      // double precision counterparts
+      if (precision == trace::CheckPrecision && has_packet_kernels())
+        check_packet_precision(result, packet, radius);
+
+      for (unsigned int i = 0; i < packet.get_count(); i++)
+        if (packet._hit[i])
+          result.add_intercepted(*this, packet.get_ray(i));
+
+      trace_packet<m>(result, packet);
     }
 
     void Surface::process_rays_simple(trace::Result &result,
@@ -210,6 +656,11 @@ namespace _goptical {
                                  math::Vector3(sb[1].x(), sb[1].y(), ms));
     }
 
+    math::VectorPair3 Surface::get_intersect_bounding_box() const
+    {
+      return get_bounding_box();
+    }
+
     void Surface::draw_3d_e(io::Renderer &r, const Element *ref) const
     {
       io::Rgb color = get_color(r);
@@ -36,6 +36,10 @@
 #include <goptical/core/trace/Ray>
 #include <goptical/core/material/Air>
 #include <goptical/core/material/Proxy>
+#include <goptical/core/curve/Base>
+#include <goptical/core/shape/Base>
+
+#include "sys_bvh_.hxx"
 
 namespace _goptical {
 
@@ -47,7 +51,15 @@ namespace _goptical {
         _tracer_params(),
         _e_count(0),
         _index_map(),
-        _transform_cache()
+        _transforms(),
+        _pair_transforms(),
+        _bvh(),
+        _bvh_version(0),
+        _bvh_data_version(0),
+        _bvh_lock(),
+        _frozen_version(0),
+        _frozen_data_version(0),
+        _freeze_lock()
     {
       transform_cache_resize(1);
       // index 0 is reserved for global coordinates transformations
@@ -88,9 +100,9 @@ namespace _goptical {
 
     const math::Transform<3> & system::transform_l2g_cache_update(const Element &element) const
     {
-      math::Transform<3> * & e = transform_cache_entry(element.id(), 0);
+      transform_entry_s &e = _transforms[element.id()];
 
-      if (!e)
+      if (!e._l2g_valid)
         {
           math::Transform<3> t(element._transform);
           const Element *i1 = &element;
@@ -102,93 +114,102 @@ namespace _goptical {
               i1 = i2;
             }
 
-          assert(!e);
-          e = new math::Transform<3>(t);
+          e._l2g = t;
+          e._l2g_valid = true;
         }
 
-      return *e;
+      return e._l2g;
     }
 
     const math::Transform<3> & system::transform_g2l_cache_update(const Element &element) const
     {
-      math::Transform<3> * & e = transform_cache_entry(0, element.id());
+      transform_entry_s &e = _transforms[element.id()];
 
-      if (!e)
-        e = new math::Transform<3>(transform_l2g_cache_update(element).inverse());
+      if (!e._g2l_valid)
+        {
+          e._g2l = transform_l2g_cache_update(element).inverse();
+          e._g2l_valid = true;
+        }
 
-      return *e;
+      return e._g2l;
     }
 
     const math::Transform<3> & system::transform_cache_update(const Element &from, const Element &to) const
     {
       assert(&from != &to);
 
-      math::Transform<3> * & e = transform_cache_entry(from.id(), to.id());
+      unsigned long long key = transform_pair_key(from.id(), to.id());
+      transform_pair_map_t::iterator i = _pair_transforms.find(key);
 
-      if (!e)
+      if (i == _pair_transforms.end())
         {
-          const math::Transform<3> &t1 = transform_l2g_cache_update(from);
-          const math::Transform<3> &t2 = transform_l2g_cache_update(to);
+          math::Transform<3> t(transform_l2g_cache_update(from));
+          t.compose(transform_l2g_cache_update(to).inverse());
+
+          // map nodes are stable, references stay valid on rehash
+          i = _pair_transforms.insert(transform_pair_map_t::value_type(key, t)).first;
+
+          std::vector<unsigned int> &fp = _transforms[from.id()]._pairs;
+          std::vector<unsigned int> &tp = _transforms[to.id()]._pairs;
 
-          if (!e)
+          if (std::find(fp.begin(), fp.end(), to.id()) == fp.end())
             {
-              e = new math::Transform<3>(t1);
-              e->compose(t2.inverse());
+              fp.push_back(to.id());
+              tp.push_back(from.id());
             }
         }
 
-      return *e;
+      return i->second;
+    }
+
+    void system::transform_cache_update() const
+    {
+      for (unsigned int id = 1; id < _e_count; id++)
+        if (const Element *e = _index_map[id])
+          transform_g2l_cache_update(*e);
     }
 
     void system::transform_cache_flush(const Element &element)
     {
-      for (unsigned int x = 0; x < _e_count; x++)
+      unsigned int id = element.id();
+      transform_entry_s &e = _transforms[id];
+
+      e._l2g_valid = e._g2l_valid = false;
+
+      for (unsigned int p : e._pairs)
         {
-          if (math::Transform<3> * & t = transform_cache_entry(element.id(), x))
-            {
-              delete t;
-              t = 0;
-            }
+          std::vector<unsigned int> &pp = _transforms[p]._pairs;
 
-          if (math::Transform<3> * & t = transform_cache_entry(x, element.id()))
-            {
-              delete t;
-              t = 0;
-            }
+          _pair_transforms.erase(transform_pair_key(id, p));
+          _pair_transforms.erase(transform_pair_key(p, id));
+          pp.erase(std::find(pp.begin(), pp.end(), id));
         }
+
+      e._pairs.clear();
     }
 
     void system::transform_cache_flush()
     {
-      for (unsigned int x = 0; x < _e_count; x++)
-        for (unsigned int y = 0; y < _e_count; y++)
-          if (math::Transform<3> * & t = transform_cache_entry(x, y))
-            {
-              delete t;
-              t = 0;
-            }
+      for (transform_entry_s &e : _transforms)
+        {
+          e._l2g_valid = e._g2l_valid = false;
+          e._pairs.clear();
+        }
+
+      _pair_transforms.clear();
     }
 
     void system::transform_cache_resize(unsigned int newsize)
     {
-      unsigned int oldsize = _e_count;
-
-      if (oldsize < newsize)
+      if (_e_count < newsize)
         {
+          // std::vector growth is geometric, existing entries are
+          // moved at most log(n) times while elements get added
           _index_map.resize(newsize, 0);
-          _transform_cache.resize(newsize * newsize, 0);
-
-          for (int y = oldsize - 1; y > 0; y--)
-            {
-              // move data
-              for (int x = oldsize - 1; x >= 0; x--)
-                {
-                  _transform_cache[y * newsize + x] =
-                    _transform_cache[y * oldsize + x];
 
-                  _transform_cache[y * oldsize + x] = 0;
-                }
-            }
+          transform_entry_s e;
+          e._l2g_valid = e._g2l_valid = false;
+          _transforms.resize(newsize, e);
 
           _e_count = newsize;
         }
@@ -196,7 +217,6 @@ namespace _goptical {
         {
           // FIXME handle cache downsize
         }
-
     }
 
     unsigned int system::index_get(Element &element)
@@ -213,7 +233,7 @@ namespace _goptical {
         }
       else
         {
-          index = _index_map.begin() - i;
+          index = i - _index_map.begin();
         }
 
       _index_map[index] = &element;
@@ -229,12 +249,22 @@ namespace _goptical {
 
     void system::transform_cache_dump(std::ostream &o) const
     {
-      o << "system transform cache size is " << _e_count << "x" << _e_count << std::endl;
+      o << "system transform cache size is " << _e_count << " elements, "
+        << _pair_transforms.size() << " pairs" << std::endl;
+
+      for (unsigned int id = 1; id < _e_count; id++)
+        {
+          const transform_entry_s &e = _transforms[id];
 
-      for (unsigned int from = 0; from < _e_count; from++)
-        for (unsigned int to = 0; to < _e_count; to++)
-          if (const math::Transform<3> *t = _transform_cache[from * _e_count + to])
-            o << "from " << from << " to " << to << ":" << std::endl << *t << std::endl;
+          if (e._l2g_valid)
+            o << "from " << id << " to 0:" << std::endl << e._l2g << std::endl;
+          if (e._g2l_valid)
+            o << "from 0 to " << id << ":" << std::endl << e._g2l << std::endl;
+        }
+
+      for (const transform_pair_map_t::value_type &p : _pair_transforms)
+        o << "from " << (unsigned int)(p.first >> 32) << " to " << (unsigned int)p.first
+          << ":" << std::endl << p.second << std::endl;
     }
 
     const Surface & system::get_entrance_pupil() const
@@ -255,44 +285,154 @@ namespace _goptical {
       return *res;
     }
 
-    /** FIXME write an optimized version of this function which uses
-        some kind of data structure (bsp tree?) */
+    void system::get_data_versions(const Element &e, unsigned int versions[4])
+    {
+      std::fill(versions, versions + 4, 0);
+
+      if (const Surface *s = dynamic_cast<const Surface *>(&e))
+        {
+          versions[0] = s->get_curve().get_version();
+          versions[1] = s->get_shape().get_version();
+        }
+
+      if (const OpticalSurface *s = dynamic_cast<const OpticalSurface *>(&e))
+        {
+          versions[2] = s->get_material(0).get_version();
+          versions[3] = s->get_material(1).get_version();
+        }
+    }
+
+    unsigned int system::get_data_version() const
+    {
+      // versions only increase, any in place change modifies the sum
+      unsigned int sum = _env_proxy.get_version();
+
+      for (unsigned int id = 1; id < _e_count; id++)
+        if (const Element *e = _index_map[id])
+          {
+            unsigned int v[4];
+
+            get_data_versions(*e, v);
+            sum += v[0] + v[1] + v[2] + v[3];
+          }
+
+      return sum;
+    }
+
+    void system::bvh_update() const
+    {
+      // _bvh_version is system version + 1, 0 when not built yet
+      unsigned int data_version = get_data_version();
+
+      if (_bvh_version.load(std::memory_order_acquire) == _version + 1 &&
+          _bvh_data_version.load(std::memory_order_relaxed) == data_version)
+        return;
+
+      std::lock_guard<std::mutex> lock(_bvh_lock);
+
+      if (_bvh_version.load(std::memory_order_relaxed) != _version + 1 ||
+          _bvh_data_version.load(std::memory_order_relaxed) != data_version)
+        {
+          _bvh.reset(new Bvh(*this));
+          _bvh_data_version.store(data_version, std::memory_order_relaxed);
+          _bvh_version.store(_version + 1, std::memory_order_release);
+        }
+    }
+
+    void system::freeze() const
+    {
+      if (is_frozen())
+        return;
+
+      std::lock_guard<std::mutex> lock(_freeze_lock);
+
+      unsigned int data_version = get_data_version();
+
+      if (_frozen_version.load(std::memory_order_relaxed) == _version + 1 &&
+          _frozen_data_version.load(std::memory_order_relaxed) == data_version)
+        return;
+
+      std::vector<const Element *> elements;
+      std::vector<const Source *> sources;
+
+      get_elements<Element>([&](const Element &e) { elements.push_back(&e); });
+      get_elements<Source>([&](const Source &s) { sources.push_back(&s); });
+
+      // tracers compose transforms between surfaces from per element
+      // transforms, only pairs used by sources to generate rays
+      // toward their targets are cached
+      transform_cache_update();
+
+      for (const Source *s : sources)
+        {
+          for (const Element *e : elements)
+            if (e != s)
+              {
+                transform_cache_update(*s, *e);
+                transform_cache_update(*e, *s);
+              }
+        }
+
+      bvh_update();
+
+      _env_proxy.freeze();
+
+      for (const Element *e : elements)
+        e->freeze();
+
+      _frozen_data_version.store(data_version, std::memory_order_relaxed);
+      _frozen_version.store(_version + 1, std::memory_order_release);
+    }
+
     Surface *system::colide_next(const trace::Params &params,
                                  math::VectorPair3 &intersect,
                                  const trace::Ray &ray) const
     {
       const Element *origin = ray.get_creator();
 
-      // test all elements and keep closest intersection
+      // test candidate surfaces and keep closest intersection
 
-      Surface *s, *e = 0;
+      Surface *e = 0;
       math::VectorPair3 inter;
       double    min_dist = std::numeric_limits<double>::max();
 
-      for (unsigned int i = 1; i <= get_element_count(); i++)
+      auto test = [&](Surface *s)
         {
-          Element *j = &get_element(i);
+          if (s == origin || !s->is_enabled())
+            return;
 
-          if (j == origin || !j->is_enabled())
-            continue;
+          const math::Transform<3> t(compose_transform(*origin, *s));
+          math::VectorPair3 local(t.transform_line(ray));
 
-          if ((s = dynamic_cast<Surface*>(j)))
+          if (s->intersect(params, inter, local))
             {
-              const math::Transform<3> &t = origin->get_transform_to(*s);
-              math::VectorPair3 local(t.transform_line(ray));
+              double    dist = (inter.origin() - local.origin()).len();
 
-              if (s->intersect(params, inter, local))
+              // lowest element id wins on equal distances, as
+              // when testing all elements in order
+              if (min_dist > dist ||
+                  (e && min_dist == dist && s->id() < e->id()))
                 {
-                  double        dist = (inter.origin() - local.origin()).len();
-
-                  if (min_dist > dist)
-                    {
-                      min_dist = dist;
-                      intersect = inter;
-                      e = s;
-                    }
+                  min_dist = dist;
+                  intersect = inter;
+                  e = s;
                 }
             }
+        };
+
+      // in place curves and shapes changes are handled by tracers
+      if (_bvh_version.load(std::memory_order_acquire) != _version + 1)
+        bvh_update();
+
+      if (params.get_unobstructed())
+        {
+          // curves may be hit outside of shapes bounding boxes
+          for (Surface *s : _bvh->get_surfaces())
+            test(s);
+        }
+      else
+        {
+          _bvh->find(origin->get_global_transform().transform_line(ray), test);
         }
 
       return e;
@@ -0,0 +1,89 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+#include <goptical/core/trace/AsyncTrace>
+
+namespace _goptical {
+
+  namespace trace {
+
+    AsyncTrace::state_s::state_s(unsigned int element_count,
+                                 const completion_t &completion)
+      : _processed(new std::atomic<size_t>[element_count]),
+        _element_count(element_count),
+        _cancel(false),
+        _lock(),
+        _cond(),
+        _done(false),
+        _canceled(false),
+        _error(),
+        _completion(completion)
+    {
+      for (unsigned int i = 0; i < element_count; i++)
+        _processed[i] = 0;
+    }
+
+    AsyncTrace::AsyncTrace()
+      : _state()
+    {
+    }
+
+    AsyncTrace::AsyncTrace(const std::shared_ptr<state_s> &state)
+      : _state(state)
+    {
+    }
+
+    bool AsyncTrace::is_done() const
+    {
+      std::lock_guard<std::mutex> lock(_state->_lock);
+
+      return _state->_done;
+    }
+
+    void AsyncTrace::wait() const
+    {
+      std::unique_lock<std::mutex> lock(_state->_lock);
+
+      while (!_state->_done)
+        _state->_cond.wait(lock);
+    }
+
+    void AsyncTrace::get() const
+    {
+      wait();
+
+      if (_state->_error)
+        std::rethrow_exception(_state->_error);
+    }
+
+    bool AsyncTrace::is_canceled() const
+    {
+      std::lock_guard<std::mutex> lock(_state->_lock);
+
+      return _state->_canceled;
+    }
+
+  }
+}
+
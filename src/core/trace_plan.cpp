@@ -0,0 +1,92 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#include <goptical/core/trace/Plan>
+#include <goptical/core/trace/Sequence>
+#include <goptical/core/sys/System>
+#include <goptical/core/sys/Source>
+#include <goptical/core/Error>
+
+namespace _goptical {
+
+  namespace trace {
+
+    Plan::Plan(const sys::system &system, const Sequence &sequence)
+      : _system(&system),
+        _version(system.get_version()),
+        _sequence(),
+        _entrance(0),
+        _steps()
+    {
+      const sys::Element *previous = 0;
+
+      for (auto &i : sequence._list)
+        {
+          const sys::Element *element = i.ptr();
+
+          _sequence.push_back(element);
+
+          if (element->get_system() != &system)
+            throw Error("Sequence contains element which is not part of the system");
+
+          const sys::Source *source = dynamic_cast<const sys::Source *>(element);
+
+          // first non source element, even if disabled
+          if (!source && !_entrance)
+            _entrance = element;
+
+          if (!element->is_enabled())
+            continue;
+
+          step_s s;
+
+          s._element = element;
+          s._source = source;
+          s._previous = previous;
+
+          if (previous && previous != element)
+            s._transform = system.compose_transform(*previous, *element);
+
+          _steps.push_back(s);
+          previous = element;
+        }
+    }
+
+    bool Plan::is_valid(const sys::system &system, const Sequence &sequence) const
+    {
+      if (&system != _system || system.get_version() != _version ||
+          sequence._list.size() != _sequence.size())
+        return false;
+
+      for (unsigned int i = 0; i < _sequence.size(); i++)
+        if (sequence._list[i].ptr() != _sequence[i])
+          return false;
+
+      return true;
+    }
+
+  }
+
+}
@@ -0,0 +1,194 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+#include <algorithm>
+#include <cassert>
+
+#include <goptical/core/trace/RayArena>
+
+namespace _goptical {
+
+  namespace trace {
+
+    const unsigned int RayArena::block_size;
+    const size_t RayArena::Positions::none;
+
+    RayArena::RayArena()
+      : _blocks(),
+        _spare(),
+        _size(0)
+    {
+    }
+
+    RayArena::~RayArena()
+    {
+      clear();
+      shrink();
+    }
+
+    void RayArena::add_block()
+    {
+      Ray *b;
+
+      if (_spare.empty())
+        {
+          b = static_cast<Ray *>(::operator new(sizeof(Ray) * block_size));
+        }
+      else
+        {
+          b = _spare.back();
+          _spare.pop_back();
+        }
+
+      block_s block = { b, 0 };
+      _blocks.push_back(block);
+    }
+
+    void RayArena::clear()
+    {
+      for (auto &b : _blocks)
+        {
+          for (unsigned int i = 0; i < b._count; i++)
+            b._rays[i].~Ray();
+
+          _spare.push_back(b._rays);
+        }
+
+      _blocks.clear();
+      _size = 0;
+    }
+
+    void RayArena::shrink()
+    {
+      for (Ray *b : _spare)
+        ::operator delete(b);
+
+      _spare.clear();
+    }
+
+    size_t RayArena::available() const
+    {
+      size_t count = _spare.size() * block_size;
+
+      if (!_blocks.empty())
+        count += block_size - _blocks.back()._count;
+
+      return count;
+    }
+
+    void RayArena::reserve(size_t count)
+    {
+      for (size_t free = available(); free < count; free += block_size)
+        _spare.push_back(static_cast<Ray *>(::operator new(sizeof(Ray) * block_size)));
+    }
+
+    void RayArena::move_spare(RayArena &other, size_t count)
+    {
+      while (!_spare.empty() && other.available() < count)
+        {
+          other._spare.push_back(_spare.back());
+          _spare.pop_back();
+        }
+    }
+
+    void RayArena::truncate(const mark_s &mark)
+    {
+      assert(mark._blocks <= _blocks.size());
+
+      while (_blocks.size() > mark._blocks)
+        {
+          block_s &b = _blocks.back();
+
+          for (unsigned int i = 0; i < b._count; i++)
+            b._rays[i].~Ray();
+
+          _spare.push_back(b._rays);
+          _blocks.pop_back();
+        }
+
+      if (!_blocks.empty())
+        {
+          block_s &b = _blocks.back();
+
+          for (unsigned int i = mark._count; i < b._count; i++)
+            b._rays[i].~Ray();
+
+          b._count = mark._count;
+        }
+
+      _size = mark._size;
+    }
+
+    void RayArena::splice(RayArena &other)
+    {
+      if (other._blocks.empty())
+        return;
+
+      // other blocks are appended after our last partially filled
+      // block, new rays will be allocated in the last spliced block
+      _blocks.insert(_blocks.end(), other._blocks.begin(), other._blocks.end());
+      _size += other._size;
+
+      other._blocks.clear();
+      other._size = 0;
+    }
+
+    RayArena::Positions::Positions(const RayArena &arena)
+      : _blocks()
+    {
+      size_t first = 0;
+
+      _blocks.reserve(arena._blocks.size());
+
+      for (auto &b : arena._blocks)
+        {
+          entry_s e = { b._rays, b._count, first };
+
+          _blocks.push_back(e);
+          first += b._count;
+        }
+
+      std::sort(_blocks.begin(), _blocks.end(),
+                [](const entry_s &a, const entry_s &b) { return a._rays < b._rays; });
+    }
+
+    size_t RayArena::Positions::find(const Ray *ray) const
+    {
+      // last block starting at or before the ray address
+      auto i = std::upper_bound(_blocks.begin(), _blocks.end(), ray,
+                                [](const Ray *r, const entry_s &e) { return r < e._rays; });
+
+      if (i == _blocks.begin())
+        return none;
+
+      --i;
+
+      if (ray >= i->_rays + i->_count)
+        return none;
+
+      return i->_first + (ray - i->_rays);
+    }
+
+  }
+}
@@ -0,0 +1,115 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#include <algorithm>
+#include <cmath>
+
+#include <goptical/core/trace/RayPacket>
+#include <goptical/core/trace/Ray>
+#include <goptical/core/math/Transform>
+
+namespace _goptical {
+
+  namespace trace {
+
+    void RayPacket::transform(const math::Transform<3> &t)
+    {
+      for (unsigned int i = 0; i < _count; i++)
+        {
+          const Ray &r = *_rays[i];
+
+          for (unsigned int j = 0; j < 3; j++)
+            {
+              _origin[j][i] = r.origin()[j];
+              _direction[j][i] = r.direction()[j];
+            }
+        }
+
+      const math::Vector3 &tr = t.get_translation();
+
+      if (!t.get_use_linear())
+        {
+          for (unsigned int j = 0; j < 3; j++)
+            for (unsigned int i = 0; i < _count; i++)
+              _origin[j][i] = _origin[j][i] + tr[j];
+
+          return;
+        }
+
+      const math::Matrix<3> &l = t.get_linear();
+
+      // same operations order as math::Transform::transform_line
+      for (unsigned int i = 0; i < _count; i++)
+        {
+          double o[3], d[3];
+
+          for (unsigned int j = 0; j < 3; j++)
+            {
+              o[j] = _origin[j][i];
+              d[j] = _direction[j][i];
+            }
+
+          for (unsigned int j = 0; j < 3; j++)
+            {
+              double so = 0, sd = 0;
+
+              for (unsigned int k = 0; k < 3; k++)
+                {
+                  so += l.value(j, k) * o[k];
+                  sd += l.value(j, k) * d[k];
+                }
+
+              _origin[j][i] = so + tr[j];
+              _direction[j][i] = sd;
+            }
+        }
+    }
+
+    void RayPacket::narrow_local(double radius)
+    {
+      for (unsigned int i = 0; i < _count; i++)
+        {
+          double dd = 0, od = 0;
+
+          for (unsigned int j = 0; j < 3; j++)
+            {
+              dd += _direction[j][i] * _direction[j][i];
+              od += _origin[j][i] * _direction[j][i];
+            }
+
+          // never move origin backward
+          double s = dd > 0 ? std::max(0.0, -od / dd - radius / sqrt(dd)) : 0;
+
+          for (unsigned int j = 0; j < 3; j++)
+            {
+              _origin_f[j][i] = _origin[j][i] + _direction[j][i] * s;
+              _direction_f[j][i] = _direction[j][i];
+            }
+        }
+    }
+
+  }
+
+}
@@ -23,11 +23,14 @@
 */
 
 
+#include <limits>
+
 #include <goptical/core/sys/System>
 #include <goptical/core/sys/Element>
 
 #include <goptical/core/trace/Ray>
 #include <goptical/core/trace/Result>
+#include <goptical/core/trace/Plan>
 
 #include <goptical/core/math/Vector>
 #include <goptical/core/math/VectorPair>
@@ -42,10 +45,29 @@ namespace _goptical {
       : _rays(),
         _elements(),
         _wavelengths(),
+        _wavelen_list(),
+        _wavelen_index(),
+        _spectral_table(),
+        _spectral(&_spectral_table),
         _generated_queue(0),
+        _generated_limit(std::numeric_limits<size_t>::max()),
+        _generated_flush(),
         _sources(),
         _bounce_limit_count(0),
-        _system(0)
+        _system(0),
+        _params(0),
+        _shards(),
+        _plan_step(0),
+        _streaming(false),
+        _retain_capacity(false),
+        _max_ray_count(0),
+        _version(0),
+        _precision_error(0),
+        _precision_mismatch(0),
+        _free_rays(),
+        _free_lists(),
+        _sink_result(this),
+        _sink_lock()
     {
     }
 
@@ -61,29 +83,57 @@ namespace _goptical {
           i._save_intercepted_list = false;
           i._save_generated_list = false;
         }
+
+      _version++;
     }
 
     void Result::clear()
     {
+      size_t count = _rays.size();
+
+      for (auto &s : _shards)
+        count += s->_rays.size();
+
+      if (_retain_capacity)
+        _max_ray_count = std::max(_max_ray_count, count);
+
       for (auto&i : _elements)
         {
-          if (i._intercepted)
-            {
-              i._intercepted = nullptr;
-            }
+          if (_retain_capacity && i._intercepted)
+            i._intercepted_max = std::max(i._intercepted_max, i._intercepted->size());
 
-          if (i._generated)
-            {
-              i._generated = nullptr;
-            }
+          if (_retain_capacity && i._generated)
+            i._generated_max = std::max(i._generated_max, i._generated->size());
+
+          release_list(i._intercepted);
+          release_list(i._generated);
         }
 
-      _rays.clear();// = vector_pool<Ray, 256>();
-      _rays.shrink();
+      _free_rays.clear();
+      _rays.clear();
+
+      if (!_retain_capacity)
+        _rays.shrink();
       _sources.clear();
       _wavelengths.clear();
+      _wavelen_list.clear();
+      _wavelen_index.clear();
+      _spectral_table.clear();
+
+      for (auto &s : _shards)
+        s->clear();
 
       _bounce_limit_count = 0;
+      _precision_error = 0;
+      _precision_mismatch = 0;
+
+      // previous trace may have been interrupted by an exception
+      _generated_queue = 0;
+      _generated_limit = std::numeric_limits<size_t>::max();
+      _generated_flush = nullptr;
+      _plan_step = 0;
+
+      _version++;
     }
 
     void Result::prepare()
@@ -92,14 +142,52 @@ namespace _goptical {
 
       for (auto&i : _elements)
         {
+          if (_streaming && (i._save_intercepted_list || i._save_generated_list))
+            throw Error("rays lists can not be saved in streaming mode");
+
           if (i._save_intercepted_list)
-            i._intercepted = std::make_shared<rays_queue_t>();
+            {
+              i._intercepted = new_list();
+              i._intercepted->reserve(i._intercepted_max);
+            }
 
           if (i._save_generated_list)
-            i._generated = std::make_shared<rays_queue_t>();
+            {
+              i._generated = new_list();
+              i._generated->reserve(i._generated_max);
+            }
+        }
+
+      if (_retain_capacity)
+        {
+          // spread storage between this result and worker shards
+          size_t share = _max_ray_count / (_shards.size() + 1);
+
+          _rays.reserve(_max_ray_count);
+
+          for (auto &s : _shards)
+            _rays.move_spare(s->_rays, share);
         }
     }
 
+    void Result::set_retain_capacity(bool retain)
+    {
+      _retain_capacity = retain;
+
+      if (retain)
+        return;
+
+      _max_ray_count = 0;
+      _free_lists.clear();
+      _rays.shrink();
+
+      for (auto &i : _elements)
+        i._intercepted_max = i._generated_max = 0;
+
+      for (auto &s : _shards)
+        s->set_retain_capacity(false);
+    }
+
     void Result::init(const sys::system &system)
     {
       static const struct element_result_s er = { 0 };
@@ -113,6 +201,185 @@ namespace _goptical {
       _elements.resize(system.get_element_count(), er);
     }
 
+    void Result::rewind(const RayArena::mark_s &mark, size_t source_count,
+                        const rays_queue_t &rays)
+    {
+      for (auto &r : rays)
+        r->reset_intercept();
+
+      _rays.truncate(mark);
+      _sources.resize(source_count);
+    }
+
+    void Result::update_spectral_table()
+    {
+      _spectral_table.update(*_system, _wavelen_list);
+    }
+
+    math::Transform<3> Result::get_transform(const sys::Element &from,
+                                             const sys::Element &to) const
+    {
+      if (_plan_step && _plan_step->_previous == &from && _plan_step->_element == &to)
+        return _plan_step->_transform;
+
+      return _system->compose_transform(from, to);
+    }
+
+    Result & Result::get_shard(unsigned int worker)
+    {
+      static const struct element_result_s er = { 0 };
+
+      if (_shards.size() <= worker)
+        _shards.resize(worker + 1);
+
+      std::unique_ptr<Result> &s = _shards[worker];
+
+      if (!s)
+        s.reset(new Result());
+
+      s->_system = _system;
+      s->_params = _params;
+      s->_streaming = _streaming;
+      s->_retain_capacity = _retain_capacity;
+      s->_sink_result = this;
+      s->_spectral = _spectral;
+      s->_elements.resize(_elements.size(), er);
+
+      return *s;
+    }
+
+    void Result::init_shard_lists(Result &shard) const
+    {
+      for (unsigned int i = 0; i < _elements.size(); i++)
+        {
+          const element_result_s &er = _elements[i];
+          element_result_s &ser = shard._elements[i];
+
+          if (er._intercepted)
+            ser._intercepted = shard.new_list();
+
+          if (er._generated)
+            ser._generated = shard.new_list();
+        }
+    }
+
+    void Result::merge_shard_lists(Result &shard)
+    {
+      for (unsigned int i = 0; i < _elements.size(); i++)
+        {
+          element_result_s &er = _elements[i];
+          element_result_s &ser = shard._elements[i];
+
+          if (ser._intercepted)
+            er._intercepted->append(ser._intercepted->begin(), ser._intercepted->end());
+
+          if (ser._generated)
+            er._generated->append(ser._generated->begin(), ser._generated->end());
+
+          shard.release_list(ser._intercepted);
+          shard.release_list(ser._generated);
+        }
+
+      _bounce_limit_count += shard._bounce_limit_count;
+      shard._bounce_limit_count = 0;
+    }
+
+    void Result::merge_shard_rays()
+    {
+      for (auto &s : _shards)
+        {
+          _rays.splice(s->_rays);
+
+          update_precision_error(s->_precision_error, s->_precision_mismatch);
+          s->_precision_error = 0;
+          s->_precision_mismatch = 0;
+        }
+    }
+
+    std::shared_ptr<rays_queue_t> Result::new_list()
+    {
+      if (_free_lists.empty())
+        return std::make_shared<rays_queue_t>();
+
+      std::shared_ptr<rays_queue_t> l = _free_lists.back();
+      _free_lists.pop_back();
+
+      return l;
+    }
+
+    void Result::release_list(std::shared_ptr<rays_queue_t> &list)
+    {
+      if (!list)
+        return;
+
+      // keep storage for next trace unless still referenced
+      if (list.use_count() == 1)
+        {
+          list->clear();
+          _free_lists.push_back(list);
+        }
+
+      list = nullptr;
+    }
+
+    void Result::balance_free_rays()
+    {
+      for (auto &s : _shards)
+        {
+          _free_rays.insert(_free_rays.end(), s->_free_rays.begin(), s->_free_rays.end());
+          s->_free_rays.clear();
+        }
+
+      size_t count = _free_rays.size() / (_shards.size() + 1);
+
+      for (auto &s : _shards)
+        {
+          s->_free_rays.assign(_free_rays.end() - count, _free_rays.end());
+          _free_rays.resize(_free_rays.size() - count);
+        }
+    }
+
+    void Result::recycle_ray(Ray &ray)
+    {
+      recycle_ray(ray, _free_rays);
+    }
+
+    void Result::recycle_ray(Ray &ray, std::vector<Ray *> &free_rays)
+    {
+      ray.unlink();
+
+      if (!ray.is_lost())
+        {
+          const element_result_s &er =
+            _sink_result->get_element_result(ray.get_intercept_element());
+
+          if (er._sink)
+            {
+              std::lock_guard<std::mutex> lock(_sink_result->_sink_lock);
+              er._sink(ray);
+            }
+        }
+
+      free_rays.push_back(&ray);
+    }
+
+    void Result::check_rays_retained() const
+    {
+      bool recycled = _streaming || !_free_rays.empty();
+
+      for (auto &s : _shards)
+        recycled |= !s->_free_rays.empty();
+
+      if (recycled)
+        throw Error("rays are not retained in streaming mode");
+    }
+
+    void Result::reuse_rays(std::vector<Ray *> &free_rays)
+    {
+      _free_rays.insert(_free_rays.end(), free_rays.begin(), free_rays.end());
+      free_rays.clear();
+    }
+
     void Result::init(const sys::Element &element)
     {
       const sys::system *system = element.get_system();
@@ -126,12 +393,31 @@ namespace _goptical {
     {
       init(e);
       get_element_result(e)._save_intercepted_list = enabled;
+      _version++;
     }
 
     void Result::set_generated_save_state(const sys::Element &e, bool enabled)
     {
       init(e);
       get_element_result(e)._save_generated_list = enabled;
+      _version++;
+    }
+
+    void Result::set_intercepted_sink(const sys::Surface &s, const sink_t &sink)
+    {
+      init(s);
+      get_element_result(s)._sink = sink;
+      _streaming = true;
+      _version++;
+    }
+
+    void Result::clear_sinks()
+    {
+      for (auto&i : _elements)
+        i._sink = nullptr;
+
+      _streaming = false;
+      _version++;
     }
 
     bool Result::get_intercepted_save_state(const sys::Element &e)
@@ -251,6 +537,8 @@ namespace _goptical {
     {
       double res = 0;
 
+      check_rays_retained();
+
       for (auto&r : _rays)
         {
           double i = r.get_intensity();
@@ -264,11 +552,13 @@ namespace _goptical {
 
     void Result::draw_2d(io::Renderer &r, bool hit_image, const sys::Element *ref) const
     {
+      check_rays_retained();
       r.draw_trace_result_2d(*this, hit_image, ref);
     }
 
     void Result::draw_3d(io::Renderer &r, bool hit_image, const sys::Element *ref) const
     {
+      check_rays_retained();
       r.draw_trace_result_3d(*this, hit_image, ref);
     }
 
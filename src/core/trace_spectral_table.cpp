@@ -0,0 +1,103 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#include <algorithm>
+
+#include <goptical/core/trace/SpectralTable>
+#include <goptical/core/trace/Ray>
+#include <goptical/core/sys/System>
+#include <goptical/core/sys/OpticalSurface>
+#include <goptical/core/material/Base>
+
+namespace _goptical {
+
+  namespace trace {
+
+    const unsigned int SpectralTable::no_offset;
+
+    SpectralTable::SpectralTable()
+      : _offsets(),
+        _interfaces(),
+        _wavelen_count(0)
+    {
+    }
+
+    void SpectralTable::clear()
+    {
+      _offsets.clear();
+      _interfaces.clear();
+      _wavelen_count = 0;
+    }
+
+    void SpectralTable::update(const sys::system &system, const std::vector<double> &wavelens)
+    {
+      unsigned int count = std::min<size_t>(wavelens.size(), Ray::no_wavelen_index);
+
+      // wavelens are only appended to the result list during a trace
+      if (count == _wavelen_count)
+        return;
+
+      _offsets.assign(system.get_element_count() + 1, no_offset);
+      _interfaces.clear();
+      _wavelen_count = count;
+
+      system.get_elements<sys::OpticalSurface>([&](const sys::OpticalSurface &s)
+        {
+          _offsets[s.id()] = _interfaces.size();
+
+          for (unsigned int rtl = 0; rtl < 2; rtl++)
+            {
+              const material::Base &prev = s.get_material(rtl);
+              const material::Base &next = s.get_material(!rtl);
+
+              for (unsigned int i = 0; i < count; i++)
+                {
+                  double wl = wavelens[i];
+                  interface_s it = { 0., 0., 0., false, false };
+
+                  // same operations as OpticalSurface::trace_ray_*
+                  try {
+                    it._index_ratio = prev.get_refractive_index(wl) / next.get_refractive_index(wl);
+                    it._index_valid = true;
+                  } catch (...) {
+                  }
+
+                  try {
+                    it._transmittance = next.get_normal_transmittance(&prev, wl);
+                    it._reflectance = next.get_normal_reflectance(&prev, wl);
+                    it._intensity_valid = true;
+                  } catch (...) {
+                  }
+
+                  _interfaces.push_back(it);
+                }
+            }
+        });
+    }
+
+  }
+
+}
+
@@ -0,0 +1,144 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#include <goptical/core/trace/thread_pool.hpp>
+
+namespace _goptical {
+
+  namespace trace {
+
+    ThreadPool::ThreadPool(unsigned int count)
+      : _threads(),
+        _task(0),
+        _task_count(0),
+        _next_task(0),
+        _busy(0),
+        _generation(0),
+        _quit(false),
+        _error()
+    {
+      for (unsigned int i = 1; i < count; i++)
+        _threads.push_back(std::thread(&ThreadPool::worker_main, this, i));
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+      {
+        std::lock_guard<std::mutex> lock(_lock);
+        _quit = true;
+      }
+
+      _start_cond.notify_all();
+
+      for (auto &t : _threads)
+        t.join();
+    }
+
+    void ThreadPool::run_tasks(unsigned int worker)
+    {
+      unsigned int t;
+
+      while ((t = _next_task++) < _task_count)
+        {
+          try
+            {
+              (*_task)(t, worker);
+            }
+          catch (...)
+            {
+              std::lock_guard<std::mutex> lock(_lock);
+
+              if (!_error)
+                _error = std::current_exception();
+            }
+        }
+    }
+
+    void ThreadPool::worker_main(unsigned int worker)
+    {
+      unsigned int generation = 0;
+
+      while (1)
+        {
+          {
+            std::unique_lock<std::mutex> lock(_lock);
+
+            while (!_quit && generation == _generation)
+              _start_cond.wait(lock);
+
+            if (_quit)
+              return;
+
+            generation = _generation;
+          }
+
+          run_tasks(worker);
+
+          {
+            std::lock_guard<std::mutex> lock(_lock);
+
+            if (!--_busy)
+              _done_cond.notify_one();
+          }
+        }
+    }
+
+    void ThreadPool::run(unsigned int count, const task_t &task)
+    {
+      {
+        std::lock_guard<std::mutex> lock(_lock);
+
+        _task = &task;
+        _task_count = count;
+        _next_task = 0;
+        _error = nullptr;
+        _busy = _threads.size();
+        _generation++;
+      }
+
+      _start_cond.notify_all();
+
+      run_tasks(0);
+
+      std::exception_ptr error;
+
+      {
+        std::unique_lock<std::mutex> lock(_lock);
+
+        while (_busy)
+          _done_cond.wait(lock);
+
+        _task = 0;
+        std::swap(error, _error);
+      }
+
+      if (error)
+        std::rethrow_exception(error);
+    }
+
+  }
+
+}
+
@@ -24,8 +24,15 @@
 
 
 #include <deque>
+#include <limits>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
 
 #include <goptical/core/trace/Tracer>
+#include <goptical/core/trace/thread_pool.hpp>
+#include <goptical/core/trace/bounded_queue.hpp>
 #include <goptical/core/trace/Result>
 #include <goptical/core/trace/Ray>
 #include <goptical/core/trace/Ray>
@@ -36,6 +43,7 @@
 #include <goptical/core/math/VectorPair>
 #include <goptical/core/trace/Distribution>
 #include <goptical/core/trace/Sequence>
+#include <goptical/core/trace/Plan>
 
 namespace _goptical {
 
@@ -45,12 +53,494 @@ namespace _goptical {
       : _system(system),
         _params(system->get_tracer_params()),
         _result(),
-        _result_ptr(&_result)
+        _result_ptr(&_result),
+        _pool(),
+        _plan(),
+        _retrace(),
+        _retrace_first(0),
+        _retrace_result(0),
+        _retrace_version(0),
+        _retrace_env(0),
+        _async(),
+        _async_thread()
     {
     }
 
     tracer::~tracer()
     {
+      async_release();
+    }
+
+    void tracer::async_release()
+    {
+      if (!_async_thread.joinable())
+        return;
+
+      // a thread can not join itself when called from the
+      // completion function, it leaves once the function returns
+      if (_async_thread.get_id() == std::this_thread::get_id())
+        _async_thread.detach();
+      else
+        _async_thread.join();
+    }
+
+    /** Thrown in the trace thread when cancellation of an
+        asynchronous trace has been requested */
+    struct trace_canceled_s
+    {
+    };
+
+    bool tracer::bounce_limit(size_t rank) const
+    {
+      return rank >= _params._max_bounce;
+    }
+
+    void tracer::async_check() const
+    {
+      if (_async && _async->_cancel.load(std::memory_order_relaxed))
+        throw trace_canceled_s();
+    }
+
+    void tracer::async_progress(const sys::Element &e, size_t count) const
+    {
+      if (_async)
+        _async->_processed[e.id()].fetch_add(count, std::memory_order_relaxed);
+    }
+
+    template <IntensityMode m>
+    void tracer::generate_rays(Result &result, const sys::Source &source,
+                               const std::vector<const sys::Element *> &targets)
+    {
+      if (!_async)
+        {
+          source.generate_rays<m>(result, targets);
+          return;
+        }
+
+      // check cancellation while rays are generated
+      rays_queue_t &generated = *result._generated_queue;
+      size_t reported = generated.size();
+
+      result._generated_limit = reported + _async_batch_size;
+      result._generated_flush = [&]()
+        {
+          async_check();
+          async_progress(source, generated.size() - reported);
+          reported = generated.size();
+          result._generated_limit = reported + _async_batch_size;
+        };
+
+      source.generate_rays<m>(result, targets);
+
+      result._generated_limit = std::numeric_limits<size_t>::max();
+      result._generated_flush = nullptr;
+      async_progress(source, generated.size() - reported);
+    }
+
+    template <IntensityMode m>
+    void tracer::process_rays(Result &result, const Plan::step_s &step,
+                              rays_queue_t *input)
+    {
+      const sys::Element &element = *step._element;
+
+      result._plan_step = &step;
+
+      if (!_async)
+        {
+          element.process_rays<m>(result, input);
+        }
+      else
+        {
+          // split input so that cancellation is checked between batches
+          rays_queue_t batch;
+
+          for (size_t first = 0; first < input->size(); first += _async_batch_size)
+            {
+              size_t last = std::min<size_t>(input->size(), first + _async_batch_size);
+
+              async_check();
+              batch.assign(input->begin() + first, input->begin() + last);
+              element.process_rays<m>(result, &batch);
+              async_progress(element, last - first);
+            }
+        }
+
+      result._plan_step = 0;
+    }
+
+    template <IntensityMode m>
+    void tracer::process_rays_parallel(const Plan::step_s &step,
+                                       rays_queue_t *input,
+                                       rays_queue_t *generated)
+    {
+      const sys::Element &element = *step._element;
+      Result &result = *_result_ptr;
+      unsigned int workers = _pool->get_worker_count();
+      unsigned int count = std::min<size_t>(workers * 4, input->size() / _parallel_batch_min);
+
+      if (count < 2)
+        {
+          process_rays<m>(result, step, input);
+          return;
+        }
+
+      // split input in contiguous batches, results are merged in
+      // batch order so that rays order does not depend on threads
+      struct batch_s
+      {
+        rays_queue_t                    _input;
+        rays_queue_t                    _generated;
+        std::shared_ptr<rays_queue_t>   _intercepted;
+      };
+
+      std::vector<batch_s> batches(count);
+      Result::element_result_s &er = result.get_element_result(element);
+      size_t first = 0;
+
+      for (unsigned int i = 0; i < count; i++)
+        {
+          size_t last = input->size() * (i + 1) / count;
+
+          batches[i]._input.assign(input->begin() + first, input->begin() + last);
+          if (er._intercepted)
+            batches[i]._intercepted = std::make_shared<rays_queue_t>();
+          first = last;
+        }
+
+      for (unsigned int w = 0; w < workers; w++)
+        result.get_shard(w);
+
+      if (result._streaming)
+        result.balance_free_rays();
+
+      _pool->run(count, [&](unsigned int i, unsigned int w)
+        {
+          Result &shard = *result._shards[w];
+          batch_s &b = batches[i];
+
+          async_check();
+
+          shard.get_element_result(element)._intercepted = b._intercepted;
+          shard._generated_queue = &b._generated;
+          shard._plan_step = &step;
+          element.process_rays<m>(shard, &b._input);
+          shard._plan_step = 0;
+          shard._generated_queue = 0;
+          shard.get_element_result(element)._intercepted = nullptr;
+
+          async_progress(element, b._input.size());
+        });
+
+      for (auto &b : batches)
+        {
+          generated->append(b._generated.begin(), b._generated.end());
+
+          if (er._intercepted)
+            er._intercepted->append(b._intercepted->begin(), b._intercepted->end());
+        }
+
+      result.merge_shard_rays();
+    }
+
+    /** Shared state of a pipelined sequential trace. Rays batches
+        are passed between consecutive stages through lock free
+        queues. Buffers are sent back to the producer once
+        processed, along with the processed rays for reuse, so that
+        the number of rays in flight is bounded by the queues
+        capacity. A stage blocks when its queue is full or empty. */
+    struct tracer::pipeline_s
+    {
+      /** Thrown to leave a stage when an other stage has failed */
+      struct abort_s
+      {
+      };
+
+      /** Rays batch passed between two stages */
+      struct batch_s
+      {
+        rays_queue_t            _rays;
+        std::vector<Ray *>      _free_rays; // rays recycled by consumer, reused by producer
+      };
+
+      /** Queues between two stages */
+      struct link_s
+      {
+        link_s(unsigned int size)
+          : _full(size + 1),
+            _free(size),
+            _buffers(size)
+        {
+          for (auto &b : _buffers)
+            _free.push(&b);
+        }
+
+        BoundedQueue<batch_s *> _full; // null at end of stream
+        BoundedQueue<batch_s *> _free;
+        std::vector<batch_s>    _buffers;
+      };
+
+      pipeline_s(unsigned int links, unsigned int size)
+        : _links(),
+          _waiting(0),
+          _abort(false),
+          _error()
+      {
+        for (unsigned int i = 0; i < links; i++)
+          _links.push_back(std::unique_ptr<link_s>(new link_s(size)));
+      }
+
+      void push(BoundedQueue<batch_s *> &q, batch_s *batch)
+      {
+        if (!q.push(batch))
+          wait([&]() { return q.push(batch); });
+
+        notify();
+      }
+
+      void pop(BoundedQueue<batch_s *> &q, batch_s *&batch)
+      {
+        if (!q.pop(batch))
+          wait([&]() { return q.pop(batch); });
+
+        notify();
+      }
+
+      /** Block until the queue operation succeeds */
+      template <typename F>
+      void wait(const F &retry)
+      {
+        std::unique_lock<std::mutex> lock(_lock);
+
+        // register before retrying so that the other side
+        // either sees the waiter or has already updated the queue
+        _waiting++;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        _cond.wait(lock, [&]() { return _abort || retry(); });
+        _waiting--;
+
+        if (_abort)
+          throw abort_s();
+      }
+
+      /** Wake up blocked stages after a queue update */
+      void notify()
+      {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (!_waiting.load(std::memory_order_relaxed))
+          return;
+
+        std::lock_guard<std::mutex> lock(_lock);
+        _cond.notify_all();
+      }
+
+      /** Record exception of a failed stage and stop other stages */
+      void fail()
+      {
+        std::lock_guard<std::mutex> lock(_lock);
+
+        if (!_error)
+          _error = std::current_exception();
+
+        _abort = true;
+        _cond.notify_all();
+      }
+
+      std::vector<std::unique_ptr<link_s> > _links;
+      std::atomic<unsigned int> _waiting;
+      std::atomic<bool>         _abort;
+      std::mutex                _lock;
+      std::condition_variable   _cond;
+      std::exception_ptr        _error;
+    };
+
+    size_t tracer::pipeline_start() const
+    {
+      const std::vector<Plan::step_s> &steps = _plan->get_steps();
+
+      if (!_pool || !_params._pipelined_trace)
+        return steps.size();
+
+      // rays of the last source are streamed, previous steps are
+      // traced at once
+      for (size_t i = steps.size(); i-- > 0; )
+        if (steps[i]._source)
+          return i + 1 < steps.size() ? i : steps.size();
+
+      return steps.size();
+    }
+
+    template <IntensityMode m>
+    void tracer::trace_pipeline(size_t source_step)
+    {
+      Result &result = *_result_ptr;
+      const std::vector<Plan::step_s> &steps = _plan->get_steps();
+      size_t count = steps.size() - source_step - 1;
+
+      // the source is the first stage, other elements are split in
+      // groups of consecutive steps
+      unsigned int stages = std::min<size_t>(_pool->get_worker_count() - 1, count);
+      pipeline_s p(stages, _pipeline_queue_size);
+      std::vector<Result *> shards(stages + 1);
+
+      shards[0] = &result;
+
+      for (unsigned int s = 1; s <= stages; s++)
+        {
+          shards[s] = &result.get_shard(s - 1);
+          result.init_shard_lists(*shards[s]);
+        }
+
+      _pool->run(stages + 1, [&](unsigned int s, unsigned int)
+        {
+          try
+            {
+              if (s == 0)
+                {
+                  const Plan::step_s &step = steps[source_step];
+                  const sys::Source *source = step._source;
+                  Result::element_result_s &er = result.get_element_result(*source);
+                  pipeline_s::link_s &out = *p._links[0];
+                  const sys::Element *entrance = _plan->get_entrance();
+                  sys::Source::targets_t elist;
+                  pipeline_s::batch_s *batch;
+                  bool first = true;
+
+                  auto send = [&]()
+                    {
+                      async_check();
+                      async_progress(*source, batch->_rays.size());
+
+                      if (er._generated)
+                        er._generated->append(batch->_rays.begin(), batch->_rays.end());
+
+                      // spectral table is read by other stages once
+                      // they have received rays
+                      if (first)
+                        result.update_spectral_table();
+                      first = false;
+
+                      p.push(out._full, batch);
+                    };
+
+                  if (entrance)
+                    elist.push_back(entrance);
+
+                  auto next = [&]()
+                    {
+                      p.pop(out._free, batch);
+                      result.reuse_rays(batch->_free_rays);
+                      batch->_rays.clear();
+                      result._generated_queue = &batch->_rays;
+                    };
+
+                  next();
+                  result._sources.push_back(source);
+                  result._generated_limit = _pipeline_batch_size;
+                  result._generated_flush = [&]()
+                    {
+                      send();
+                      next();
+                    };
+
+                  source->generate_rays<m>(result, elist);
+
+                  send();
+                  p.push(out._full, 0);
+                }
+              else
+                {
+                  Result &shard = *shards[s];
+                  pipeline_s::link_s &in = *p._links[s - 1];
+                  pipeline_s::link_s *out = s < stages ? p._links[s].get() : 0;
+                  size_t begin = source_step + 1 + count * (s - 1) / stages;
+                  size_t end = source_step + 1 + count * s / stages;
+                  rays_queue_t tmp[2];
+                  pipeline_s::batch_s *batch, *out_batch = 0;
+
+                  while (p.pop(in._full, batch), batch)
+                    {
+                      rays_queue_t *input = &batch->_rays;
+
+                      async_check();
+
+                      for (size_t i = begin; i < end; i++)
+                        {
+                          const Plan::step_s &step = steps[i];
+                          rays_queue_t *generated = &tmp[i & 1];
+
+                          if (out && i + 1 == end)
+                            {
+                              p.pop(out->_free, out_batch);
+                              shard.reuse_rays(out_batch->_free_rays);
+                              generated = &out_batch->_rays;
+                            }
+
+                          generated->clear();
+                          shard._generated_queue = generated;
+                          shard._plan_step = &step;
+                          step._element->process_rays<m>(shard, input);
+                          shard._plan_step = 0;
+                          shard._generated_queue = 0;
+                          async_progress(*step._element, input->size());
+
+                          Result::element_result_s &ser = shard.get_element_result(*step._element);
+
+                          if (ser._generated)
+                            ser._generated->append(generated->begin(), generated->end());
+
+                          if (input == &batch->_rays)
+                            {
+                              // parents of incoming rays have already been
+                              // recycled by the previous stage, rays are
+                              // given back to the previous stage for reuse
+                              if (shard._streaming)
+                                for (auto &r : *input)
+                                  shard.recycle_ray(*r, batch->_free_rays);
+
+                              input->clear();
+                              p.push(in._free, batch);
+                            }
+                          else if (shard._streaming)
+                            {
+                              for (auto &r : *input)
+                                shard.recycle_ray(*r);
+                            }
+
+                          input = generated;
+                        }
+
+                      if (out)
+                        p.push(out->_full, out_batch);
+                    }
+
+                  if (out)
+                    p.push(out->_full, 0);
+                }
+            }
+          catch (pipeline_s::abort_s &)
+            {
+            }
+          catch (...)
+            {
+              p.fail();
+            }
+        });
+
+      result._generated_queue = 0;
+      result._generated_limit = std::numeric_limits<size_t>::max();
+      result._generated_flush = nullptr;
+
+      if (p._error)
+        std::rethrow_exception(p._error);
+
+      // rays lists are merged in sequence order
+      for (unsigned int s = 1; s <= stages; s++)
+        result.merge_shard_lists(*shards[s]);
+
+      result.merge_shard_rays();
+      result.update_spectral_table();
     }
 
     template <IntensityMode m> void tracer::trace_seq_template()
@@ -59,63 +549,536 @@ namespace _goptical {
 
       result.init(*_system);
 
+      if (!_plan || !_plan->is_valid(*_system, *_params._sequence))
+        _plan.reset(new Plan(*_system, *_params._sequence));
+
       // stack of rays to propagate
       rays_queue_t tmp[2];
 
       unsigned int swaped = 0;
       rays_queue_t *generated;
       rays_queue_t *source_rays = &tmp[1];
-      const std::vector<const_ref<sys::Element> > &seq = _params._sequence->_list;
-      const sys::Element *entrance = 0;
+      const sys::Element *entrance = _plan->get_entrance();
+      const std::vector<Plan::step_s> &steps = _plan->get_steps();
+      size_t pipeline = pipeline_start();
+      bool save = _params._incremental_retrace && !result._streaming &&
+        pipeline == steps.size();
+      size_t first = _retrace_first;
 
-      // find entry element (first non source)
-      for (unsigned int i = 0; i < seq.size(); i++)
+      if (save)
+        _retrace.resize(steps.size());
+
+      if (first)
         {
-          if (!dynamic_cast<const sys::Source *>(seq[i].ptr()))
+          // rays generated by previous step are still in the result
+          source_rays = &_retrace[first - 1]._generated;
+
+          for (size_t i = first; i < steps.size(); i++)
             {
-              entrance = seq[i].ptr();
-              break;
-            }
-        }
+              Result::element_result_s &er = result.get_element_result(*steps[i]._element);
 
-      for (unsigned int i = 0; i < seq.size(); i++)
-        {
-          const sys::Element *element = seq[i].ptr();
+              if (er._intercepted)
+                er._intercepted->clear();
+              if (er._generated)
+                er._generated->clear();
+            }
 
-          if (_system != element->get_system())
-            throw Error("Sequence contains element which is not part of the system");
+          if (first < steps.size())
+            {
+              result.rewind(_retrace[first - 1]._mark, _retrace[first - 1]._sources, *source_rays);
 
-          if (!element->is_enabled())
-            continue;
+              // materials may have been modified in place
+              result._spectral_table.clear();
+              result.update_spectral_table();
+            }
+        }
 
+      for (size_t i = first; i < pipeline; i++)
+        {
+          const Plan::step_s &step = steps[i];
+          const sys::Element *element = step._element;
           Result::element_result_s &er = result.get_element_result(*element);
 
+          async_check();
+
           generated = er._generated ? er._generated.get() : &tmp[swaped];
           result._generated_queue = generated;
           generated->clear();
 
-          if (const sys::Source *source = dynamic_cast<const sys::Source *>(element))
+          if (const sys::Source *source = step._source)
             {
               result._sources.push_back(source);
               sys::Source::targets_t elist;
               if (entrance)
                 elist.push_back(entrance);
-              source->generate_rays<m>(result, elist);
+              generate_rays<m>(result, *source, elist);
+              result.update_spectral_table();
+            }
+          else if (_pool)
+            {
+              process_rays_parallel<m>(step, source_rays, generated);
             }
           else
             {
-              element->process_rays<m>(result, source_rays);
-              // swap ray buffers
+              process_rays<m>(result, step, source_rays);
             }
 
+          // incoming rays are not needed anymore in streaming mode
+          if (result._streaming && !step._source)
+            for (auto &r : *source_rays)
+              result.recycle_ray(*r);
+
           GOPTICAL_DEBUG(" " << generated->size() << " rays generated by " << *element);
+
+          if (save)
+            {
+              retrace_step_s &rs = _retrace[i];
+
+              rs._element = element;
+              rs._version = element->get_version();
+              sys::system::get_data_versions(*element, rs._data_versions);
+              rs._transform = step._transform;
+              rs._mark = result._rays.get_mark();
+              rs._sources = result._sources.size();
+              rs._generated.assign(generated->begin(), generated->end());
+            }
+
+          // swap ray buffers
           source_rays = generated;
           swaped ^= 1;
         }
 
-      
-
       result._generated_queue = 0;
+
+      if (pipeline < steps.size())
+        trace_pipeline<m>(pipeline);
+
+      if (save)
+        {
+          _retrace_result = &result;
+          _retrace_version = result._version;
+          _retrace_env = &_system->get_environment();
+        }
+    }
+
+    static bool same_transform(const math::Transform<3> &a, const math::Transform<3> &b)
+    {
+      if (!(a.get_translation() == b.get_translation()) ||
+          a.get_use_linear() != b.get_use_linear())
+        return false;
+
+      for (int x = 0; x < 3; x++)
+        for (int y = 0; y < 3; y++)
+          if (a.get_linear().value(x, y) != b.get_linear().value(x, y))
+            return false;
+
+      return true;
+    }
+
+    size_t tracer::retrace_start()
+    {
+      const Result &result = *_result_ptr;
+
+      if (!_params._sequential_mode || !_params._incremental_retrace ||
+          _retrace_result != &result || result._version != _retrace_version ||
+          &_system->get_environment() != _retrace_env)
+        return 0;
+
+      if (!_plan || !_plan->is_valid(*_system, *_params._sequence))
+        _plan.reset(new Plan(*_system, *_params._sequence));
+
+      const std::vector<Plan::step_s> &steps = _plan->get_steps();
+      size_t first;
+      unsigned int versions[4];
+
+      if (steps.size() != _retrace.size())
+        return 0;
+
+      // find first step which differs from previous trace
+      for (first = 0; first < steps.size(); first++)
+        {
+          const Plan::step_s &step = steps[first];
+          const retrace_step_s &rs = _retrace[first];
+
+          if (rs._element != step._element ||
+              rs._version != step._element->get_version() ||
+              (step._previous && !same_transform(rs._transform, step._transform)))
+            break;
+
+          sys::system::get_data_versions(*step._element, versions);
+
+          if (!std::equal(versions, versions + 4, rs._data_versions))
+            break;
+        }
+
+      for (size_t i = 0; i < steps.size(); i++)
+        {
+          const sys::Element *e = steps[i]._element;
+
+          // sources rays depend on entrance element
+          if (e == _plan->get_entrance() && i >= first)
+            return 0;
+
+          // rays lists of an element traced twice can not be split
+          for (size_t j = first; i < first && j < steps.size(); j++)
+            if (steps[j]._element == e)
+              return 0;
+        }
+
+      return first;
+    }
+
+    template <IntensityMode m>
+    void tracer::trace_ray(Result &result, Ray &ray) const
+    {
+      math::VectorPair3 intersect; // intersection point and normal (intersect surface local)
+
+      // find ray / surface interction
+      if (sys::Surface *s = _system->colide_next(_params, intersect, ray))
+        {
+          result.add_intercepted(*s, ray);
+          async_progress(*s, 1);
+
+          // transform incident ray to surface local
+          const math::Transform<3> t(_system->compose_transform(*ray.get_creator(), *s));
+          math::VectorPair3 local(t.transform_line(ray));
+
+          s->trace_ray<m>(result, ray, local, intersect);
+        }
+    }
+
+    /** Level of a source ray tree which contains more than one
+        ray. Children of the level rays are gathered until all rays
+        of the level have been traced, they are then sorted in
+        breadth first order so that rays ranks in the tree are the
+        same as in a single threaded trace. */
+    struct tracer::tree_level_s
+    {
+      tree_level_s(size_t rank, size_t size)
+        : _rank(rank),
+          _pending(size),
+          _size(size)
+      {
+      }
+
+      std::mutex                _lock;
+      size_t                    _rank; // rank of level first ray in tree
+      size_t                    _pending; // rays of level not traced yet
+      size_t                    _size;
+      std::vector<std::pair<size_t, Ray *> > _children; // along with parent position in level
+    };
+
+    /** Pending rays of a non sequential worker thread. Rays are
+        stored along with their rank in breadth first order of the
+        source ray tree they belong to. The owner thread works at
+        the back of the queue whereas other threads steal rays from
+        the front. */
+    struct tracer::steal_queue_s
+    {
+      struct item_s
+      {
+        item_s()
+          : _ray(0),
+            _rank(0),
+            _level()
+        {
+        }
+
+        item_s(Ray *ray, size_t rank, const std::shared_ptr<tree_level_s> &level)
+          : _ray(ray),
+            _rank(rank),
+            _level(level)
+        {
+        }
+
+        Ray                             *_ray;
+        size_t                          _rank;
+        std::shared_ptr<tree_level_s>   _level; // null if ray is alone in its level
+      };
+
+      void push(const std::vector<item_s> &items)
+      {
+        std::lock_guard<std::mutex> lock(_lock);
+
+        _rays.insert(_rays.end(), items.begin(), items.end());
+      }
+
+      bool pop(item_s &item)
+      {
+        std::lock_guard<std::mutex> lock(_lock);
+
+        if (_rays.empty())
+          return false;
+
+        item = _rays.back();
+        _rays.pop_back();
+        return true;
+      }
+
+      bool steal(item_s &item)
+      {
+        std::lock_guard<std::mutex> lock(_lock);
+
+        if (_rays.empty())
+          return false;
+
+        item = _rays.front();
+        _rays.pop_front();
+        return true;
+      }
+
+      std::mutex                _lock;
+      std::deque<item_s>        _rays;
+    };
+
+    /** Shared state of a parallel non sequential trace. Idle
+        workers block until rays are pushed by an other worker, all
+        pending rays have been traced or the trace is aborted. */
+    struct tracer::nonseq_s
+    {
+      nonseq_s(size_t pending)
+        : _pending(pending),
+          _waiting(0),
+          _pushed(0),
+          _abort(false),
+          _error()
+      {
+      }
+
+      /** Wake up idle workers after rays have been pushed */
+      void pushed()
+      {
+        // idle workers register before looking for rays to steal
+        if (!_waiting.load())
+          return;
+
+        std::lock_guard<std::mutex> lock(_lock);
+        _pushed++;
+        _cond.notify_all();
+      }
+
+      /** Account for a traced ray */
+      void done()
+      {
+        if (--_pending)
+          return;
+
+        std::lock_guard<std::mutex> lock(_lock);
+        _cond.notify_all();
+      }
+
+      /** Record exception of a failed worker and stop other workers */
+      void fail()
+      {
+        std::lock_guard<std::mutex> lock(_lock);
+
+        if (!_error)
+          _error = std::current_exception();
+
+        _abort = true;
+        _cond.notify_all();
+      }
+
+      /** Stop all workers, pending rays are dropped */
+      void abort()
+      {
+        std::lock_guard<std::mutex> lock(_lock);
+
+        _abort = true;
+        _cond.notify_all();
+      }
+
+      std::atomic<size_t>       _pending;
+      std::atomic<unsigned int> _waiting;
+      unsigned int              _pushed;
+      std::atomic<bool>         _abort;
+      std::mutex                _lock;
+      std::condition_variable   _cond;
+      std::exception_ptr        _error;
+    };
+
+    template <IntensityMode m>
+    void tracer::trace_parallel(const rays_queue_t &source_rays)
+    {
+      Result &result = *_result_ptr;
+      unsigned int workers = _pool->get_worker_count();
+      size_t count = source_rays.size();
+      std::vector<steal_queue_s> queues(workers);
+      std::atomic<size_t> next_source(0);
+      nonseq_s p(count);
+
+      for (unsigned int w = 0; w < workers; w++)
+        result.init_shard_lists(result.get_shard(w));
+
+      if (result._streaming)
+        result.balance_free_rays();
+
+      _pool->run(workers, [&](unsigned int, unsigned int w)
+        {
+          Result &shard = *result._shards[w];
+          steal_queue_s::item_s item;
+          rays_queue_t children;
+          std::vector<Ray *> level;
+          std::vector<steal_queue_s::item_s> next;
+          bool idle = false;
+          unsigned int pushed = 0;
+
+          shard._generated_queue = &children;
+
+          while (!p._abort.load(std::memory_order_relaxed))
+            {
+              // all workers leave on cancellation, pending rays are dropped
+              if (_async && _async->_cancel.load(std::memory_order_relaxed))
+                {
+                  p.abort();
+                  break;
+                }
+
+              if (queues[w].pop(item))
+                {
+                  shard.add_generated(*item._ray->get_creator(), *item._ray);
+                }
+              else
+                {
+                  size_t i = next_source++;
+
+                  if (i < count)
+                    {
+                      item._ray = source_rays[i];
+                      item._rank = 0;
+                      item._level = nullptr;
+                    }
+                  else
+                    {
+                      unsigned int j;
+
+                      if (!idle)
+                        {
+                          std::lock_guard<std::mutex> lock(p._lock);
+                          pushed = p._pushed;
+                          p._waiting++;
+                          idle = true;
+                        }
+
+                      for (j = 1; j < workers; j++)
+                        if (queues[(w + j) % workers].steal(item))
+                          break;
+
+                      if (j == workers)
+                        {
+                          std::unique_lock<std::mutex> lock(p._lock);
+
+                          p._cond.wait(lock, [&]() {
+                              return p._abort || !p._pending || p._pushed != pushed;
+                            });
+
+                          if (p._abort || !p._pending)
+                            break;
+
+                          pushed = p._pushed;
+                          continue;
+                        }
+
+                      shard.add_generated(*item._ray->get_creator(), *item._ray);
+                    }
+                }
+
+              if (idle)
+                {
+                  p._waiting--;
+                  idle = false;
+                }
+
+              try
+                {
+                  // check bounce limit
+                  if (bounce_limit(item._rank))
+                    shard._bounce_limit_count++;
+                  else
+                    trace_ray<m>(shard, *item._ray);
+                }
+              catch (...)
+                {
+                  p.fail();
+                  p.done();
+                  break;
+                }
+
+              if (shard._streaming)
+                shard.recycle_ray(*item._ray);
+
+              // get next tree level once all rays of the current
+              // level have been traced
+              size_t rank = 0;
+
+              level.clear();
+
+              if (!item._level)
+                {
+                  level.assign(children.begin(), children.end());
+                  rank = item._rank + 1;
+                }
+              else
+                {
+                  tree_level_s &l = *item._level;
+                  std::lock_guard<std::mutex> lock(l._lock);
+
+                  for (auto &r : children)
+                    l._children.push_back(std::make_pair(item._rank - l._rank, r));
+
+                  if (!--l._pending)
+                    {
+                      std::stable_sort(l._children.begin(), l._children.end(),
+                        [](const std::pair<size_t, Ray *> &a, const std::pair<size_t, Ray *> &b) {
+                          return a.first < b.first;
+                        });
+
+                      for (auto &c : l._children)
+                        level.push_back(c.second);
+
+                      rank = l._rank + l._size;
+                    }
+                }
+
+              children.clear();
+              item._level = nullptr;
+
+              // make reflected/refracted rays available to other threads
+              if (!level.empty())
+                {
+                  std::shared_ptr<tree_level_s> l;
+
+                  if (level.size() > 1)
+                    l = std::make_shared<tree_level_s>(rank, level.size());
+
+                  next.clear();
+
+                  for (size_t i = 0; i < level.size(); i++)
+                    next.push_back(steal_queue_s::item_s(level[i], rank + i, l));
+
+                  p._pending += next.size();
+                  queues[w].push(next);
+                  p.pushed();
+                }
+
+              p.done();
+            }
+
+          if (idle)
+            p._waiting--;
+
+          shard._generated_queue = 0;
+        });
+
+      if (p._error)
+        std::rethrow_exception(p._error);
+
+      async_check();
+
+      for (unsigned int w = 0; w < workers; w++)
+        result.merge_shard_lists(*result._shards[w]);
+
+      result.merge_shard_rays();
     }
 
     template <IntensityMode m> void tracer::trace_template()
@@ -153,7 +1116,8 @@ namespace _goptical {
           // get rays from source
           source_rays.clear();
           result._generated_queue = &source_rays;
-          source.generate_rays<m>(result, entry);
+          generate_rays<m>(result, source, entry);
+          result.update_spectral_table();
 
           // copy to source generated rays
           {
@@ -167,36 +1131,33 @@ namespace _goptical {
 
           // trace each ray generated by source through the system
 
+          if (_pool)
+            {
+              trace_parallel<m>(source_rays);
+              continue;
+            }
+
           rays_queue_t gqueue;
           result._generated_queue = &gqueue;
 
           for (auto&r : source_rays)
             {
               Ray *ray = r;
-              unsigned int bounce = _params._max_bounce;
+              size_t rank = 0;
+
+              async_check();
 
               // trace relfected/refracted ray further
               while (1)
                 {
                   // check bounce limit
-                  if (!bounce--)
+                  if (bounce_limit(rank++))
                     result._bounce_limit_count++;
                   else
-                    {
-                      math::VectorPair3 intersect; // intersection point and normal (intersect surface local)
+                    trace_ray<m>(result, *ray);
 
-                      // find ray / surface interction
-                      if (sys::Surface *s = _system->colide_next(_params, intersect, *ray))
-                        {
-                          result.add_intercepted(*s, *ray);
-
-                          // transform incident ray to surface local
-                          const math::Transform<3> &t = ray->get_creator()->get_transform_to(*s);
-                          math::VectorPair3 local(t.transform_line(*ray));
-
-                          s->trace_ray<m>(result, *ray, local, intersect);
-                        }
-                    }
+                  if (result._streaming)
+                    result.recycle_ray(*ray);
 
                   // pick next ray to trace further through the system
                   if (gqueue.empty())
@@ -217,11 +1178,34 @@ namespace _goptical {
     {
       Result    &result = *_result_ptr;
 
-      // clear previous results
-      result.prepare();
+      // clear previous results unless the sequential trace can
+      // restart from the first modified element
+      _retrace_first = retrace_start();
+      _retrace_result = 0;
+
+      if (!_retrace_first)
+        result.prepare();
 
       result._params = &_params;
 
+      unsigned int threads = _params._thread_count;
+
+      if (!threads)
+        threads = std::thread::hardware_concurrency();
+
+      if (threads < 2)
+        _pool = nullptr;
+      else if (!_pool || _pool->get_worker_count() != threads)
+        _pool.reset(new ThreadPool(threads));
+
+      // workers must only read system data
+      if (_pool)
+        _system->freeze();
+
+      // curves and shapes may have been modified in place
+      if (!_params._sequential_mode)
+        _system->bvh_update();
+
       switch (_params._intensity_mode)
         {
         case Simpletrace:
@@ -247,6 +1231,64 @@ namespace _goptical {
         }
     }
 
+    AsyncTrace tracer::trace_async(const AsyncTrace::completion_t &completion)
+    {
+      // previous asynchronous trace thread may still be calling
+      // its completion function
+      async_release();
+
+      std::shared_ptr<AsyncTrace::state_s> state =
+        std::make_shared<AsyncTrace::state_s>(_system->get_element_count() + 1, completion);
+
+      _async = state;
+
+      _async_thread = std::thread([this, state]()
+        {
+          bool canceled = false;
+          std::exception_ptr error;
+
+          try
+            {
+              trace();
+            }
+          catch (trace_canceled_s &)
+            {
+              canceled = true;
+            }
+          catch (...)
+            {
+              error = std::current_exception();
+            }
+
+          _async = nullptr;
+
+          {
+            std::lock_guard<std::mutex> lock(state->_lock);
+
+            state->_done = true;
+            state->_canceled = canceled;
+            state->_error = error;
+          }
+
+          state->_cond.notify_all();
+
+          // tracer may have been reused or destroyed by the
+          // completion function, it must not be accessed anymore
+          if (state->_completion)
+            {
+              try
+                {
+                  state->_completion(AsyncTrace(state));
+                }
+              catch (...)
+                {
+                }
+            }
+        });
+
+      return AsyncTrace(state);
+    }
+
   }
 
 }
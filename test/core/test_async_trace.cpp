@@ -0,0 +1,136 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#include "trace_fixture.hpp"
+
+#include <goptical/core/trace/AsyncTrace>
+#include <goptical/core/Error>
+
+#include <atomic>
+#include <thread>
+
+int main()
+{
+  lens_s lens;
+
+  trace::tracer ref_tracer(lens.sys);
+  lens.init_tracer(ref_tracer);
+  ref_tracer.trace();
+
+  const auto &ref_rays =
+    ref_tracer.get_trace_result().get_intercepted(lens.image);
+
+  if (ref_rays.empty())
+    fail(__LINE__);
+
+  // asynchronous trace
+  for (bool nonseq : { false, true })
+    for (unsigned int threads : { 1, 4 })
+      {
+        std::atomic<unsigned int> completed(0);
+
+        {
+          trace::tracer t(lens.sys);
+          lens.init_tracer(t, threads);
+
+          if (nonseq)
+            t.get_params().set_nonsequential_mode();
+
+          auto done = [&](const trace::AsyncTrace &h) {
+            if (!h.is_done())
+              fail(__LINE__);
+            completed++;
+          };
+
+          trace::AsyncTrace h = t.trace_async(done);
+          h.get();
+
+          if (h.is_canceled() || !h.get_processed_count(lens.source) ||
+              h.get_processed_count(lens.image) < ref_rays.size())
+            fail(__LINE__ << ": " << h.get_processed_count(lens.image));
+
+          if (nonseq)
+            {
+              if (t.get_trace_result().get_intercepted(lens.image).size() != ref_rays.size())
+                fail(__LINE__);
+            }
+          else
+            {
+              compare(ref_rays, t.get_trace_result().get_intercepted(lens.image));
+            }
+
+          // canceled trace leaves the tracer in a usable state
+          h = t.trace_async(done);
+          h.cancel();
+          h.wait();
+
+          if (!h.is_canceled())
+            h.get();
+
+          h = t.trace_async(done);
+          h.get();
+
+          if (h.is_canceled() ||
+              t.get_trace_result().get_intercepted(lens.image).size() != ref_rays.size())
+            fail(__LINE__);
+        }
+
+        if (completed != 3)
+          fail(__LINE__ << ": " << completed);
+      }
+
+  // completion function may start a new trace and may throw
+  {
+    trace::tracer t(lens.sys);
+    trace::AsyncTrace next;
+    std::atomic<bool> started(false);
+
+    lens.init_tracer(t, 4);
+
+    trace::AsyncTrace h = t.trace_async([&](const trace::AsyncTrace &) {
+        next = t.trace_async([](const trace::AsyncTrace &) {
+            throw Error("completion error");
+          });
+        started = true;
+      });
+
+    h.get();
+
+    while (!started)
+      std::this_thread::yield();
+
+    next.get();
+
+    if (next.is_canceled() ||
+        t.get_trace_result().get_intercepted(lens.image).size() != ref_rays.size())
+      fail(__LINE__);
+
+    // joins the thread which called the throwing completion function
+    h = t.trace_async();
+    h.get();
+  }
+
+  return 0;
+}
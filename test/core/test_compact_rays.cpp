@@ -0,0 +1,166 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#include "trace_fixture.hpp"
+
+#include <goptical/core/trace/CompactRays>
+
+#include <goptical/core/Error>
+
+#include <map>
+#include <tuple>
+
+// keys use compact record precision
+template <typename P>
+using ray_key_t = std::tuple<P, P, P, P, P, P>;
+
+template <typename P>
+static ray_key_t<P> ray_key(const trace::CompactRays<P> &c, unsigned int i)
+{
+  const typename trace::CompactRays<P>::ray_s &r = c.get_ray(i);
+
+  return ray_key_t<P>(r._origin[0], r._origin[1], r._origin[2],
+                  r._direction[0], r._direction[1], r._direction[2]);
+}
+
+template <typename P>
+static ray_key_t<P> ray_key(const trace::Ray &r)
+{
+  return ray_key_t<P>(r.origin()[0], r.origin()[1], r.origin()[2],
+                  r.direction()[0], r.direction()[1], r.direction()[2]);
+}
+
+// check compact rays links and identifiers against traced rays
+template <typename P>
+static void check(const trace::Result &result, const sys::Image &image, double tolerance)
+{
+  typedef trace::CompactRays<P> compact_t;
+  compact_t c(result);
+  std::map<ray_key_t<P>, unsigned int> index;
+
+  for (unsigned int i = 0; i < c.get_count(); i++)
+    index[ray_key(c, i)] = i;
+
+  const auto &hits = result.get_intercepted(image);
+
+  if (hits.empty() || index.size() != c.get_count())
+    fail(__LINE__);
+
+  for (const trace::Ray *r : hits)
+    {
+      auto k = index.find(ray_key<P>(*r));
+
+      if (k == index.end())
+        fail(__LINE__);
+
+      unsigned int i = k->second;
+      const typename compact_t::ray_s &cr = c.get_ray(i);
+
+      if (c.get_creator(i) != r->get_creator() ||
+          c.get_intercept_element(i) != &image ||
+          cr._element != image.id() ||
+          c.get_material(i) != r->get_material() ||
+          c.get_wavelen(i) != r->get_wavelen() ||
+          cr._wavelen != r->get_wavelen_index() ||
+          (c.get_intercept_point(i) - r->get_intercept_point()).len() > tolerance)
+        fail(__LINE__);
+
+      // walk up to the source ray
+      const trace::Ray *p = r;
+
+      while (p->get_parent())
+        {
+          const trace::Ray *pp = p->get_parent();
+          unsigned int pi = index[ray_key<P>(*pp)];
+
+          if (c.get_ray(i)._parent != pi)
+            fail(__LINE__);
+
+          // ray must be listed in parent children
+          uint32_t j = c.get_ray(pi)._child;
+
+          while (j != i && j != compact_t::none)
+            j = c.get_ray(j)._next;
+
+          if (j != i)
+            fail(__LINE__);
+
+          p = pp;
+          i = pi;
+        }
+
+      if (c.get_ray(i)._parent != compact_t::none ||
+          c.get_creator(i) != p->get_creator())
+        fail(__LINE__);
+    }
+}
+
+int main()
+{
+  lens_s lens;
+
+  // float records are less than half of trace::Ray size
+  if (sizeof(trace::CompactRays<float>::ray_s) * 2 > sizeof(trace::Ray))
+    fail(__LINE__ << ": " << sizeof(trace::CompactRays<float>::ray_s));
+
+  // rays are matched by origin and direction
+  lens.source.clear_spectrum();
+  lens.source.add_spectral_line(light::SpectralLine::e);
+
+  // several threads arenas are spliced in the result with
+  // partially filled blocks
+  for (unsigned int threads : { 1, 4 })
+    for (bool sequential : { true, false })
+      {
+        trace::tracer t(lens.sys);
+
+        if (sequential)
+          t.get_params().set_sequential_mode(lens.seq);
+        t.get_params().set_thread_count(threads);
+        t.get_params().set_default_distribution(
+          trace::Distribution(trace::HexaPolarDist, 50));
+        t.get_trace_result().set_intercepted_save_state(lens.image);
+        t.trace();
+
+        check<double>(t.get_trace_result(), lens.image, 0);
+        check<float>(t.get_trace_result(), lens.image, 1e-3);
+      }
+
+  // rays of a streaming mode result can not be copied
+  {
+    trace::tracer t(lens.sys);
+    t.get_trace_result().set_intercepted_sink(lens.image, [](const trace::Ray &) { });
+    t.trace();
+
+    try {
+      trace::CompactRays<> c(t.get_trace_result());
+      fail(__LINE__);
+    } catch (const Error &e) {
+    }
+  }
+
+  return 0;
+}
+
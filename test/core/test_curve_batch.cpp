@@ -0,0 +1,187 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#include <iostream>
+#include <vector>
+
+#include <goptical/core/math/Vector>
+#include <goptical/core/math/VectorPair>
+
+#include <goptical/core/curve/Base>
+#include <goptical/core/curve/Sphere>
+#include <goptical/core/curve/Conic>
+#include <goptical/core/curve/Parabola>
+#include <goptical/core/curve/Flat>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+using namespace goptical;
+
+#define fail(x)                                 \
+{                                               \
+  std::cerr << x << std::endl;                  \
+  exit(1);                                      \
+}
+
+// rays stored as separate x, y and z component arrays
+template <typename T>
+struct rays_s
+{
+  rays_s(unsigned int count)
+    : _data(count * 9), _hit(new bool[count])
+  {
+    for (unsigned int j = 0; j < 3; j++)
+      {
+        _origin[j] = &_data[count * j];
+        _direction[j] = &_data[count * (3 + j)];
+        _point[j] = &_data[count * (6 + j)];
+      }
+  }
+
+  ~rays_s()
+  {
+    delete[] _hit;
+  }
+
+  std::vector<T> _data;
+  T *_origin[3];
+  T *_direction[3];
+  T *_point[3];
+  bool *_hit;
+};
+
+// rays toward the curve, some of them miss curves with small radius
+static math::VectorPair3 get_ray(unsigned int i)
+{
+  double a = i * 2.39996;
+  double r = fmod(i * 7.31, 70.0);
+  math::Vector3 o(r * cos(a), r * sin(a), -20.0);
+  math::Vector3 d(fmod(i * .013, .2) - .1, fmod(i * .029, .2) - .1, 1.0);
+
+  return math::VectorPair3(o, d.normalized());
+}
+
+template <typename T>
+static void init_rays(rays_s<T> &rays, unsigned int count)
+{
+  for (unsigned int i = 0; i < count; i++)
+    {
+      math::VectorPair3 r(get_ray(i));
+
+      for (unsigned int j = 0; j < 3; j++)
+        {
+          rays._origin[j][i] = r.origin()[j];
+          rays._direction[j][i] = r.direction()[j];
+        }
+    }
+}
+
+static void check(const char *name, const curve::Base &c)
+{
+  static const unsigned int counts[] = { 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 33, 100 };
+
+  for (unsigned int count : counts)
+    {
+      // double precision kernels give the same results as scalar code
+      {
+        rays_s<double> batch(count), scalar(count);
+
+        init_rays(batch, count);
+        init_rays(scalar, count);
+
+        c.intersect_batch(count, batch._origin, batch._direction, batch._point, batch._hit);
+        c.curve::Base::intersect_batch(count, scalar._origin, scalar._direction,
+                                       scalar._point, scalar._hit);
+
+        for (unsigned int i = 0; i < count; i++)
+          {
+            if (batch._hit[i] != scalar._hit[i])
+              fail(name << " " << count << " " << i << ": hit mismatch");
+
+            if (!batch._hit[i])
+              continue;
+
+            for (unsigned int j = 0; j < 3; j++)
+              if (batch._point[j][i] != scalar._point[j][i])
+                fail(name << " " << count << " " << i << ": "
+                     << batch._point[j][i] << " " << scalar._point[j][i]);
+          }
+      }
+
+      // single precision kernels are close to double precision results
+      {
+        rays_s<float> batch(count);
+        rays_s<double> scalar(count);
+
+        init_rays(batch, count);
+        init_rays(scalar, count);
+
+        c.intersect_batch(count, batch._origin, batch._direction, batch._point, batch._hit);
+        c.curve::Base::intersect_batch(count, scalar._origin, scalar._direction,
+                                       scalar._point, scalar._hit);
+
+        for (unsigned int i = 0; i < count; i++)
+          {
+            if (batch._hit[i] != scalar._hit[i])
+              fail(name << " " << count << " " << i << ": float hit mismatch");
+
+            if (!batch._hit[i])
+              continue;
+
+            for (unsigned int j = 0; j < 3; j++)
+              if (fabs(batch._point[j][i] - scalar._point[j][i]) > 1e-3)
+                fail(name << " " << count << " " << i << ": "
+                     << batch._point[j][i] << " " << scalar._point[j][i]);
+          }
+      }
+    }
+}
+
+int main()
+{
+  check("sphere", curve::Sphere(50.));
+  check("sphere concave", curve::Sphere(-80.));
+  check("conic", curve::Conic(60., -.5));
+  check("hyperbola", curve::Conic(-60., -2.));
+  check("parabola", curve::Parabola(40.));
+  check("flat", curve::flat);
+
+  // rays count must cover misses
+  rays_s<double> rays(100);
+  init_rays(rays, 100);
+  curve::Sphere(50.).intersect_batch(100, rays._origin, rays._direction, rays._point, rays._hit);
+
+  unsigned int miss = 0;
+  for (unsigned int i = 0; i < 100; i++)
+    miss += !rays._hit[i];
+
+  if (!miss || miss == 100)
+    fail(__LINE__ << ": " << miss);
+
+  return 0;
+}
+
@@ -0,0 +1,127 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#include "trace_fixture.hpp"
+
+#include <goptical/core/curve/Sphere>
+
+#include <thread>
+
+// sphere which counts freeze calls
+class FreezeCountSphere : public curve::Sphere
+{
+public:
+  FreezeCountSphere(double roc)
+    : curve::Sphere(roc),
+      _count(0)
+  {
+  }
+
+  void freeze() const
+  {
+    _count++;
+  }
+
+  mutable unsigned int _count;
+};
+
+int main()
+{
+  lens_s lens;
+
+  trace::tracer ref_tracer(lens.sys);
+  lens.init_tracer(ref_tracer);
+  ref_tracer.trace();
+
+  const auto &ref_rays =
+    ref_tracer.get_trace_result().get_intercepted(lens.image);
+
+  if (ref_rays.empty())
+    fail(__LINE__);
+
+  // frozen system shared by tracers running in different threads
+  lens.sys.freeze();
+
+  if (!lens.sys.is_frozen())
+    fail(__LINE__);
+
+  trace::tracer t1(lens.sys), t2(lens.sys);
+
+  for (trace::tracer *t : { &t1, &t2 })
+    lens.init_tracer(*t, 1);
+
+  std::thread th([&]() { t1.trace(); });
+  t2.trace();
+  th.join();
+
+  compare(ref_rays, t1.get_trace_result().get_intercepted(lens.image));
+  compare(ref_rays, t2.get_trace_result().get_intercepted(lens.image));
+
+  // any modification unfreezes the system
+  lens.s1.set_discard_intensity(0.);
+
+  if (lens.sys.is_frozen())
+    fail(__LINE__);
+
+  t1.trace();
+  compare(ref_rays, t1.get_trace_result().get_intercepted(lens.image));
+
+  // curves and materials modified in place unfreeze the system
+  {
+    FreezeCountSphere sphere(-976.245);
+    lens_s l;
+
+    l.s2.set_curve(sphere);
+    l.sys.freeze();
+
+    if (!l.sys.is_frozen() || sphere._count != 1)
+      fail(__LINE__);
+
+    sphere.set_roc(-700);
+
+    if (l.sys.is_frozen())
+      fail(__LINE__);
+
+    l.sys.freeze();
+
+    if (!l.sys.is_frozen() || sphere._count != 2)
+      fail(__LINE__);
+
+    l.bk7.set_term(0, 1.2, 6.00069867e-3);
+
+    if (l.sys.is_frozen())
+      fail(__LINE__);
+
+    // tracer freezes the system again before multi-threaded tracing
+    trace::tracer t(l.sys);
+    l.init_tracer(t, 4);
+    t.trace();
+
+    if (!l.sys.is_frozen() || sphere._count != 3)
+      fail(__LINE__);
+  }
+
+  return 0;
+}
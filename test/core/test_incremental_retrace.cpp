@@ -0,0 +1,133 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#include "trace_fixture.hpp"
+
+#include <goptical/core/curve/Sphere>
+
+int main()
+{
+  lens_s lens;
+
+  trace::tracer ref_tracer(lens.sys);
+  lens.init_tracer(ref_tracer);
+  ref_tracer.trace();
+
+  const auto &ref_rays =
+    ref_tracer.get_trace_result().get_intercepted(lens.image);
+
+  if (ref_rays.empty())
+    fail(__LINE__);
+
+  // incremental retrace from the first modified element
+  for (unsigned int threads : { 1, 4 })
+    {
+      trace::tracer t(lens.sys), full(lens.sys);
+
+      for (trace::tracer *u : { &t, &full })
+        lens.init_tracer(*u, threads);
+
+      t.get_params().set_incremental_retrace(true);
+
+      for (int i = 0; i < 2; i++)
+        {
+          t.trace();
+          compare(ref_rays, t.get_trace_result().get_intercepted(lens.image));
+        }
+
+      // rays reaching the image are kept when only the image moves
+      const trace::Ray *r = t.get_trace_result().get_intercepted(lens.image)[0];
+
+      lens.image.set_local_position(math::Vector3(0, 0, 3000));
+      t.trace();
+      full.trace();
+      compare(full.get_trace_result().get_intercepted(lens.image),
+              t.get_trace_result().get_intercepted(lens.image));
+
+      if (t.get_trace_result().get_intercepted(lens.image)[0] != r)
+        fail(__LINE__);
+
+      lens.s2.set_local_position(math::Vector3(0, 0, 30));
+      t.trace();
+      full.trace();
+      compare(full.get_trace_result().get_intercepted(lens.image),
+              t.get_trace_result().get_intercepted(lens.image));
+
+      lens.image.set_local_position(math::Vector3(0, 0, 3014.5));
+      lens.s2.set_local_position(math::Vector3(0, 0, 31.336));
+      t.trace();
+      compare(ref_rays, t.get_trace_result().get_intercepted(lens.image));
+    }
+
+  // curves and materials modified in place are detected
+  {
+    lens_s l;
+    curve::Sphere sphere(-976.245);
+    trace::tracer t(l.sys), full(l.sys);
+
+    l.s2.set_curve(sphere);
+
+    for (trace::tracer *u : { &t, &full })
+      l.init_tracer(*u);
+
+    t.get_params().set_incremental_retrace(true);
+    t.trace();
+
+    sphere.set_roc(-700);
+    t.trace();
+    full.trace();
+    compare(full.get_trace_result().get_intercepted(l.image),
+            t.get_trace_result().get_intercepted(l.image));
+
+    // index cache of the material must not hide the change
+    material::Sellmeier fresh_bk7(1.2, 6.00069867e-3, 0.231792344,
+                                  2.00179144e-2, 1.01046945, 1.03560653e2);
+    double n = l.bk7.get_refractive_index(light::SpectralLine::e);
+
+    l.bk7.set_term(0, 1.2, 6.00069867e-3);
+
+    if (l.bk7.get_refractive_index(light::SpectralLine::e) == n ||
+        l.bk7.get_refractive_index(light::SpectralLine::e) !=
+        fresh_bk7.get_refractive_index(light::SpectralLine::e))
+      fail(__LINE__);
+
+    t.trace();
+
+    // reference is traced with freshly built lens and material
+    lens_s fresh;
+    curve::Sphere fresh_sphere(-700);
+    trace::tracer ref(fresh.sys);
+
+    fresh.s2.set_curve(fresh_sphere);
+    fresh.bk7.set_term(0, 1.2, 6.00069867e-3);
+    fresh.init_tracer(ref);
+    ref.trace();
+
+    compare(ref.get_trace_result().get_intercepted(fresh.image),
+            t.get_trace_result().get_intercepted(l.image));
+  }
+
+  return 0;
+}
@@ -0,0 +1,327 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#include "trace_fixture.hpp"
+
+#include <goptical/core/curve/Flat>
+#include <goptical/core/shape/Disk>
+
+#include <goptical/core/sys/Surface>
+#include <goptical/core/sys/Stop>
+
+#include <goptical/core/material/Vacuum>
+
+#include <goptical/core/Error>
+
+#include <atomic>
+#include <algorithm>
+
+// absorbing surface which throws for a single ray
+class FailingSurface : public sys::Surface
+{
+public:
+  FailingSurface(const math::Vector3 &pos, double radius)
+    : sys::Surface(math::VectorPair3(pos, math::vector3_001), curve::flat,
+                   ref<shape::Disk>::create(radius)),
+      _failed(false)
+  {
+  }
+
+  mutable std::atomic<bool> _failed;
+
+private:
+  void trace_ray_simple(trace::Result &result, trace::Ray &incident,
+                        const math::VectorPair3 &local, const math::VectorPair3 &intersect) const
+  {
+    if (!_failed.exchange(true))
+      throw Error("surface failure");
+  }
+};
+
+// transparent material which also reflects all rays
+class Splitter : public material::Vacuum
+{
+public:
+  Splitter(double index)
+    : _index(index)
+  {
+  }
+
+  bool is_reflecting() const
+  {
+    return true;
+  }
+
+  double get_refractive_index(double wavelen) const
+  {
+    return _index;
+  }
+
+private:
+  double _index;
+};
+
+int main()
+{
+  lens_s lens;
+
+  trace::tracer ref_tracer(lens.sys);
+  ref_tracer.get_params().set_default_distribution(
+    trace::Distribution(trace::HexaPolarDist, 30));
+  ref_tracer.get_trace_result().set_intercepted_save_state(lens.image);
+  ref_tracer.trace();
+
+  size_t ref_count = ref_tracer.get_trace_result().get_intercepted(lens.image).size();
+
+  if (!ref_count)
+    fail(__LINE__);
+
+  for (unsigned int threads : { 2, 4, 8 })
+    {
+      trace::tracer t(lens.sys);
+      t.get_params().set_thread_count(threads);
+      t.get_params().set_default_distribution(
+        trace::Distribution(trace::HexaPolarDist, 30));
+      t.get_trace_result().set_intercepted_save_state(lens.image);
+
+      // rays order is not preserved in non sequential mode
+      t.trace();
+
+      if (t.get_trace_result().get_intercepted(lens.image).size() != ref_count)
+        fail(__LINE__);
+    }
+
+  // stop blocks rays up to its external radius
+  {
+    sys::system sys2;
+    sys::SourcePoint source2(sys::SourceAtInfinity, math::vector3_001);
+    sys::OpticalSurface window(math::Vector3(0, 0, 0), 0, 50, material::none, material::none);
+    sys::Stop stop(math::VectorPair3(math::Vector3(0, 0, 10), math::vector3_001), 20);
+    sys::Image image2(math::Vector3(0, 0, 100), 100);
+
+    sys2.add(source2);
+    sys2.add(window);
+    sys2.add(stop);
+    sys2.add(image2);
+    sys2.set_entrance_pupil(window);
+
+    for (double external : { 40., 45. })
+      for (unsigned int threads : { 0, 4 })
+        {
+          stop.set_external_radius(external);
+
+          trace::tracer t(sys2);
+          t.get_params().set_thread_count(threads);
+          t.get_params().set_default_distribution(
+            trace::Distribution(trace::HexaPolarDist, 20));
+          t.get_trace_result().set_generated_save_state(source2);
+          t.get_trace_result().set_intercepted_save_state(image2);
+          t.trace();
+
+          size_t count = 0;
+
+          for (auto r : t.get_trace_result().get_generated(source2))
+            {
+              double d = r->origin().project_xy().len();
+
+              if (d < 20 || d > external)
+                count++;
+            }
+
+          const auto &hits = t.get_trace_result().get_intercepted(image2);
+
+          if (!count || hits.size() != count)
+            fail(__LINE__ << ": " << hits.size() << " " << count);
+        }
+  }
+
+  // shape modified in place after a first trace
+  {
+    sys::system sys3;
+    sys::SourcePoint source3(sys::SourceAtInfinity, math::vector3_001);
+    sys::OpticalSurface window(math::Vector3(0, 0, 0), 0, 50, material::none, material::none);
+    ref<shape::Disk> disk = ref<shape::Disk>::create(10);
+    sys::Image image3(math::VectorPair3(math::Vector3(0, 0, 100), math::vector3_001),
+                      curve::flat, disk);
+
+    sys3.add(source3);
+    sys3.add(window);
+    sys3.add(image3);
+    sys3.set_entrance_pupil(window);
+
+    for (unsigned int threads : { 1, 4 })
+      {
+        trace::tracer t(sys3);
+        t.get_params().set_thread_count(threads);
+        t.get_params().set_default_distribution(
+          trace::Distribution(trace::HexaPolarDist, 20));
+        t.get_trace_result().set_generated_save_state(source3);
+        t.get_trace_result().set_intercepted_save_state(image3);
+
+        for (double radius : { 10., 40., 10. })
+          {
+            disk->set_radius(radius);
+            t.trace();
+
+            size_t count = 0;
+
+            for (auto r : t.get_trace_result().get_generated(source3))
+              if (r->origin().project_xy().len() < radius)
+                count++;
+
+            const auto &hits = t.get_trace_result().get_intercepted(image3);
+
+            if (!count || hits.size() != count)
+              fail(__LINE__ << ": " << hits.size() << " " << count);
+          }
+      }
+  }
+
+  // rays cut by the bounce limit are the same as in single thread mode
+  {
+    sys::system sys3;
+    Splitter outer(1.0), inner(1.5);
+    sys::SourcePoint source3(sys::SourceAtInfinity, math::vector3_001);
+    sys::OpticalSurface front(math::Vector3(0, 0, 0), 0, 30, material::none, inner);
+    sys::OpticalSurface back(math::Vector3(0, 0, 10), 0, 30, inner, material::none);
+    sys::Image image3(math::Vector3(0, 0, 100), 100);
+
+    sys3.set_environment(outer);
+    sys3.add(source3);
+    sys3.add(front);
+    sys3.add(back);
+    sys3.add(image3);
+    sys3.set_entrance_pupil(front);
+
+    std::vector<std::pair<double, double> > ref_hits;
+
+    for (unsigned int threads : { 1, 2, 4, 8 })
+      for (int i = 0; i < 3; i++)
+        {
+          trace::tracer t(sys3);
+          t.get_params().set_thread_count(threads);
+          t.get_params().set_max_bounce(20);
+          t.get_params().set_default_distribution(
+            trace::Distribution(trace::HexaPolarDist, 10));
+          t.get_trace_result().set_intercepted_save_state(image3);
+          t.trace();
+
+          // rays of a tree hit the image at the same point
+          std::vector<std::pair<double, double> > hits;
+
+          for (auto r : t.get_trace_result().get_intercepted(image3))
+            hits.push_back(std::make_pair(r->get_intercept_point().x(),
+                                          r->get_intercept_point().y()));
+
+          std::sort(hits.begin(), hits.end());
+
+          if (threads == 1)
+            ref_hits = hits;
+          else if (hits != ref_hits)
+            fail(__LINE__ << ": " << hits.size() << " " << ref_hits.size());
+        }
+
+    if (ref_hits.empty())
+      fail(__LINE__);
+
+    // same bounce rule at the limit, only the max_bounce first
+    // rays of each tree are traced
+    for (unsigned int max_bounce : { 0, 1, 2, 3, 4, 7 })
+      {
+        unsigned int ref_limit = 0;
+        size_t ref_front = 0;
+
+        for (unsigned int threads : { 1, 4 })
+          {
+            trace::tracer t(sys3);
+            t.get_params().set_thread_count(threads);
+            t.get_params().set_max_bounce(max_bounce);
+            t.get_params().set_default_distribution(
+              trace::Distribution(trace::HexaPolarDist, 10));
+            t.get_trace_result().set_generated_save_state(source3);
+            t.get_trace_result().set_intercepted_save_state(front);
+            t.get_trace_result().set_intercepted_save_state(image3);
+            t.trace();
+
+            const trace::Result &r = t.get_trace_result();
+            size_t sources = r.get_generated(source3).size();
+            size_t front_hits = r.get_intercepted(front).size();
+
+            // source rays are dropped with max_bounce 0
+            if (max_bounce == 0 && (front_hits || r.get_bounce_limit_count() != sources))
+              fail(__LINE__ << ": " << front_hits << " " << r.get_bounce_limit_count());
+
+            // the source ray is the only one traced with max_bounce 1
+            if (max_bounce == 1 && front_hits != sources)
+              fail(__LINE__ << ": " << front_hits << " " << sources);
+
+            // image is reached after at least 3 bounces
+            if (max_bounce < 4 && !r.get_intercepted(image3).empty())
+              fail(__LINE__ << ": " << r.get_intercepted(image3).size());
+
+            if (threads == 1)
+              {
+                ref_limit = r.get_bounce_limit_count();
+                ref_front = front_hits;
+              }
+            else if (r.get_bounce_limit_count() != ref_limit || front_hits != ref_front)
+              fail(__LINE__ << ": " << max_bounce << " "
+                   << r.get_bounce_limit_count() << " " << ref_limit << " "
+                   << front_hits << " " << ref_front);
+          }
+      }
+  }
+
+  // error thrown by a surface stops all workers
+  lens.sys.remove(lens.image);
+
+  FailingSurface detector(math::Vector3(0, 0, 3014.5), 60);
+  lens.sys.add(detector);
+
+  for (unsigned int threads : { 2, 4, 8 })
+    {
+      trace::tracer t(lens.sys);
+      t.get_params().set_thread_count(threads);
+      t.get_params().set_default_distribution(
+        trace::Distribution(trace::HexaPolarDist, 30));
+
+      detector._failed = false;
+
+      try
+        {
+          t.trace();
+          fail(__LINE__);
+        }
+      catch (const Error &e)
+        {
+        }
+
+      // tracer is usable after a failed trace
+      t.trace();
+    }
+
+  return 0;
+}
+
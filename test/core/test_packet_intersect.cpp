@@ -0,0 +1,207 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#include <iostream>
+
+#include <goptical/core/math/Vector>
+#include <goptical/core/math/VectorPair>
+
+#include <goptical/core/material/Base>
+
+#include <goptical/core/sys/System>
+#include <goptical/core/sys/OpticalSurface>
+#include <goptical/core/sys/SourcePoint>
+#include <goptical/core/sys/Image>
+
+#include <goptical/core/trace/Tracer>
+#include <goptical/core/trace/Result>
+#include <goptical/core/trace/Ray>
+#include <goptical/core/trace/Distribution>
+#include <goptical/core/trace/Sequence>
+#include <goptical/core/trace/Params>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace goptical;
+
+#define fail(x)                                 \
+{                                               \
+  std::cerr << x << std::endl;                  \
+  exit(1);                                      \
+}
+
+// user surface class with a smaller round aperture than its shape
+class ApertureSurface : public sys::OpticalSurface
+{
+public:
+  ApertureSurface(const math::Vector3 &pos, double radius, double aperture)
+    : sys::OpticalSurface(pos, 0, radius, material::none, material::none),
+      _aperture(aperture)
+  {
+  }
+
+  bool intersect(const trace::Params &params, math::VectorPair3 &pt,
+                 const math::VectorPair3 &ray) const
+  {
+    return sys::OpticalSurface::intersect(params, pt, ray) &&
+      pt.origin().project_xy().len() < _aperture;
+  }
+
+  double _aperture;
+};
+
+// user surface class which only transmits rays with positive x
+class HalfSurface : public sys::OpticalSurface
+{
+public:
+  HalfSurface(const math::Vector3 &pos, double radius)
+    : sys::OpticalSurface(pos, 0, radius, material::none, material::none)
+  {
+  }
+
+private:
+  void trace_ray_simple(trace::Result &result, trace::Ray &incident,
+                        const math::VectorPair3 &local, const math::VectorPair3 &intersect) const
+  {
+    transmit(result, incident, local, intersect);
+  }
+
+  void trace_ray_intensity(trace::Result &result, trace::Ray &incident,
+                           const math::VectorPair3 &local, const math::VectorPair3 &intersect) const
+  {
+    transmit(result, incident, local, intersect);
+  }
+
+  void transmit(trace::Result &result, trace::Ray &incident,
+                const math::VectorPair3 &local, const math::VectorPair3 &intersect) const
+  {
+    if (intersect.origin().x() <= 0)
+      return;
+
+    trace::Ray &r = result.new_ray();
+
+    r.set_wavelen(incident.get_wavelen());
+    r.set_wavelen_index(incident.get_wavelen_index());
+    r.set_intensity(incident.get_intensity());
+    r.set_material(incident.get_material());
+    r.origin() = intersect.origin();
+    r.direction() = local.direction();
+    r.set_creator(this);
+    incident.add_generated(&r);
+  }
+};
+
+int main()
+{
+  sys::system sys;
+  sys::SourcePoint source(sys::SourceAtInfinity, math::vector3_001);
+  sys::OpticalSurface window(math::Vector3(0, 0, 0), 0, 50, material::none, material::none);
+  ApertureSurface aperture(math::Vector3(0, 0, 10), 50, 20);
+  sys::Image image(math::Vector3(0, 0, 100), 100);
+
+  sys.add(source);
+  sys.add(window);
+  sys.add(aperture);
+  sys.add(image);
+  sys.set_entrance_pupil(window);
+
+  trace::Sequence seq(sys);
+
+  // sequential packets must use reimplemented intersect function
+  for (trace::PrecisionMode precision : { trace::DoublePrecision, trace::MixedPrecision,
+                                          trace::CheckPrecision })
+    for (unsigned int threads : { 1, 4 })
+      {
+        trace::tracer t(sys);
+        t.get_params().set_sequential_mode(seq);
+        t.get_params().set_precision_mode(precision);
+        t.get_params().set_thread_count(threads);
+        t.get_params().set_default_distribution(
+          trace::Distribution(trace::HexaPolarDist, 20));
+        t.get_trace_result().set_generated_save_state(source);
+        t.get_trace_result().set_intercepted_save_state(aperture);
+        t.get_trace_result().set_intercepted_save_state(image);
+        t.trace();
+
+        const trace::Result &result = t.get_trace_result();
+        size_t count = 0;
+
+        for (auto r : result.get_generated(source))
+          if (r->origin().project_xy().len() < 20)
+            count++;
+
+        if (!count || result.get_intercepted(aperture).size() != count ||
+            result.get_intercepted(image).size() != count)
+          fail(__LINE__ << ": " << precision << " " << result.get_intercepted(image).size()
+               << " " << count);
+
+        for (auto r : result.get_intercepted(image))
+          if (r->get_intercept_point().project_xy().len() >= 20)
+            fail(__LINE__);
+      }
+
+  // sequential packets must use reimplemented ray trace functions
+  {
+    sys::system sys2;
+    sys::SourcePoint source2(sys::SourceAtInfinity, math::vector3_001);
+    HalfSurface half(math::Vector3(0, 0, 10), 50);
+    sys::Image image2(math::Vector3(0, 0, 100), 100);
+
+    sys2.add(source2);
+    sys2.add(half);
+    sys2.add(image2);
+
+    trace::Sequence seq2(sys2);
+
+    for (trace::IntensityMode mode : { trace::Simpletrace, trace::Intensitytrace })
+      for (unsigned int threads : { 1, 4 })
+        {
+          trace::tracer t(sys2);
+          t.get_params().set_sequential_mode(seq2);
+          t.get_params().set_intensity_mode(mode);
+          t.get_params().set_thread_count(threads);
+          t.get_params().set_default_distribution(
+            trace::Distribution(trace::HexaPolarDist, 20));
+          t.get_trace_result().set_generated_save_state(source2);
+          t.get_trace_result().set_intercepted_save_state(image2);
+          t.trace();
+
+          const trace::Result &result = t.get_trace_result();
+          size_t count = 0;
+
+          for (auto r : result.get_generated(source2))
+            if (r->origin().x() > 0)
+              count++;
+
+          if (!count || result.get_intercepted(image2).size() != count)
+            fail(__LINE__ << ": " << mode << " " << result.get_intercepted(image2).size()
+                 << " " << count);
+        }
+  }
+
+  return 0;
+}
+
@@ -0,0 +1,64 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#include "trace_fixture.hpp"
+
+int main()
+{
+  lens_s lens;
+
+  trace::tracer ref_tracer(lens.sys);
+  lens.init_tracer(ref_tracer);
+  ref_tracer.trace();
+
+  const auto &ref_rays =
+    ref_tracer.get_trace_result().get_intercepted(lens.image);
+
+  if (ref_rays.empty())
+    fail(__LINE__);
+
+  for (unsigned int threads = 0; threads < 9; threads++)
+    {
+      trace::tracer t(lens.sys);
+      lens.init_tracer(t, threads);
+
+      // trace twice to reuse thread pool and result shards
+      for (int i = 0; i < 2; i++)
+        {
+          t.trace();
+          compare(ref_rays, t.get_trace_result().get_intercepted(lens.image));
+        }
+
+      // rays order is not preserved in non sequential mode
+      t.get_params().set_nonsequential_mode();
+      t.trace();
+
+      if (t.get_trace_result().get_intercepted(lens.image).size() != ref_rays.size())
+        fail(__LINE__);
+    }
+
+  return 0;
+}
+
@@ -0,0 +1,191 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#include <iostream>
+
+#include <goptical/core/math/Vector>
+#include <goptical/core/math/VectorPair>
+
+#include <goptical/core/material/Base>
+
+#include <goptical/core/curve/Flat>
+#include <goptical/core/curve/Sphere>
+#include <goptical/core/curve/Conic>
+#include <goptical/core/curve/Composer>
+#include <goptical/core/shape/Disk>
+
+#include <goptical/core/sys/System>
+#include <goptical/core/sys/OpticalSurface>
+#include <goptical/core/sys/SourcePoint>
+#include <goptical/core/sys/Image>
+
+#include <goptical/core/trace/Tracer>
+#include <goptical/core/trace/Result>
+#include <goptical/core/trace/Ray>
+#include <goptical/core/trace/Distribution>
+#include <goptical/core/trace/Params>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace goptical;
+
+#define fail(x)                                 \
+{                                               \
+  std::cerr << x << std::endl;                  \
+  exit(1);                                      \
+}
+
+// pattern must span most of the given radius without exceeding it
+static bool check_radius(double m, double r)
+{
+  return m <= r + 1e-6 && m > r * .9;
+}
+
+static double max_radius(const std::vector<math::Vector3> &points)
+{
+  double r = 0;
+
+  for (auto &p : points)
+    r = std::max(r, p.project_xy().len());
+
+  return r;
+}
+
+int main()
+{
+  trace::Distribution d(trace::HexaPolarDist, 100);
+
+  // pattern points are cached on the surface
+  {
+    sys::OpticalSurface s1(math::Vector3(0, 0, 0), 2009.753, 100, material::none, material::none);
+    auto p = s1.get_pattern(d);
+
+    if (p->empty() || s1.get_pattern(d) != p)
+      fail(__LINE__);
+
+    trace::Distribution d1(d);
+    d1.set_seed(1);
+    if (s1.get_pattern(d1) == p)
+      fail(__LINE__);
+
+    s1.set_curve(ref<curve::Sphere>::create(2009.753));
+    if (s1.get_pattern(d) == p)
+      fail(__LINE__);
+  }
+
+  // shape modified in place after the pattern has been cached
+  {
+    ref<shape::Disk> disk = ref<shape::Disk>::create(50);
+    sys::OpticalSurface s1(math::VectorPair3(math::Vector3(0, 0, 0), math::vector3_001),
+                           curve::flat, disk, material::none, material::none);
+
+    auto p = s1.get_pattern(d);
+    if (!check_radius(max_radius(*p), 50))
+      fail(__LINE__ << ": " << max_radius(*p));
+
+    disk->set_radius(5);
+    p = s1.get_pattern(d);
+    if (!check_radius(max_radius(*p), 5))
+      fail(__LINE__ << ": " << max_radius(*p));
+
+    // same through a full trace, entrance pupil pattern must follow
+    sys::system sys;
+    sys::SourcePoint source(sys::SourceAtInfinity, math::vector3_001);
+    sys::Image image(math::Vector3(0, 0, 10), 60);
+
+    disk->set_radius(50);
+    sys.add(source);
+    sys.add(s1);
+    sys.add(image);
+    sys.set_entrance_pupil(s1);
+
+    trace::tracer t(sys);
+    t.get_params().set_default_distribution(d);
+    t.get_trace_result().set_intercepted_save_state(image);
+
+    double radius[] = { 50, 5, 20 };
+
+    for (double r : radius)
+      {
+        disk->set_radius(r);
+        t.trace();
+
+        double m = 0;
+        for (auto i : t.get_trace_result().get_intercepted(image))
+          m = std::max(m, i->get_intercept_point().project_xy().len());
+
+        if (!check_radius(m, r))
+          fail(__LINE__ << ": " << m << " " << r);
+      }
+  }
+
+  // curve modified in place after the pattern has been cached
+  {
+    ref<curve::Conic> conic = ref<curve::Conic>::create(200, 0);
+    sys::OpticalSurface s1(math::VectorPair3(math::Vector3(0, 0, 0), math::vector3_001),
+                           conic, ref<shape::Disk>::create(50), material::none, material::none);
+
+    auto p = s1.get_pattern(d);
+    conic->set_schwarzschild(-1);
+    auto q = s1.get_pattern(d);
+
+    if (p == q || p->size() != q->size())
+      fail(__LINE__);
+
+    for (auto &v : *q)
+      if (fabs(v.z() - conic->sagitta(v.project_xy().len())) > 1e-9)
+        fail(__LINE__ << ": " << v);
+  }
+
+  // composed curve follows changes of its base curves and attributes
+  {
+    ref<curve::Sphere> sphere = ref<curve::Sphere>::create(200);
+    ref<curve::Composer> comp = ref<curve::Composer>::create();
+    curve::Composer::Attributes &a = comp->add_curve(sphere);
+
+    sys::OpticalSurface s1(math::VectorPair3(math::Vector3(0, 0, 0), math::vector3_001),
+                           comp, ref<shape::Disk>::create(50), material::none, material::none);
+
+    auto p = s1.get_pattern(d);
+
+    a.z_offset(1);
+    auto q = s1.get_pattern(d);
+    if (p == q)
+      fail(__LINE__);
+
+    sphere->set_roc(300);
+    auto r = s1.get_pattern(d);
+    if (q == r)
+      fail(__LINE__);
+
+    for (auto &v : *r)
+      if (fabs(v.z() - comp->sagitta(v.project_xy())) > 1e-9)
+        fail(__LINE__ << ": " << v);
+  }
+
+  return 0;
+}
+
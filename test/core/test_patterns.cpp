@@ -102,7 +102,9 @@ int main()
     "square",
     "triangular",
     "hexpolar",
-    "random"
+    "random",
+    "sobol",
+    "halton"
   };
 
   for (int i = 0; st[i].name; i++)
@@ -113,13 +115,13 @@ int main()
       char fname[48];
       std::sprintf(fname, "test_pattern_%s.svg", s.name);
 
-      io::RendererSvg rsvg(fname, 800, 400, io::rgb_white);
+      io::RendererSvg rsvg(fname, 800, 600, io::rgb_white);
       io::RendererViewport &r = rsvg;
 
-      r.set_page_layout(4, 2);
+      r.set_page_layout(4, 3);
 #endif
 
-      for (int j = 0; j <= trace::RandomDist; j++)
+      for (int j = 0; j <= trace::HaltonDist; j++)
         {
 #ifndef SINGLE_IMAGE
           char fname[48];
@@ -156,7 +158,7 @@ int main()
               r.draw_point(*v, io::rgb_red, io::PointStyleCross);
 
               // Chief ray must be the first ray in list, some analysis do rely on this
-              if (!first && v->close_to(math::vector2_0, 1) && j != trace::RandomDist)
+              if (!first && v->close_to(math::vector2_0, 1) && j < trace::RandomDist)
                 {
                   std::cerr << "-- chief !first " << *v << "\n";
                   err++;
@@ -168,7 +170,7 @@ int main()
                   err++;
                 }
               
-              if (j != trace::RandomDist)
+              if (j < trace::RandomDist)
                 {
                   // check for duplicates
                   for (auto&w, pts)
@@ -0,0 +1,112 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#include "trace_fixture.hpp"
+
+int main()
+{
+  lens_s lens;
+
+  trace::tracer ref_tracer(lens.sys);
+  lens.init_tracer(ref_tracer);
+  ref_tracer.trace();
+
+  const auto &ref_rays =
+    ref_tracer.get_trace_result().get_intercepted(lens.image);
+
+  if (ref_rays.empty())
+    fail(__LINE__);
+
+  // pipelined sequential trace
+  for (unsigned int threads : { 2, 3, 4, 8 })
+    {
+      trace::tracer t(lens.sys), full(lens.sys);
+
+      for (trace::tracer *u : { &t, &full })
+        {
+          lens.init_tracer(*u);
+          u->get_trace_result().set_generated_save_state(lens.s1);
+        }
+
+      t.get_params().set_thread_count(threads);
+      t.get_params().set_pipelined_trace(true);
+      full.trace();
+
+      for (int i = 0; i < 2; i++)
+        {
+          t.trace();
+          compare(ref_rays, t.get_trace_result().get_intercepted(lens.image));
+          compare(full.get_trace_result().get_generated(lens.s1),
+                  t.get_trace_result().get_generated(lens.s1));
+        }
+
+      // rays are recycled as soon as traced by the last stage
+      size_t count = 0;
+
+      t.get_trace_result().clear_save_states();
+      t.get_trace_result().set_intercepted_sink(lens.image, [&](const trace::Ray &r) {
+          count++;
+        });
+      t.trace();
+
+      if (count != ref_rays.size())
+        fail(__LINE__ << ": " << count);
+    }
+
+  // rays storage does not depend on rays count in streaming mode
+  for (unsigned int density : { 200, 400 })
+    {
+      trace::tracer t(lens.sys);
+      size_t count = 0;
+
+      lens.init_tracer(t, 4);
+      t.get_params().set_pipelined_trace(true);
+      t.get_params().set_default_distribution(
+        trace::Distribution(trace::HexaPolarDist, density));
+
+      trace::Result &result = t.get_trace_result();
+
+      result.clear_save_states();
+      result.set_retain_capacity(true);
+      result.set_intercepted_sink(lens.image, [&](const trace::Ray &r) {
+          count++;
+        });
+
+      // largest rays count is updated when the result is cleared
+      t.trace();
+      t.trace();
+
+      // 3 stages linked by queues of 8 batches of 256 rays
+      size_t bound = 3 * (8 + 2) * 256 * 2;
+
+      if (count < 10 * bound)
+        fail(__LINE__ << ": " << count);
+
+      if (result.get_max_ray_count() > bound)
+        fail(__LINE__ << ": " << result.get_max_ray_count() << " " << bound);
+    }
+
+  return 0;
+}
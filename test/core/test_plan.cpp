@@ -0,0 +1,138 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#include "trace_fixture.hpp"
+
+#include <goptical/core/math/Transform>
+
+#include <goptical/core/sys/Element>
+#include <goptical/core/sys/Source>
+
+#include <goptical/core/trace/Plan>
+
+#include <goptical/core/Error>
+
+// check plan steps against enabled elements of the sequence
+static void check_steps(const sys::system &sys, const trace::Plan &plan,
+                        const std::vector<const sys::Element *> &elements)
+{
+  const std::vector<trace::Plan::step_s> &steps = plan.get_steps();
+
+  if (steps.size() != elements.size())
+    fail(__LINE__ << ": " << steps.size());
+
+  for (unsigned int i = 0; i < steps.size(); i++)
+    {
+      const trace::Plan::step_s &s = steps[i];
+
+      if (s._element != elements[i] ||
+          s._source != dynamic_cast<const sys::Source *>(elements[i]))
+        fail(__LINE__ << ": " << i);
+
+      if (s._previous != (i ? elements[i - 1] : 0))
+        fail(__LINE__ << ": " << i);
+
+      if (!s._previous)
+        continue;
+
+      math::Transform<3> t = sys.compose_transform(*s._previous, *s._element);
+      math::Vector3 p(1, 2, 3);
+
+      if (!(s._transform.transform(p) == t.transform(p)))
+        fail(__LINE__ << ": " << i);
+    }
+}
+
+int main()
+{
+  lens_s lens;
+
+  trace::Plan plan(lens.sys, lens.seq);
+
+  check_steps(lens.sys, plan, { &lens.source, &lens.s1, &lens.s2, &lens.image });
+
+  if (plan.get_entrance() != &lens.s1 || !plan.is_valid(lens.sys, lens.seq))
+    fail(__LINE__);
+
+  // disabled elements are skipped, entrance is kept
+  lens.s1.set_enable_state(false);
+
+  if (plan.is_valid(lens.sys, lens.seq))
+    fail(__LINE__);
+
+  trace::Plan plan2(lens.sys, lens.seq);
+
+  check_steps(lens.sys, plan2, { &lens.source, &lens.s2, &lens.image });
+
+  if (plan2.get_entrance() != &lens.s1 || !plan2.is_valid(lens.sys, lens.seq))
+    fail(__LINE__);
+
+  lens.s1.set_enable_state(true);
+
+  // element moves invalidate the plan
+  trace::Plan plan3(lens.sys, lens.seq);
+
+  lens.image.set_local_position(math::Vector3(0, 0, 3000));
+
+  if (plan3.is_valid(lens.sys, lens.seq))
+    fail(__LINE__);
+
+  trace::Plan plan4(lens.sys, lens.seq);
+
+  check_steps(lens.sys, plan4, { &lens.source, &lens.s1, &lens.s2, &lens.image });
+
+  // sequence changes invalidate the plan
+  trace::Sequence seq2(lens.sys);
+
+  if (!plan4.is_valid(lens.sys, seq2))
+    fail(__LINE__);
+
+  seq2.remove(2);
+
+  if (plan4.is_valid(lens.sys, seq2))
+    fail(__LINE__);
+
+  check_steps(lens.sys, trace::Plan(lens.sys, seq2), { &lens.source, &lens.s1, &lens.image });
+
+  // plan is only valid for the system it was built with
+  sys::system other;
+  sys::Image image2(math::Vector3(0, 0, 100), 60);
+
+  other.add(image2);
+
+  if (plan4.is_valid(other, lens.seq))
+    fail(__LINE__);
+
+  // element of another system is rejected
+  seq2.append(image2);
+
+  try {
+    trace::Plan p(lens.sys, seq2);
+    fail(__LINE__);
+  } catch (const Error &e) {
+  }
+
+  return 0;
+}
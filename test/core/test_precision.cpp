@@ -0,0 +1,86 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+#include "trace_fixture.hpp"
+
+#include <goptical/core/shape/Disk>
+
+int main()
+{
+  lens_s lens;
+
+  // image large enough for off axis fields
+  lens.image.set_shape(ref<shape::Disk>::create(300));
+
+  // on axis and off axis fields, source at infinity is far from surfaces
+  for (const math::Vector3 &dir : { math::Vector3(0, 0, 1), math::Vector3(0, 0.05, 1),
+                                    math::Vector3(0.03, -0.04, 1) })
+    for (unsigned int threads : { 1, 4 })
+      {
+        lens.source.set_local_direction(dir.normalized());
+
+        trace::tracer ref(lens.sys), t(lens.sys);
+
+        for (trace::tracer *u : { &ref, &t })
+          {
+            u->get_params().set_sequential_mode(lens.seq);
+            u->get_params().set_thread_count(threads);
+            u->get_params().set_default_distribution(
+              trace::Distribution(trace::HexaPolarDist, 20));
+            u->get_trace_result().set_intercepted_save_state(lens.image);
+          }
+
+        ref.trace();
+
+        const auto &ref_rays = ref.get_trace_result().get_intercepted(lens.image);
+
+        if (ref_rays.empty())
+          fail(__LINE__);
+
+        // single precision intersections
+        t.get_params().set_precision_mode(trace::CheckPrecision);
+        t.trace();
+
+        if (t.get_trace_result().get_precision_error() > 1e-3 ||
+            t.get_trace_result().get_precision_mismatch_count())
+          fail(__LINE__ << ": " << t.get_trace_result().get_precision_error()
+               << " " << t.get_trace_result().get_precision_mismatch_count());
+
+        t.get_params().set_precision_mode(trace::MixedPrecision);
+        t.trace();
+
+        const auto &rays = t.get_trace_result().get_intercepted(lens.image);
+
+        if (rays.size() != ref_rays.size())
+          fail(__LINE__ << ": " << rays.size() << " " << ref_rays.size());
+
+        for (size_t i = 0; i < rays.size(); i++)
+          if ((rays[i]->get_intercept_point() - ref_rays[i]->get_intercept_point()).len() > 1e-2)
+            fail(__LINE__ << ": " << rays[i]->get_intercept_point()
+                 << " " << ref_rays[i]->get_intercept_point());
+      }
+
+  return 0;
+}
+
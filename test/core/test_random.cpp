@@ -0,0 +1,136 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#include <iostream>
+
+#include <goptical/core/math/Vector>
+#include <goptical/core/math/Random>
+
+#include <goptical/core/shape/Base>
+#include <goptical/core/shape/Disk>
+#include <goptical/core/shape/Ring>
+#include <goptical/core/shape/RegularPolygon>
+
+#include <goptical/core/trace/Distribution>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+using namespace goptical;
+
+#define fail(x)                                 \
+{                                               \
+  std::cerr << x << std::endl;                  \
+  exit(1);                                      \
+}
+
+static std::vector<math::Vector2> get_points(const shape::Base &s,
+                                             trace::Pattern p, unsigned int seed)
+{
+  std::vector<math::Vector2> points;
+
+  s.get_pattern([&](const math::Vector2 &v) { points.push_back(v); },
+                trace::Distribution(p, 10, 0.999, seed));
+
+  return points;
+}
+
+static bool same_points(const std::vector<math::Vector2> &a,
+                        const std::vector<math::Vector2> &b)
+{
+  if (a.size() != b.size())
+    return false;
+
+  for (size_t i = 0; i < a.size(); i++)
+    if (!(a[i] == b[i]))
+      return false;
+
+  return true;
+}
+
+int main()
+{
+  // Philox4x32-10 known answer, zero counter and key
+  {
+    static const uint32_t kat[4] = { 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 };
+    uint32_t r[4];
+
+    math::Philox(0).get(0, r);
+
+    for (unsigned int i = 0; i < 4; i++)
+      if (r[i] != kat[i])
+        fail(__LINE__ << ": " << i << " " << std::hex << r[i]);
+  }
+
+  // uniform values are in [0, 1) and depend on the seed
+  {
+    double a, b, c, d;
+
+    math::Philox(1).get_uniform(5, a, b);
+    math::Philox(2).get_uniform(5, c, d);
+
+    if (a < 0 || a >= 1 || b < 0 || b >= 1 || (a == c && b == d))
+      fail(__LINE__);
+  }
+
+  shape::Disk disk(10);
+  shape::Ring ring(10, 3);
+  shape::RegularPolygon polygon(10, 6);
+
+  for (const shape::Base *s : { (const shape::Base *)&disk,
+                                (const shape::Base *)&ring,
+                                (const shape::Base *)&polygon })
+    for (trace::Pattern p : { trace::RandomDist, trace::SobolDist, trace::HaltonDist })
+      {
+        // round random pattern only covers the center of the shape
+        if (s == &ring && p == trace::RandomDist)
+          continue;
+
+        std::vector<math::Vector2> a = get_points(*s, p, 1);
+
+        if (a.size() < 5)
+          fail(__LINE__ << ": " << a.size());
+
+        // same seed gives same points
+        if (!same_points(a, get_points(*s, p, 1)))
+          fail(__LINE__ << ": " << p);
+
+        // different seeds give different points
+        if (same_points(a, get_points(*s, p, 2)))
+          fail(__LINE__ << ": " << p);
+      }
+
+  // disk patterns start with the chief ray point
+  for (trace::Pattern p : { trace::RandomDist, trace::SobolDist, trace::HaltonDist })
+    {
+      std::vector<math::Vector2> a = get_points(disk, p, 3);
+
+      if (!(a[0] == math::vector2_0))
+        fail(__LINE__ << ": " << p << " " << a[0]);
+    }
+
+  return 0;
+}
@@ -0,0 +1,93 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#include "trace_fixture.hpp"
+
+#include <goptical/core/trace/RayArena>
+
+int main()
+{
+  // rays spliced between arenas keep their address
+  trace::RayArena a1, a2;
+
+  for (unsigned int i = 0; i < trace::RayArena::block_size + 10; i++)
+    a1.create().set_intensity(1.);
+
+  trace::Ray &r2 = a2.create();
+  r2.set_intensity(2.);
+
+  a1.splice(a2);
+  a1.create().set_intensity(3.);
+
+  if (a1.size() != trace::RayArena::block_size + 12 || !a2.empty())
+    fail(__LINE__);
+
+  double sum = 0;
+
+  for (auto &r : a1)
+    sum += r.get_intensity();
+
+  if (sum != trace::RayArena::block_size + 15 || r2.get_intensity() != 2.)
+    fail(__LINE__);
+
+  // rays created after a mark are dropped on truncate
+  trace::RayArena::mark_s mark = a1.get_mark();
+
+  for (unsigned int i = 0; i < trace::RayArena::block_size; i++)
+    a1.create();
+
+  a1.truncate(mark);
+
+  if (a1.size() != trace::RayArena::block_size + 12)
+    fail(__LINE__);
+
+  // storage is kept when cleared
+  a1.clear();
+
+  if (!a1.empty() || a1.capacity() < trace::RayArena::block_size + 12)
+    fail(__LINE__);
+
+  // rays of threads arenas are spliced in the result
+  lens_s lens;
+
+  for (unsigned int threads : { 1, 4 })
+    {
+      trace::tracer t(lens.sys);
+      lens.init_tracer(t, threads);
+      t.get_trace_result().set_generated_save_state(lens.source);
+      t.trace();
+
+      const auto &generated = t.get_trace_result().get_generated(lens.source);
+
+      if (generated.empty())
+        fail(__LINE__);
+
+      for (const trace::Ray *r : generated)
+        if (r->get_creator() != &lens.source)
+          fail(__LINE__);
+    }
+
+  return 0;
+}
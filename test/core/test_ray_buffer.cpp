@@ -0,0 +1,119 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#include <iostream>
+
+#include <goptical/core/trace/RayBuffer>
+#include <goptical/core/trace/Ray>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+using namespace goptical;
+
+#define fail(x)                                 \
+{                                               \
+  std::cerr << x << std::endl;                  \
+  exit(1);                                      \
+}
+
+int main()
+{
+  std::vector<trace::Ray> rays(8);
+  trace::RayBuffer buf;
+
+  if (!buf.empty() || buf.size())
+    fail(__LINE__);
+
+  buf.reserve(8);
+
+  for (unsigned int i = 0; i < 4; i++)
+    buf.push_back(&rays[i]);
+
+  if (buf.size() != 4 || buf.front() != &rays[0] || buf.back() != &rays[3])
+    fail(__LINE__);
+
+  trace::Ray * const *storage = &*buf.begin();
+
+  // first in first out
+  buf.pop_front();
+
+  if (buf.size() != 3 || buf.front() != &rays[1] || buf[0] != &rays[1] ||
+      *buf.begin() != &rays[1])
+    fail(__LINE__);
+
+  buf.push_back(&rays[4]);
+
+  unsigned int n = 1;
+
+  for (trace::Ray *r : buf)
+    if (r != &rays[n++])
+      fail(__LINE__);
+
+  if (n != 5)
+    fail(__LINE__);
+
+  while (!buf.empty())
+    buf.pop_front();
+
+  // storage of popped entries is reused once the buffer is empty
+  buf.push_back(&rays[5]);
+
+  if (buf.size() != 1 || &*buf.begin() != storage)
+    fail(__LINE__);
+
+  std::vector<trace::Ray *> list;
+
+  for (auto &r : rays)
+    list.push_back(&r);
+
+  buf.append(list.begin(), list.begin() + 3);
+
+  if (buf.size() != 4 || buf[1] != &rays[0] || buf.back() != &rays[2])
+    fail(__LINE__);
+
+  buf.assign(list.begin() + 2, list.end());
+
+  if (buf.size() != 6 || buf.front() != &rays[2] || buf.back() != &rays[7])
+    fail(__LINE__);
+
+  const trace::RayBuffer &cbuf = buf;
+
+  if (cbuf.end() - cbuf.begin() != 6)
+    fail(__LINE__);
+
+  buf.clear();
+
+  if (!buf.empty())
+    fail(__LINE__);
+
+  buf.push_back(&rays[0]);
+
+  if (&*buf.begin() != storage)
+    fail(__LINE__);
+
+  return 0;
+}
@@ -0,0 +1,158 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#include <iostream>
+#include <vector>
+
+#include <goptical/core/math/Vector>
+#include <goptical/core/math/VectorPair>
+
+#include <goptical/core/sys/System>
+#include <goptical/core/sys/SourceRayFile>
+#include <goptical/core/sys/Image>
+
+#include <goptical/core/trace/Tracer>
+#include <goptical/core/trace/Result>
+#include <goptical/core/trace/Ray>
+#include <goptical/core/trace/Sequence>
+#include <goptical/core/trace/Params>
+
+#include <goptical/core/light/Ray>
+
+#include <goptical/core/Error>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace goptical;
+
+#define fail(x)                                 \
+{                                               \
+  std::cerr << x << std::endl;                  \
+  exit(1);                                      \
+}
+
+static const char *filename = "test_ray_file.bin";
+
+int main()
+{
+  // rays streamed from a memory mapped file
+  {
+    std::vector<light::Ray> rays;
+
+    for (int i = 0; i < 10000; i++)
+      rays.push_back(light::Ray(math::VectorPair3(math::Vector3(i % 100 - 50, i / 100 - 50, 0),
+                                                  math::vector3_001),
+                                .5, i < 5000 ? 486.1327 : 656.2725));
+
+    sys::SourceRayFile::write(filename, rays);
+
+    sys::system sys;
+    sys::SourceRayFile file_source(filename, math::Vector3(0, 0, -10));
+    sys::Image image(math::Vector3(0, 0, 100), 200);
+
+    sys.add(file_source);
+    sys.add(image);
+
+    trace::Sequence seq(sys);
+
+    if (file_source.get_ray_count() != rays.size())
+      fail(__LINE__);
+
+    for (unsigned int threads : { 1, 4 })
+      {
+        trace::tracer t(sys);
+        t.get_params().set_sequential_mode(seq);
+        t.get_params().set_thread_count(threads);
+        t.get_trace_result().set_intercepted_save_state(image);
+        t.trace();
+
+        const auto &hits = t.get_trace_result().get_intercepted(image);
+
+        if (hits.size() != rays.size())
+          fail(__LINE__ << ": " << hits.size());
+
+        for (size_t i = 0; i < hits.size(); i++)
+          if (hits[i]->get_intercept_point().x() != rays[i].origin().x() ||
+              hits[i]->get_wavelen() != (float)rays[i].get_wavelen())
+            fail(__LINE__);
+      }
+  }
+
+  // many interleaved wavelens, each ray refers to its wavelen index
+  {
+    std::vector<light::Ray> rays;
+
+    for (int i = 0; i < 20000; i++)
+      rays.push_back(light::Ray(math::VectorPair3(math::Vector3(0, 0, 0), math::vector3_001),
+                                1., 400. + (i * 7919) % 3000 * .1));
+
+    sys::SourceRayFile::write(filename, rays);
+
+    sys::system sys;
+    sys::SourceRayFile file_source(filename);
+    sys::Image image(math::Vector3(0, 0, 100), 10);
+
+    sys.add(file_source);
+    sys.add(image);
+
+    trace::tracer t(sys);
+    t.get_trace_result().set_intercepted_save_state(image);
+    t.trace();
+
+    const trace::Result &result = t.get_trace_result();
+    const auto &hits = result.get_intercepted(image);
+
+    if (hits.size() != rays.size() || result.get_ray_wavelen_set().size() != 3000)
+      fail(__LINE__ << ": " << hits.size());
+
+    for (auto r : hits)
+      if (r->get_wavelen_index() == trace::Ray::no_wavelen_index ||
+          r->get_wavelen_index() != result.get_ray_wavelen_index(r->get_wavelen()))
+        fail(__LINE__ << ": " << r->get_wavelen());
+  }
+
+  // wavelens count exceeds ray wavelen index range
+  {
+    std::vector<light::Ray> rays;
+
+    for (unsigned int i = 0; i < trace::Ray::no_wavelen_index; i++)
+      rays.push_back(light::Ray(math::VectorPair3(math::Vector3(0, 0, 0), math::vector3_001),
+                                1., 400. + i * .001));
+
+    sys::SourceRayFile::write(filename, rays);
+
+    try {
+      sys::SourceRayFile file_source(filename);
+      fail(__LINE__);
+    } catch (const Error &e) {
+    }
+  }
+
+  remove(filename);
+
+  return 0;
+}
+
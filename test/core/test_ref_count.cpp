@@ -0,0 +1,52 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#include "trace_fixture.hpp"
+
+#include <vector>
+#include <thread>
+
+int main()
+{
+  lens_s lens;
+
+  // material references copied and dropped from several threads
+  int count = const_ref<material::Base>(lens.bk7).count();
+  std::vector<std::thread> workers;
+
+  for (int i = 0; i < 4; i++)
+    workers.push_back(std::thread([&]() {
+          for (int j = 0; j < 100000; j++)
+            const_ref<material::Base> r(lens.s1.get_material(1));
+        }));
+
+  for (auto &w : workers)
+    w.join();
+
+  if (const_ref<material::Base>(lens.bk7).count() != count)
+    fail(__LINE__);
+
+  return 0;
+}
@@ -0,0 +1,136 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#include <iostream>
+
+#include <goptical/core/math/Vector>
+#include <goptical/core/math/VectorPair>
+
+#include <goptical/core/sys/System>
+#include <goptical/core/sys/OpticalSurface>
+#include <goptical/core/sys/SourcePoint>
+#include <goptical/core/sys/Image>
+
+#include <goptical/core/trace/Tracer>
+#include <goptical/core/trace/Result>
+#include <goptical/core/trace/Ray>
+#include <goptical/core/trace/Distribution>
+#include <goptical/core/trace/Sequence>
+#include <goptical/core/trace/Params>
+
+#include <goptical/core/light/SpectralLine>
+#include <goptical/core/light/Ray>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <memory>
+#include <vector>
+
+using namespace goptical;
+
+#define fail(x)                                 \
+{                                               \
+  std::cerr << x << std::endl;                  \
+  exit(1);                                      \
+}
+
+int main()
+{
+  sys::system sys;
+
+  sys::SourcePoint source(sys::SourceAtInfinity, math::vector3_001);
+  sys::SourcePoint near_source(sys::SourceAtFiniteDistance, math::Vector3(0, 0, -100));
+  sys::Image image(math::Vector3(0, 0, 100), 60);
+
+  sys.add(source);
+  sys.add(near_source);
+  sys.add(image);
+
+  const double wavelens[] = { light::SpectralLine::C, light::SpectralLine::e,
+                              light::SpectralLine::F };
+
+  for (sys::SourcePoint *s : { &source, &near_source })
+    {
+      s->clear_spectrum();
+      for (double w : wavelens)
+        s->add_spectral_line(light::SpectralLine(w));
+    }
+
+  // pattern sizes around and above the source batch size
+  for (unsigned int density : { 5, 10, 20, 40 })
+    for (sys::SourcePoint *s : { &source, &near_source })
+      {
+        trace::Distribution dist(trace::HexaPolarDist, density);
+
+        std::shared_ptr<const std::vector<math::Vector3> > pattern =
+          image.get_pattern(dist);
+
+        trace::Sequence seq;
+        seq.append(*s);
+        seq.append(image);
+
+        trace::tracer t(sys);
+        t.get_params().set_sequential_mode(seq);
+        t.get_params().set_default_distribution(dist);
+        t.get_trace_result().set_generated_save_state(*s);
+        t.trace();
+
+        const auto &generated = t.get_trace_result().get_generated(*s);
+
+        // all spectral lines of a pattern point are emitted in a row
+        if (generated.size() != pattern->size() * 3)
+          fail(__LINE__ << ": " << generated.size() << " " << pattern->size());
+
+        for (size_t i = 0; i < pattern->size(); i++)
+          for (unsigned int j = 0; j < 3; j++)
+            {
+              const trace::Ray *r = generated[i * 3 + j];
+              math::Vector3 p = image.get_transform_to(*s).transform((*pattern)[i]);
+
+              if (r->get_wavelen() != wavelens[j] || r->get_creator() != s ||
+                  r->get_intensity() != 1.0)
+                fail(__LINE__);
+
+              if (s == &source)
+                {
+                  // rays from infinity are parallel to the source axis
+                  if (!(r->direction() == math::vector3_001) ||
+                      fabs(r->origin().x() - p.x()) > 1e-9 ||
+                      fabs(r->origin().y() - p.y()) > 1e-9)
+                    fail(__LINE__ << ": " << r->origin() << " " << p);
+                }
+              else
+                {
+                  // rays from a point source aim at pattern points
+                  if (!(r->origin() == math::vector3_0) ||
+                      (r->direction() - p.normalized()).len() > 1e-12)
+                    fail(__LINE__ << ": " << r->direction() << " " << p);
+                }
+            }
+      }
+
+  return 0;
+}
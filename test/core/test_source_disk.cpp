@@ -0,0 +1,84 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#include "trace_fixture.hpp"
+
+#include <goptical/core/sys/SourceDisk>
+
+#include <math.h>
+
+int main()
+{
+  // extended source at finite distance
+  sys::system sys;
+  sys::SourceDisk source(sys::SourceAtFiniteDistance, math::Vector3(0, 0, -10),
+                         math::Vector2(4, 2));
+  sys::Image image(math::Vector3(0, 0, 100), 20);
+
+  sys.add(source);
+  sys.add(image);
+
+  source.set_angular_distribution([](double a) { return cos(a); });
+
+  trace::Sequence seq(sys);
+  trace::tracer ref(sys);
+  ref.get_params().set_sequential_mode(seq);
+  ref.get_params().set_default_distribution(trace::Distribution(trace::HexaPolarDist, 10));
+  ref.get_trace_result().set_generated_save_state(source);
+  ref.get_trace_result().set_intercepted_save_state(image);
+  ref.trace();
+
+  const auto &generated = ref.get_trace_result().get_generated(source);
+
+  if (generated.size() != 20 * 20)
+    fail(__LINE__ << ": " << generated.size());
+
+  for (auto r : generated)
+    {
+      math::Vector3 o = r->origin();
+      math::Vector3 d = r->direction();
+
+      if (o.x() * o.x() / 4 + o.y() * o.y() > 1 + 1e-12 || o.z() != 0)
+        fail(__LINE__);
+
+      if (fabs(r->get_intensity() - d.z()) > 1e-12)
+        fail(__LINE__);
+    }
+
+  if (ref.get_trace_result().get_intercepted(image).empty())
+    fail(__LINE__);
+
+  trace::tracer t(sys);
+  t.get_params().set_sequential_mode(seq);
+  t.get_params().set_thread_count(4);
+  t.get_params().set_default_distribution(trace::Distribution(trace::HexaPolarDist, 10));
+  t.get_trace_result().set_intercepted_save_state(image);
+  t.trace();
+
+  compare(ref.get_trace_result().get_intercepted(image),
+          t.get_trace_result().get_intercepted(image));
+
+  return 0;
+}
@@ -0,0 +1,147 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#include <iostream>
+#include <vector>
+
+#include <goptical/core/math/Vector>
+#include <goptical/core/math/VectorPair>
+
+#include <goptical/core/material/Base>
+#include <goptical/core/material/Sellmeier>
+
+#include <goptical/core/sys/System>
+#include <goptical/core/sys/OpticalSurface>
+#include <goptical/core/sys/SourceRays>
+#include <goptical/core/sys/Image>
+
+#include <goptical/core/trace/Tracer>
+#include <goptical/core/trace/Result>
+#include <goptical/core/trace/Ray>
+#include <goptical/core/trace/Sequence>
+#include <goptical/core/trace/Params>
+
+#include <goptical/core/light/Ray>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace goptical;
+
+#define fail(x)                                 \
+{                                               \
+  std::cerr << x << std::endl;                  \
+  exit(1);                                      \
+}
+
+int main()
+{
+  // wavelens are indexed in declaration order
+  {
+    trace::Result result;
+
+    if (result.add_ray_wavelen(500.) != 0 ||
+        result.add_ray_wavelen(600.) != 1 ||
+        result.add_ray_wavelen(500.) != 0 ||
+        result.get_ray_wavelen_index(600.) != 1 ||
+        result.get_ray_wavelen_index(700.) != trace::Ray::no_wavelen_index)
+      fail(__LINE__);
+
+    // out of index range wavelens are declared but not indexed
+    for (unsigned int i = 2; i < trace::Ray::no_wavelen_index; i++)
+      if (result.add_ray_wavelen(1000. + i) != i)
+        fail(__LINE__ << ": " << i);
+
+    if (result.add_ray_wavelen(100.) != trace::Ray::no_wavelen_index ||
+        result.get_ray_wavelen_index(100.) != trace::Ray::no_wavelen_index ||
+        result.get_ray_wavelen_set().size() != trace::Ray::no_wavelen_index + 1)
+      fail(__LINE__);
+  }
+
+  // rays of interleaved wavelens refract as rays traced alone
+  {
+    material::Sellmeier bk7(1.03961212, 6.00069867e-3, 0.231792344,
+                            2.00179144e-2, 1.01046945, 1.03560653e2);
+
+    sys::system sys;
+    sys::SourceRays source(math::Vector3(0, 0, -10));
+    sys::OpticalSurface s1(math::Vector3(0, 0, 0), 200, 30, material::none, bk7);
+    sys::OpticalSurface s2(math::Vector3(0, 0, 5), -200, 30, bk7, material::none);
+    sys::Image image(math::Vector3(0, 0, 200), 100);
+
+    sys.add(source);
+    sys.add(s1);
+    sys.add(s2);
+    sys.add(image);
+
+    trace::Sequence seq(sys);
+    const double wavelens[3] = { 486.1327, 587.5618, 656.2725 };
+    std::vector<light::Ray> rays;
+
+    for (int i = 0; i < 30; i++)
+      rays.push_back(light::Ray(math::VectorPair3(math::Vector3(0, i - 15, 0), math::vector3_001),
+                                1., wavelens[i % 3]));
+
+    for (auto &r : rays)
+      source.add_ray(r, &source);
+
+    trace::tracer t(sys);
+    t.get_params().set_sequential_mode(seq);
+    t.get_trace_result().set_intercepted_save_state(image);
+    t.trace();
+
+    const trace::Result &result = t.get_trace_result();
+    const auto &hits = result.get_intercepted(image);
+
+    if (hits.size() != rays.size())
+      fail(__LINE__ << ": " << hits.size());
+
+    for (size_t i = 0; i < hits.size(); i++)
+      {
+        const trace::Ray &r = *hits[i];
+
+        if (r.get_wavelen_index() != result.get_ray_wavelen_index(r.get_wavelen()) ||
+            r.get_wavelen_index() == trace::Ray::no_wavelen_index)
+          fail(__LINE__);
+
+        source.clear_rays();
+        source.add_ray(rays[i], &source);
+
+        trace::tracer t1(sys);
+        t1.get_params().set_sequential_mode(seq);
+        t1.get_trace_result().set_intercepted_save_state(image);
+        t1.trace();
+
+        const auto &hit = t1.get_trace_result().get_intercepted(image);
+
+        if (hit.size() != 1 || hit[0]->get_wavelen() != r.get_wavelen() ||
+            !(hit[0]->get_intercept_point() == r.get_intercept_point()))
+          fail(__LINE__ << ": " << i);
+      }
+  }
+
+  return 0;
+}
+
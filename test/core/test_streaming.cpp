@@ -0,0 +1,163 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#include "trace_fixture.hpp"
+
+#include <goptical/core/Error>
+
+#include <vector>
+#include <algorithm>
+
+typedef std::vector<math::Vector3> points_t;
+
+static bool point_less(const math::Vector3 &a, const math::Vector3 &b)
+{
+  for (unsigned int i = 0; i < 3; i++)
+    if (a[i] != b[i])
+      return a[i] < b[i];
+  return false;
+}
+
+// check that the same points were intercepted, in any order
+static void compare_points(points_t a, points_t b)
+{
+  if (a.size() != b.size())
+    fail(__LINE__ << ": " << a.size() << " " << b.size());
+
+  std::sort(a.begin(), a.end(), point_less);
+  std::sort(b.begin(), b.end(), point_less);
+
+  for (size_t i = 0; i < a.size(); i++)
+    if (!(a[i] == b[i]))
+      fail(__LINE__ << ": " << a[i] << " " << b[i]);
+}
+
+int main()
+{
+  lens_s lens;
+
+  for (bool nonseq : { false, true })
+    for (unsigned int threads : { 0, 1, 4 })
+      {
+        trace::tracer ref_tracer(lens.sys), t(lens.sys);
+
+        for (trace::tracer *u : { &ref_tracer, &t })
+          {
+            u->get_params().set_sequential_mode(lens.seq);
+            u->get_params().set_thread_count(threads);
+            u->get_params().set_default_distribution(
+              trace::Distribution(trace::HexaPolarDist, 100));
+
+            if (nonseq)
+              u->get_params().set_nonsequential_mode();
+          }
+
+        ref_tracer.get_trace_result().set_intercepted_save_state(lens.s2);
+        ref_tracer.get_trace_result().set_intercepted_save_state(lens.image);
+        ref_tracer.trace();
+
+        points_t ref_s2, ref_image;
+
+        for (auto r : ref_tracer.get_trace_result().get_intercepted(lens.s2))
+          ref_s2.push_back(r->get_intercept_point());
+
+        for (auto r : ref_tracer.get_trace_result().get_intercepted(lens.image))
+          ref_image.push_back(r->get_intercept_point());
+
+        if (ref_image.empty())
+          fail(__LINE__);
+
+        // sinks get the rays which would have been saved
+        points_t sink_s2, sink_image;
+        trace::Result &result = t.get_trace_result();
+
+        if (result.is_streaming())
+          fail(__LINE__);
+
+        result.set_intercepted_sink(lens.s2, [&](const trace::Ray &r) {
+            if (r.get_parent() || r.get_first_child())
+              fail(__LINE__);
+            sink_s2.push_back(r.get_intercept_point());
+          });
+
+        result.set_intercepted_sink(lens.image, [&](const trace::Ray &r) {
+            sink_image.push_back(r.get_intercept_point());
+          });
+
+        if (!result.is_streaming())
+          fail(__LINE__);
+
+        for (int i = 0; i < 2; i++)
+          {
+            sink_s2.clear();
+            sink_image.clear();
+            t.trace();
+            compare_points(ref_s2, sink_s2);
+            compare_points(ref_image, sink_image);
+          }
+
+        // recycled rays are not walked
+        for (int i = 0; i < 2; i++)
+          {
+            try {
+              result.get_max_ray_intensity();
+              fail(__LINE__);
+            } catch (const Error &e) {
+            }
+
+            // recycled rays are still in the result
+            result.clear_sinks();
+          }
+
+        result.set_intercepted_sink(lens.image, [&](const trace::Ray &r) {
+            sink_image.push_back(r.get_intercept_point());
+          });
+
+        // rays lists can not be saved in streaming mode
+        result.set_intercepted_save_state(lens.image);
+
+        try {
+          t.trace();
+          fail(__LINE__);
+        } catch (const Error &e) {
+        }
+
+        // back to regular mode
+        result.clear_sinks();
+
+        if (result.is_streaming())
+          fail(__LINE__);
+
+        sink_image.clear();
+        t.trace();
+
+        if (!sink_image.empty() ||
+            result.get_intercepted(lens.image).size() != ref_image.size() ||
+            result.get_max_ray_intensity() != 1.0)
+          fail(__LINE__);
+      }
+
+  return 0;
+}
@@ -0,0 +1,175 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <memory>
+
+#include <goptical/core/math/Vector>
+#include <goptical/core/math/VectorPair>
+#include <goptical/core/math/Transform>
+
+#include <goptical/core/material/Base>
+
+#include <goptical/core/sys/System>
+#include <goptical/core/sys/OpticalSurface>
+#include <goptical/core/sys/SourcePoint>
+#include <goptical/core/sys/Image>
+
+#include <goptical/core/trace/Tracer>
+#include <goptical/core/trace/Result>
+#include <goptical/core/trace/Distribution>
+#include <goptical/core/trace/Params>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace goptical;
+
+#define fail(x)                                 \
+{                                               \
+  std::cerr << x << std::endl;                  \
+  exit(1);                                      \
+}
+
+// get number of cached pair transforms from cache dump
+static unsigned int pair_count(const sys::system &sys)
+{
+  std::ostringstream o;
+  sys.transform_cache_dump(o);
+
+  std::string s(o.str());
+  size_t e = s.find(" pairs");
+  size_t b = s.rfind(' ', e - 1);
+
+  return atoi(s.substr(b + 1, e - b - 1).c_str());
+}
+
+static bool same_transform(const math::Transform<3> &a, const math::Transform<3> &b)
+{
+  math::Vector3 p(1., 2., 3.);
+
+  return (a.transform(p) - b.transform(p)).len() < 1e-9 &&
+    (a.transform_linear(p) - b.transform_linear(p)).len() < 1e-9;
+}
+
+int main()
+{
+  static const unsigned int count = 200;
+
+  sys::system sys;
+  sys::SourcePoint source(sys::SourceAtInfinity, math::vector3_001);
+  std::vector<std::unique_ptr<sys::OpticalSurface> > surfaces;
+  sys::Image image(math::Vector3(0, 0, count * 10 + 10), 60);
+
+  sys.add(source);
+
+  for (unsigned int i = 0; i < count; i++)
+    {
+      surfaces.emplace_back(new sys::OpticalSurface(math::Vector3(0, 0, i * 10), 0, 50,
+                                                    material::none, material::none));
+      sys.add(*surfaces.back());
+    }
+
+  sys.add(image);
+  sys.set_entrance_pupil(*surfaces[0]);
+  sys.get_tracer_params().set_max_bounce(count + 10);
+
+  // frozen system only caches pairs involving sources
+  sys.freeze();
+
+  unsigned int frozen_pairs = pair_count(sys);
+
+  if (frozen_pairs > 2 * (count + 1))
+    fail(__LINE__ << ": " << frozen_pairs);
+
+  trace::tracer ref_tracer(sys);
+  ref_tracer.get_params().set_default_distribution(trace::Distribution(trace::HexaPolarDist, 10));
+  ref_tracer.get_trace_result().set_intercepted_save_state(image);
+  ref_tracer.trace();
+
+  size_t ref_count = ref_tracer.get_trace_result().get_intercepted(image).size();
+
+  if (!ref_count)
+    fail(__LINE__);
+
+  for (unsigned int threads : { 0, 4 })
+    {
+      trace::tracer t(sys);
+      t.get_params().set_thread_count(threads);
+      t.get_params().set_default_distribution(trace::Distribution(trace::HexaPolarDist, 10));
+      t.get_trace_result().set_intercepted_save_state(image);
+      t.trace();
+
+      if (t.get_trace_result().get_intercepted(image).size() != ref_count)
+        fail(__LINE__);
+    }
+
+  // tracing a frozen system does not populate the pairs cache
+  if (pair_count(sys) != frozen_pairs)
+    fail(__LINE__ << ": " << pair_count(sys));
+
+  // composed and cached pair transforms match
+  sys::OpticalSurface &a = *surfaces[10];
+  sys::OpticalSurface &b = *surfaces[20];
+  sys::OpticalSurface &c = *surfaces[30];
+
+  if (!same_transform(sys.get_transform(a, b), sys.compose_transform(a, b)) ||
+      !same_transform(sys.get_transform(b, c), sys.compose_transform(b, c)) ||
+      !same_transform(sys.get_transform(c, a), sys.compose_transform(c, a)))
+    fail(__LINE__);
+
+  unsigned int pairs = pair_count(sys);
+
+  // moving an element only flushes pairs it is involved in
+  b.set_local_position(math::Vector3(1, 2, 205));
+
+  // source to b, b to source, a to b and b to c
+  if (pair_count(sys) != pairs - 4)
+    fail(__LINE__ << ": " << pair_count(sys) << " " << pairs);
+
+  if (!same_transform(sys.get_transform(c, a), sys.compose_transform(c, a)))
+    fail(__LINE__);
+
+  if (!same_transform(sys.get_transform(a, b), sys.compose_transform(a, b)) ||
+      (sys.get_transform(a, b).transform(math::vector3_0) -
+       math::Vector3(-1, -2, -105)).len() > 1e-9)
+    fail(__LINE__ << ": " << sys.get_transform(a, b).transform(math::vector3_0));
+
+  // removed element pairs are flushed too
+  pairs = pair_count(sys);
+  sys.remove(c);
+
+  // source to c, c to source and c to a
+  if (pair_count(sys) != pairs - 3)
+    fail(__LINE__ << ": " << pair_count(sys) << " " << pairs);
+
+  if (!same_transform(sys.get_transform(a, b), sys.compose_transform(a, b)))
+    fail(__LINE__);
+
+  return 0;
+}
+
@@ -0,0 +1,81 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#include "trace_fixture.hpp"
+
+#include <goptical/core/curve/Sphere>
+
+// user curve class, must not use built-in sphere functions
+class UserSphere : public curve::Sphere
+{
+public:
+  UserSphere(double roc)
+    : curve::Sphere(roc),
+      _normal_count(0)
+  {
+  }
+
+  void normal(math::Vector3 &normal, const math::Vector3 &point) const
+  {
+    _normal_count++;
+    curve::Sphere::normal(normal, point);
+  }
+
+  mutable unsigned int _normal_count;
+};
+
+int main()
+{
+  lens_s lens;
+
+  trace::tracer ref_tracer(lens.sys);
+  lens.init_tracer(ref_tracer);
+  ref_tracer.trace();
+
+  const auto &ref_rays =
+    ref_tracer.get_trace_result().get_intercepted(lens.image);
+
+  if (ref_rays.empty())
+    fail(__LINE__);
+
+  // user curve subclass uses virtual functions
+  ref<UserSphere> c = ref<UserSphere>::create(2009.753);
+  lens.s1.set_curve(c);
+
+  trace::tracer t(lens.sys);
+  lens.init_tracer(t);
+  t.trace();
+  compare(ref_rays, t.get_trace_result().get_intercepted(lens.image));
+
+  if (!c->_normal_count)
+    fail(__LINE__);
+
+  // back to built-in curve
+  lens.s1.set_curve(ref<curve::Sphere>::create(2009.753));
+  t.trace();
+  compare(ref_rays, t.get_trace_result().get_intercepted(lens.image));
+
+  return 0;
+}
@@ -0,0 +1,126 @@
+/*
+
+      This file is part of the <goptical/core Core library.
+  
+      The <goptical/core library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The <goptical/core library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the <goptical/core library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+#ifndef GOPTICAL_TEST_TRACE_FIXTURE_HH_
+#define GOPTICAL_TEST_TRACE_FIXTURE_HH_
+
+#include <iostream>
+
+#include <goptical/core/math/Vector>
+#include <goptical/core/math/VectorPair>
+
+#include <goptical/core/material/Base>
+#include <goptical/core/material/Sellmeier>
+
+#include <goptical/core/sys/System>
+#include <goptical/core/sys/OpticalSurface>
+#include <goptical/core/sys/SourcePoint>
+#include <goptical/core/sys/Image>
+
+#include <goptical/core/trace/Tracer>
+#include <goptical/core/trace/Result>
+#include <goptical/core/trace/Ray>
+#include <goptical/core/trace/Distribution>
+#include <goptical/core/trace/Sequence>
+#include <goptical/core/trace/Params>
+
+#include <goptical/core/light/SpectralLine>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace goptical;
+
+#define fail(x)                                 \
+{                                               \
+  std::cerr << x << std::endl;                  \
+  exit(1);                                      \
+}
+
+// single lens with a source at infinity, image plane near focus
+struct lens_s
+{
+  lens_s()
+    : sys(),
+      bk7(1.03961212, 6.00069867e-3, 0.231792344,
+          2.00179144e-2, 1.01046945, 1.03560653e2),
+      source(sys::SourceAtInfinity, math::vector3_001),
+      s1(math::Vector3(0, 0, 0), 2009.753, 100, material::none, bk7),
+      s2(math::Vector3(0, 0, 31.336), -976.245, 100, bk7, material::none),
+      image(math::Vector3(0, 0, 3014.5), 60),
+      seq()
+  {
+    sys.add(source);
+    sys.add(s1);
+    sys.add(s2);
+    sys.add(image);
+
+    source.clear_spectrum();
+    source.add_spectral_line(light::SpectralLine::C);
+    source.add_spectral_line(light::SpectralLine::e);
+    source.add_spectral_line(light::SpectralLine::F);
+
+    seq.add(sys);
+  }
+
+  // sequential trace of a hexapolar pattern, image rays are saved
+  void init_tracer(trace::tracer &t, unsigned int threads = 1) const
+  {
+    t.get_params().set_sequential_mode(seq);
+    t.get_params().set_thread_count(threads);
+    t.get_params().set_default_distribution(
+      trace::Distribution(trace::HexaPolarDist, 100));
+    t.get_trace_result().set_intercepted_save_state(image);
+  }
+
+  sys::system sys;
+  material::Sellmeier bk7;
+  sys::SourcePoint source;
+  sys::OpticalSurface s1;
+  sys::OpticalSurface s2;
+  sys::Image image;
+  trace::Sequence seq;
+};
+
+// check that rays intercepted on image are the same, in the same order
+template <class Queue>
+static void compare(const Queue &a, const Queue &b)
+{
+  if (a.size() != b.size())
+    fail(__LINE__ << ": " << a.size() << " " << b.size());
+
+  typename Queue::const_iterator i = a.begin(), j = b.begin();
+
+  for (; i != a.end(); ++i, ++j)
+    {
+      if (!((*i)->get_intercept_point() == (*j)->get_intercept_point()))
+        fail(__LINE__ << ": " << (*i)->get_intercept_point()
+             << " " << (*j)->get_intercept_point());
+
+      if ((*i)->get_wavelen() != (*j)->get_wavelen())
+        fail(__LINE__);
+    }
+}
+
+#endif